@@ -0,0 +1,312 @@
+#include "tinyrobotics_c.h"
+
+#include <memory>
+#include <string>
+
+#include "../include/dispatch.hpp"
+#include "../include/dynamics.hpp"
+#include "../include/kinematics.hpp"
+#include "../include/parser.hpp"
+
+using namespace tinyrobotics;
+
+namespace {
+
+    /// @brief Message of the last error on each thread.
+    thread_local std::string last_error;
+
+    /**
+     * @brief A tinyrobotics model whose number of configuration coordinates is only known at runtime. Each instance
+     * owns a copy of the model and so its pre-allocated buffers.
+     */
+    struct ModelBase {
+        virtual ~ModelBase()                                                                        = default;
+        virtual std::unique_ptr<ModelBase> clone() const                                            = 0;
+        virtual int n_q() const                                                                     = 0;
+        virtual int n_links() const                                                                 = 0;
+        virtual int base_link_idx() const                                                           = 0;
+        virtual int link_index(const std::string& name) const                                       = 0;
+        virtual void forward_kinematics(size_t n, const double* q, int target, int source, double* H) = 0;
+        virtual void jacobian(size_t n, const double* q, int target, int source, ReferenceFrame frame, double* J) = 0;
+        virtual void forward_dynamics(size_t n, const double* q, const double* dq, const double* tau, double* ddq) = 0;
+        virtual void inverse_dynamics(size_t n, const double* q, const double* dq, const double* ddq, double* tau) = 0;
+        virtual void mass_matrix(size_t n, const double* q, double* M) = 0;
+    };
+
+    /**
+     * @brief Implementation of ModelBase for a fixed number of configuration coordinates.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <int nq>
+    struct ModelImpl : ModelBase {
+        using Configuration = Eigen::Matrix<double, nq, 1>;
+        using ConstMap      = Eigen::Map<const Configuration>;
+        // Jacobians are stored row major, Eigen requires single column matrices to be column major
+        using JacobianMap   = Eigen::Map<Eigen::Matrix<double, 6, nq, nq == 1 ? Eigen::ColMajor : Eigen::RowMajor>>;
+
+        Model<double, nq> model;
+
+        explicit ModelImpl(const Model<double, nq>& model_) : model(model_) {}
+
+        std::unique_ptr<ModelBase> clone() const override {
+            return std::make_unique<ModelImpl<nq>>(model);
+        }
+
+        int n_q() const override {
+            return nq;
+        }
+
+        int n_links() const override {
+            return model.links.size();
+        }
+
+        int base_link_idx() const override {
+            return model.base_link_idx;
+        }
+
+        int link_index(const std::string& name) const override {
+            for (const auto& link : model.links) {
+                if (link.name == name) {
+                    return link.idx;
+                }
+            }
+            return -1;
+        }
+
+        void check_link(const int idx) const {
+            if (idx < 0 || idx >= int(model.links.size())) {
+                throw std::invalid_argument("Error! Link index " + std::to_string(idx) + " is out of range.");
+            }
+        }
+
+        void forward_kinematics(const size_t n,
+                                const double* q,
+                                const int target,
+                                const int source,
+                                double* H) override {
+            check_link(target);
+            check_link(source);
+            for (size_t i = 0; i < n; ++i) {
+                tinyrobotics::forward_kinematics(model, Configuration(ConstMap(q + i * nq)));
+                Eigen::Map<Eigen::Matrix<double, 4, 4, Eigen::RowMajor>>(H + i * 16) =
+                    (model.forward_kinematics[source].inverse() * model.forward_kinematics[target]).matrix();
+            }
+        }
+
+        void jacobian(const size_t n,
+                      const double* q,
+                      const int target,
+                      const int source,
+                      const ReferenceFrame frame,
+                      double* J) override {
+            check_link(target);
+            check_link(source);
+            for (size_t i = 0; i < n; ++i) {
+                JacobianMap(J + i * 6 * nq) =
+                    tinyrobotics::jacobian(model, Configuration(ConstMap(q + i * nq)), target, source, frame);
+            }
+        }
+
+        void forward_dynamics(const size_t n,
+                              const double* q,
+                              const double* dq,
+                              const double* tau,
+                              double* ddq) override {
+            for (size_t i = 0; i < n; ++i) {
+                Eigen::Map<Configuration>(ddq + i * nq) =
+                    tinyrobotics::forward_dynamics(model,
+                                                   Configuration(ConstMap(q + i * nq)),
+                                                   Configuration(ConstMap(dq + i * nq)),
+                                                   Configuration(ConstMap(tau + i * nq)));
+            }
+        }
+
+        void inverse_dynamics(const size_t n,
+                              const double* q,
+                              const double* dq,
+                              const double* ddq,
+                              double* tau) override {
+            for (size_t i = 0; i < n; ++i) {
+                Eigen::Map<Configuration>(tau + i * nq) =
+                    tinyrobotics::inverse_dynamics(model,
+                                                   Configuration(ConstMap(q + i * nq)),
+                                                   Configuration(ConstMap(dq + i * nq)),
+                                                   Configuration(ConstMap(ddq + i * nq)));
+            }
+        }
+
+        void mass_matrix(const size_t n, const double* q, double* M) override {
+            for (size_t i = 0; i < n; ++i) {
+                // The mass matrix is symmetric so the storage order does not matter
+                Eigen::Map<Eigen::Matrix<double, nq, nq>>(M + i * nq * nq) =
+                    tinyrobotics::mass_matrix(model, Configuration(ConstMap(q + i * nq)));
+            }
+        }
+    };
+
+    /**
+     * @brief Runs a function, converting exceptions into an error code and the last error message.
+     * @param function Function to run.
+     * @return TR_SUCCESS if the function did not throw, TR_ERROR otherwise.
+     */
+    template <typename Function>
+    int guard(const Function& function) {
+        try {
+            function();
+            last_error.clear();
+            return TR_SUCCESS;
+        }
+        catch (const std::exception& e) {
+            last_error = e.what();
+        }
+        catch (...) {
+            last_error = "Error! Unknown exception.";
+        }
+        return TR_ERROR;
+    }
+
+}  // namespace
+
+struct tr_model {
+    std::unique_ptr<ModelBase> impl;
+};
+
+struct tr_workspace {
+    std::unique_ptr<ModelBase> impl;
+};
+
+/**
+ * @brief Checks a workspace and its buffers are valid.
+ * @param workspace Workspace to check.
+ * @param buffers Buffers to check are not null.
+ * @throws std::invalid_argument if the workspace or any buffer is null.
+ */
+static void check_arguments(const tr_workspace* workspace, std::initializer_list<const double*> buffers) {
+    if (workspace == nullptr) {
+        throw std::invalid_argument("Error! Workspace is null.");
+    }
+    for (const double* buffer : buffers) {
+        if (buffer == nullptr) {
+            throw std::invalid_argument("Error! Buffer is null.");
+        }
+    }
+}
+
+int tr_api_version(void) {
+    return TR_C_API_VERSION;
+}
+
+const char* tr_last_error(void) {
+    return last_error.c_str();
+}
+
+tr_model* tr_import_urdf(const char* path_to_urdf) {
+    std::unique_ptr<tr_model> model;
+    guard([&] {
+        if (path_to_urdf == nullptr) {
+            throw std::invalid_argument("Error! URDF path is null.");
+        }
+        const std::string path(path_to_urdf);
+        model = std::make_unique<tr_model>();
+        model->impl = dispatch_nq(urdf_n_q(path), [&](auto n) -> std::unique_ptr<ModelBase> {
+            constexpr int nq = decltype(n)::value;
+            return std::make_unique<ModelImpl<nq>>(import_urdf<double, nq>(path));
+        });
+    });
+    return model && model->impl ? model.release() : nullptr;
+}
+
+void tr_model_free(tr_model* model) {
+    delete model;
+}
+
+int tr_model_n_q(const tr_model* model) {
+    return model != nullptr ? model->impl->n_q() : 0;
+}
+
+int tr_model_n_links(const tr_model* model) {
+    return model != nullptr ? model->impl->n_links() : 0;
+}
+
+int tr_model_link_index(const tr_model* model, const char* link_name) {
+    return model != nullptr && link_name != nullptr ? model->impl->link_index(link_name) : -1;
+}
+
+int tr_model_base_link_index(const tr_model* model) {
+    return model != nullptr ? model->impl->base_link_idx() : -1;
+}
+
+tr_workspace* tr_workspace_create(const tr_model* model) {
+    std::unique_ptr<tr_workspace> workspace;
+    guard([&] {
+        if (model == nullptr) {
+            throw std::invalid_argument("Error! Model is null.");
+        }
+        workspace       = std::make_unique<tr_workspace>();
+        workspace->impl = model->impl->clone();
+    });
+    return workspace && workspace->impl ? workspace.release() : nullptr;
+}
+
+void tr_workspace_free(tr_workspace* workspace) {
+    delete workspace;
+}
+
+int tr_forward_kinematics(tr_workspace* workspace,
+                          size_t n,
+                          const double* q,
+                          int target_link,
+                          int source_link,
+                          double* H) {
+    return guard([&] {
+        check_arguments(workspace, {q, H});
+        workspace->impl->forward_kinematics(n, q, target_link, source_link, H);
+    });
+}
+
+int tr_jacobian(tr_workspace* workspace,
+                size_t n,
+                const double* q,
+                int target_link,
+                int source_link,
+                int frame,
+                double* J) {
+    return guard([&] {
+        check_arguments(workspace, {q, J});
+        if (frame < TR_FRAME_LOCAL || frame > TR_FRAME_LOCAL_WORLD_ALIGNED) {
+            throw std::invalid_argument("Error! Unknown reference frame " + std::to_string(frame) + ".");
+        }
+        workspace->impl->jacobian(n, q, target_link, source_link, static_cast<ReferenceFrame>(frame), J);
+    });
+}
+
+int tr_forward_dynamics(tr_workspace* workspace,
+                        size_t n,
+                        const double* q,
+                        const double* dq,
+                        const double* tau,
+                        double* ddq) {
+    return guard([&] {
+        check_arguments(workspace, {q, dq, tau, ddq});
+        workspace->impl->forward_dynamics(n, q, dq, tau, ddq);
+    });
+}
+
+int tr_inverse_dynamics(tr_workspace* workspace,
+                        size_t n,
+                        const double* q,
+                        const double* dq,
+                        const double* ddq,
+                        double* tau) {
+    return guard([&] {
+        check_arguments(workspace, {q, dq, ddq, tau});
+        workspace->impl->inverse_dynamics(n, q, dq, ddq, tau);
+    });
+}
+
+int tr_mass_matrix(tr_workspace* workspace, size_t n, const double* q, double* M) {
+    return guard([&] {
+        check_arguments(workspace, {q, M});
+        workspace->impl->mass_matrix(n, q, M);
+    });
+}
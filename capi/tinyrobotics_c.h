@@ -0,0 +1,159 @@
+#ifndef TR_TINYROBOTICS_C_H
+#define TR_TINYROBOTICS_C_H
+
+#include <stddef.h>
+
+/** \file tinyrobotics_c.h
+ * @brief Stable C interface to tinyrobotics for foreign function interfaces (Rust, Julia, ...).
+ *
+ * Models are opaque handles created from a URDF. Algorithms run on workspaces, which hold the pre-allocated buffers
+ * of a model, so each thread calling into the library must use its own workspace. All batched functions evaluate n
+ * samples stored contiguously in caller-owned buffers, row-major per sample:
+ *   - q, dq, ddq, tau: n x n_q
+ *   - H: n x 4 x 4
+ *   - J: n x 6 x n_q, linear part stacked above the angular part
+ *   - M: n x n_q x n_q
+ *
+ * Functions returning int return TR_SUCCESS on success or TR_ERROR on failure, in which case tr_last_error describes
+ * the failure.
+ */
+
+#if defined(_WIN32)
+#define TR_C_API __declspec(dllexport)
+#else
+#define TR_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Version of the C interface, incremented on incompatible changes.
+#define TR_C_API_VERSION 1
+
+/// @brief Return codes.
+#define TR_SUCCESS 0
+#define TR_ERROR -1
+
+/// @brief Reference frames in which jacobians are expressed, matching tinyrobotics::ReferenceFrame.
+#define TR_FRAME_LOCAL 0
+#define TR_FRAME_WORLD 1
+#define TR_FRAME_LOCAL_WORLD_ALIGNED 2
+
+/// @brief Opaque handle to a robot model.
+typedef struct tr_model tr_model;
+
+/// @brief Opaque handle to a per-thread workspace of a robot model.
+typedef struct tr_workspace tr_workspace;
+
+/// @brief Get the version of the C interface the library was built with.
+TR_C_API int tr_api_version(void);
+
+/// @brief Get the message of the last error on the calling thread, or an empty string.
+TR_C_API const char* tr_last_error(void);
+
+/// @brief Load a model from a URDF file, returning NULL on failure.
+TR_C_API tr_model* tr_import_urdf(const char* path_to_urdf);
+
+/// @brief Free a model. Workspaces created from the model remain valid.
+TR_C_API void tr_model_free(tr_model* model);
+
+/// @brief Get the number of configuration coordinates of a model.
+TR_C_API int tr_model_n_q(const tr_model* model);
+
+/// @brief Get the number of links of a model.
+TR_C_API int tr_model_n_links(const tr_model* model);
+
+/// @brief Get the index of a link by name, or -1 if there is no such link.
+TR_C_API int tr_model_link_index(const tr_model* model, const char* link_name);
+
+/// @brief Get the index of the base link of a model.
+TR_C_API int tr_model_base_link_index(const tr_model* model);
+
+/// @brief Create a workspace for a model, returning NULL on failure.
+TR_C_API tr_workspace* tr_workspace_create(const tr_model* model);
+
+/// @brief Free a workspace.
+TR_C_API void tr_workspace_free(tr_workspace* workspace);
+
+/**
+ * @brief Computes the transform between the target and source links for n samples.
+ * @param workspace Workspace of the calling thread.
+ * @param n Number of samples.
+ * @param q Joint configurations, n x n_q.
+ * @param target_link Index of the target link.
+ * @param source_link Index of the source link.
+ * @param H Output transforms, n x 4 x 4.
+ */
+TR_C_API int tr_forward_kinematics(tr_workspace* workspace,
+                                   size_t n,
+                                   const double* q,
+                                   int target_link,
+                                   int source_link,
+                                   double* H);
+
+/**
+ * @brief Computes the geometric jacobian of the target link from the source link for n samples, where the source
+ * link is an ancestor of the target link.
+ * @param workspace Workspace of the calling thread.
+ * @param n Number of samples.
+ * @param q Joint configurations, n x n_q.
+ * @param target_link Index of the target link.
+ * @param source_link Index of the source link.
+ * @param frame Reference frame, one of the TR_FRAME_* values.
+ * @param J Output jacobians, n x 6 x n_q.
+ */
+TR_C_API int tr_jacobian(tr_workspace* workspace,
+                         size_t n,
+                         const double* q,
+                         int target_link,
+                         int source_link,
+                         int frame,
+                         double* J);
+
+/**
+ * @brief Computes the joint accelerations with the articulated-body algorithm for n samples.
+ * @param workspace Workspace of the calling thread.
+ * @param n Number of samples.
+ * @param q Joint configurations, n x n_q.
+ * @param dq Joint velocities, n x n_q.
+ * @param tau Joint torques, n x n_q.
+ * @param ddq Output joint accelerations, n x n_q.
+ */
+TR_C_API int tr_forward_dynamics(tr_workspace* workspace,
+                                 size_t n,
+                                 const double* q,
+                                 const double* dq,
+                                 const double* tau,
+                                 double* ddq);
+
+/**
+ * @brief Computes the joint torques with the recursive Newton-Euler algorithm for n samples.
+ * @param workspace Workspace of the calling thread.
+ * @param n Number of samples.
+ * @param q Joint configurations, n x n_q.
+ * @param dq Joint velocities, n x n_q.
+ * @param ddq Joint accelerations, n x n_q.
+ * @param tau Output joint torques, n x n_q.
+ */
+TR_C_API int tr_inverse_dynamics(tr_workspace* workspace,
+                                 size_t n,
+                                 const double* q,
+                                 const double* dq,
+                                 const double* ddq,
+                                 double* tau);
+
+/**
+ * @brief Computes the mass matrix for n samples.
+ * @param workspace Workspace of the calling thread.
+ * @param n Number of samples.
+ * @param q Joint configurations, n x n_q.
+ * @param M Output mass matrices, n x n_q x n_q.
+ */
+TR_C_API int tr_mass_matrix(tr_workspace* workspace, size_t n, const double* q, double* M);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "../include/inversekinematics.hpp"
+#include "../include/kinematics.hpp"
+#include "../include/model.hpp"
+#include "../include/parser.hpp"
+
+using namespace tinyrobotics;
+
+const int n_joints = 20;
+using Configuration = Eigen::Matrix<double, n_joints, 1>;
+using Pose          = Eigen::Transform<double, 3, Eigen::Isometry>;
+
+double max_error(Model<double, n_joints>& model,
+                 const std::string& target_link_name,
+                 const std::string& source_link_name,
+                 const std::vector<Pose>& Hst_desired,
+                 const std::vector<Configuration>& q_solution) {
+    double error = 0;
+    for (size_t i = 0; i < Hst_desired.size(); ++i) {
+        auto Hst_solution = forward_kinematics(model, q_solution[i], target_link_name, source_link_name);
+        error             = std::max(error, homogeneous_error(Hst_desired[i], Hst_solution).squaredNorm());
+    }
+    return error;
+}
+
+int main(int argc, char* argv[]) {
+    // Load model
+    auto model                   = import_urdf<double, n_joints>("../data/urdfs/nugus.urdf");
+    std::string target_link_name = "left_foot_base";
+    std::string source_link_name = "torso";
+
+    // Make a set of independent problems, for example grasp or foothold candidates
+    const int n_problems = argc > 1 ? std::stoi(argv[1]) : 4096;
+    std::vector<Pose> Hst_desired;
+    std::vector<Configuration> q0;
+    for (int i = 0; i < n_problems; ++i) {
+        Configuration q_random = model.random_configuration();
+        Hst_desired.push_back(forward_kinematics(model, q_random, target_link_name, source_link_name));
+        q0.push_back(model.home_configuration());
+    }
+
+    InverseKinematicsOptions<double, n_joints> options;
+    options.method         = InverseKinematicsMethod::LEVENBERG_MARQUARDT;
+    options.max_iterations = 1000;
+    options.tolerance      = 1e-6;
+
+    // ************ Scalar solver on one core ************
+    std::vector<Configuration> q_solution(n_problems);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < n_problems; ++i) {
+        q_solution[i] = inverse_kinematics(model, target_link_name, source_link_name, Hst_desired[i], q0[i], options);
+    }
+    auto stop     = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    std::cout << "Scalar (1 thread): " << duration.count() << " us, max error "
+              << max_error(model, target_link_name, source_link_name, Hst_desired, q_solution) << std::endl;
+
+    // ************ Scalar solver across threads ************
+    const int n_threads = std::max(1u, std::thread::hardware_concurrency());
+    start               = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            // Each thread needs its own model as it holds the pre-allocated workspace
+            auto thread_model = model;
+            for (int i = t; i < n_problems; i += n_threads) {
+                q_solution[i] = inverse_kinematics(thread_model,
+                                                   target_link_name,
+                                                   source_link_name,
+                                                   Hst_desired[i],
+                                                   q0[i],
+                                                   options);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    stop     = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    std::cout << "Scalar (" << n_threads << " threads): " << duration.count() << " us, max error "
+              << max_error(model, target_link_name, source_link_name, Hst_desired, q_solution) << std::endl;
+
+    // ************ Lockstep solver on one core ************
+    start      = std::chrono::high_resolution_clock::now();
+    q_solution = inverse_kinematics_levenberg_marquardt_batch<double, n_joints, 4>(model,
+                                                                                    target_link_name,
+                                                                                    source_link_name,
+                                                                                    Hst_desired,
+                                                                                    q0,
+                                                                                    options);
+    stop       = std::chrono::high_resolution_clock::now();
+    duration   = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    std::cout << "Lockstep 4 lanes (1 thread): " << duration.count() << " us, max error "
+              << max_error(model, target_link_name, source_link_name, Hst_desired, q_solution) << std::endl;
+
+    start      = std::chrono::high_resolution_clock::now();
+    q_solution = inverse_kinematics_levenberg_marquardt_batch<double, n_joints, 8>(model,
+                                                                                    target_link_name,
+                                                                                    source_link_name,
+                                                                                    Hst_desired,
+                                                                                    q0,
+                                                                                    options);
+    stop       = std::chrono::high_resolution_clock::now();
+    duration   = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    std::cout << "Lockstep 8 lanes (1 thread): " << duration.count() << " us, max error "
+              << max_error(model, target_link_name, source_link_name, Hst_desired, q_solution) << std::endl;
+
+    return 0;
+}
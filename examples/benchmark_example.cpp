@@ -1,11 +1,13 @@
 #include <Eigen/Dense>
-#include <chrono>
 #include <string>
 
+#include "../include/benchmark.hpp"
 #include "../include/dynamics.hpp"
 #include "../include/inversekinematics.hpp"
 #include "../include/kinematics.hpp"
 #include "../include/parser.hpp"
+#include "../include/spline.hpp"
+#include "../include/taskspace.hpp"
 
 using namespace tinyrobotics;
 
@@ -20,85 +22,115 @@ int main(int argc, char* argv[]) {
     // ************ Model Details ************
     model.show_details();
 
+    // Hardware counters (IPC, cache and branch misses per call) are reported when perf_event is available
+    auto q = model.random_configuration();
+
     // ************ Forward Kinematics ************
-    auto start    = std::chrono::high_resolution_clock::now();
-    auto q        = model.random_configuration();
-    auto H        = forward_kinematics(model, q, target_link);
-    auto stop     = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Forward Kinematics: " << duration.count() << " microseconds" << std::endl;
+    Eigen::Isometry3d H;
+    std::cout << benchmark("Forward Kinematics", [&] { H = forward_kinematics(model, q, target_link); }) << std::endl;
 
     // ************ Center of Mass ************
-    start    = std::chrono::high_resolution_clock::now();
-    auto com = center_of_mass(model, q);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Center of Mass: " << duration.count() << " microseconds" << std::endl;
+    Eigen::Vector3d com;
+    std::cout << benchmark("Center of Mass", [&] { com = center_of_mass(model, q); }) << std::endl;
 
     // ************ Inverse Kinematics ************
-    start = std::chrono::high_resolution_clock::now();
     InverseKinematicsOptions<double, n_joints> options;
     options.max_iterations = 1000;
     options.tolerance      = 1e-4;
     options.method         = InverseKinematicsMethod::LEVENBERG_MARQUARDT;
     auto q0                = model.home_configuration();
-    auto q_sol             = inverse_kinematics(model, target_link, source_link, H, q0, options);
-    stop                   = std::chrono::high_resolution_clock::now();
-    duration               = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Inverse Kinematics: " << duration.count() << " microseconds" << std::endl;
+    auto q_sol             = q0;
+    std::cout << benchmark(
+        "Inverse Kinematics",
+        [&] { q_sol = inverse_kinematics(model, target_link, source_link, H, q0, options); },
+        10,
+        1) << std::endl;
+
+    // ************ Pruned Forward Kinematics ************
+    auto nugus     = import_urdf<double, 20>("../data/urdfs/nugus.urdf");
+    auto q_nugus   = nugus.random_configuration();
+    auto feet_head = link_set(nugus, std::vector<std::string>{"left_foot_base", "right_foot_base", "head"});
+    std::cout << benchmark("Forward Kinematics (all links, nugus)", [&] { forward_kinematics(nugus, q_nugus); })
+              << std::endl;
+    std::cout << benchmark("Forward Kinematics (feet and head link set, nugus)",
+                           [&] { forward_kinematics(nugus, q_nugus, feet_head); })
+              << std::endl;
 
     // ************ Geometric Jacobian ************
-    start    = std::chrono::high_resolution_clock::now();
-    auto J   = jacobian(model, q, target_link);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Geometric Jacobian: " << duration.count() << " microseconds" << std::endl;
+    Eigen::Matrix<double, 6, n_joints> J;
+    std::cout << benchmark("Geometric Jacobian", [&] { J = jacobian(model, q, target_link); }) << std::endl;
 
     // ************ Forward Dynamics ************
-    start    = std::chrono::high_resolution_clock::now();
-    auto qdd = forward_dynamics(model, q, q, q);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Forward Dynamics ABA: " << duration.count() << " microseconds" << std::endl;
-
-    start    = std::chrono::high_resolution_clock::now();
-    qdd      = forward_dynamics_crb(model, q, q, q);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Forward Dynamics CRB: " << duration.count() << " microseconds" << std::endl;
+    auto qdd = q;
+    std::cout << benchmark("Forward Dynamics ABA", [&] { qdd = forward_dynamics(model, q, q, q); }) << std::endl;
+    std::cout << benchmark("Forward Dynamics CRB", [&] { qdd = forward_dynamics_crb(model, q, q, q); }) << std::endl;
 
     // ************ Inverse Dynamics ************
-    start    = std::chrono::high_resolution_clock::now();
-    auto tau = inverse_dynamics(model, q, q, q);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Inverse Dynamics: " << duration.count() << " microseconds" << std::endl;
+    auto tau = q;
+    std::cout << benchmark("Inverse Dynamics", [&] { tau = inverse_dynamics(model, q, q, q); }) << std::endl;
 
     // ************ Mass Matrix ************
-    start    = std::chrono::high_resolution_clock::now();
-    auto M   = mass_matrix(model, q);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Mass Matrix: " << duration.count() << " microseconds" << std::endl;
-
-    // ************ Kinetic Energy ************
-    start    = std::chrono::high_resolution_clock::now();
-    auto T   = kinetic_energy(model, q, q);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Kinetic Energy: " << duration.count() << " microseconds" << std::endl;
-
-    // ************ Potential Energy ************
-    start    = std::chrono::high_resolution_clock::now();
-    auto V   = potential_energy(model, q);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Potential Energy: " << duration.count() << " microseconds" << std::endl;
-
-    // ************ Total Energy ************
-    start    = std::chrono::high_resolution_clock::now();
-    auto E   = total_energy(model, q, q);
-    stop     = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "Total Energy: " << duration.count() << " microseconds" << std::endl;
-}
\ No newline at end of file
+    Eigen::Matrix<double, n_joints, n_joints> M;
+    std::cout << benchmark("Mass Matrix", [&] { M = mass_matrix(model, q); }) << std::endl;
+
+    // ************ Mass Matrix Derivative ************
+    Eigen::Matrix<double, n_joints, n_joints> dM;
+    std::cout << benchmark("Mass Matrix Derivative", [&] { dM = mass_matrix_derivative(model, q, q); }) << std::endl;
+
+    // ************ Coriolis Matrix ************
+    Eigen::Matrix<double, n_joints, n_joints> C;
+    std::cout << benchmark("Coriolis Matrix", [&] { C = coriolis_matrix(model, q, q); }) << std::endl;
+
+    // ************ Energy ************
+    double E = 0;
+    std::cout << benchmark("Kinetic Energy", [&] { E = kinetic_energy(model, q, q); }) << std::endl;
+    std::cout << benchmark("Potential Energy", [&] { E = potential_energy(model, q); }) << std::endl;
+    std::cout << benchmark("Total Energy", [&] { E = total_energy(model, q, q); }) << std::endl;
+
+    // ************ Spline Trajectory ************
+    using Samples = Eigen::Matrix<double, n_joints, Eigen::Dynamic>;
+    Samples waypoints(n_joints, 3);
+    waypoints << model.home_configuration(), q, model.home_configuration();
+    const auto spline = JointSpline<double, n_joints>::quintic(
+        {0.0, 1.0, 2.0}, waypoints, Samples::Zero(n_joints, 3), Samples::Zero(n_joints, 3));
+    std::vector<double> times(2001);
+    for (size_t i = 0; i < times.size(); i++) {
+        times[i] = 0.001 * i;
+    }
+    Samples q_samples, dq_samples, ddq_samples;
+    std::cout << benchmark("Spline Evaluation (2001 samples)",
+                           [&] { spline.evaluate(times, q_samples, dq_samples, ddq_samples); })
+              << std::endl;
+    Samples tau_samples;
+    std::cout << benchmark("Feedforward Torques (2001 samples)",
+                           [&] { tau_samples = feedforward_torques(model, spline, times); })
+              << std::endl;
+
+    // ************ Stacked Task Projectors ************
+    using NugusMatrix = Eigen::Matrix<double, 20, 20>;
+    std::vector<Task<double, 20>> tasks(4);
+    tasks[0].jacobian = jacobian(nugus, q_nugus, std::string("left_foot_base"));
+    tasks[1].jacobian = jacobian(nugus, q_nugus, std::string("right_foot_base"));
+    tasks[2].jacobian = jacobian(nugus, q_nugus, std::string("left_lower_arm")).bottomRows(3);
+    tasks[3].jacobian = jacobian(nugus, q_nugus, std::string("right_lower_arm")).bottomRows(3);
+    NugusMatrix N;
+    std::cout << benchmark("Task Projectors (4 stacked tasks, mass matrix inverse, nugus)",
+                           [&] {
+                               const NugusMatrix Minv = mass_matrix(nugus, q_nugus).inverse();
+                               N.setIdentity();
+                               for (const auto& task : tasks) {
+                                   const Eigen::MatrixXd Jp     = task.jacobian * N;
+                                   const Eigen::MatrixXd Lambda = (Jp * Minv * Jp.transpose()).inverse();
+                                   const Eigen::MatrixXd Jbar   = Minv * Jp.transpose() * Lambda;
+                                   N                            = N * (NugusMatrix::Identity() - Jbar * Jp);
+                               }
+                           })
+              << std::endl;
+    TaskProjector<double, 20> projector(nugus);
+    std::cout << benchmark("Task Projectors (4 stacked tasks, shared factorization, nugus)",
+                           [&] {
+                               projector.update(q_nugus);
+                               projector.project(tasks);
+                           })
+              << std::endl;
+}
@@ -0,0 +1,92 @@
+#include <Eigen/Dense>
+#include <chrono>
+#include <iostream>
+
+#include "../include/dynamics.hpp"
+#include "../include/integrator.hpp"
+#include "../include/parser.hpp"
+
+using namespace tinyrobotics;
+
+int main(int argc, char* argv[]) {
+    // Load model, released from rest to swing freely under gravity
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto model          = import_urdf<double, n_joints>("../data/urdfs/panda_arm.urdf");
+    Configuration q0;
+    q0 << 0, -0.5, 0, -2, 0, 1.5, 0.7;
+    const Configuration dq0  = Configuration::Zero();
+    const Configuration zero = Configuration::Zero();
+    const double energy      = total_energy(model, q0, dq0);
+    const double duration    = 10.0;
+
+    // Simulates the duration with a step function, returning the number of steps per second
+    auto simulate = [&](const double h, auto&& step) {
+        const int steps  = static_cast<int>(duration / h);
+        const auto start = std::chrono::steady_clock::now();
+        for (int k = 0; k < steps; k++) {
+            step();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        return steps / std::chrono::duration<double>(stop - start).count();
+    };
+    auto report = [&](const std::string& name, const double h, const double steps_per_second,
+                      const Configuration& q, const Configuration& dq) {
+        std::cout << name << " (h = " << h << " s): " << steps_per_second << " steps/s, "
+                  << steps_per_second * h << "x real time, energy drift after " << duration
+                  << " s: " << total_energy(model, q, dq) - energy << " J" << std::endl;
+    };
+
+    // ************ Semi-implicit Euler on forward dynamics ************
+    for (const double h : {1e-4, 1e-3}) {
+        Configuration q  = q0;
+        Configuration dq = dq0;
+        const double steps_per_second = simulate(h, [&] {
+            dq += h * forward_dynamics(model, q, dq, zero);
+            q += h * dq;
+        });
+        report("Semi-implicit Euler", h, steps_per_second, q, dq);
+    }
+
+    // ************ Variational integrator ************
+    for (const double h : {1e-3, 5e-3}) {
+        VariationalIntegrator<double, n_joints> integrator(model);
+        integrator.reset(q0, dq0);
+        const double steps_per_second = simulate(h, [&] { integrator.step(zero, h); });
+        report("Variational integrator", h, steps_per_second, integrator.q(), integrator.dq());
+    }
+
+    // ************ Dormand-Prince 5(4), adaptive steps with 100 Hz dense output ************
+    for (const double tolerance : {1e-6, 1e-9}) {
+        DormandPrinceOptions<double> options;
+        options.relative_tolerance = tolerance;
+        options.absolute_tolerance = tolerance;
+        DormandPrinceIntegrator<double, n_joints> integrator(model, options);
+        integrator.reset(q0, dq0);
+        int n_samples    = 0;
+        const auto start = std::chrono::steady_clock::now();
+        integrator.integrate(zero, duration, 1e-2, [&](double, const Configuration&, const Configuration&) {
+            n_samples++;
+        });
+        const auto stop      = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(stop - start).count();
+        std::cout << "Dormand-Prince (tolerance = " << tolerance << "): " << integrator.accepted_steps()
+                  << " accepted and " << integrator.rejected_steps() << " rejected steps, "
+                  << integrator.evaluations() << " forward dynamics calls, " << n_samples << " samples, "
+                  << duration / seconds << "x real time, energy drift after " << duration
+                  << " s: " << total_energy(model, integrator.q(), integrator.dq()) - energy << " J" << std::endl;
+    }
+
+    // ************ Dormand-Prince batch of initial conditions ************
+    const int n_batch = 100;
+    std::vector<Configuration> q(n_batch), dq(n_batch);
+    for (int i = 0; i < n_batch; i++) {
+        q[i]  = model.random_configuration();
+        dq[i] = dq0;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    integrate_batch(model, q, dq, zero, 1.0);
+    const auto stop = std::chrono::steady_clock::now();
+    std::cout << "Dormand-Prince batch of " << n_batch << " initial conditions over 1 s: "
+              << std::chrono::duration<double, std::milli>(stop - start).count() << " ms" << std::endl;
+}
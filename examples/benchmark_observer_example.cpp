@@ -0,0 +1,48 @@
+#include <Eigen/Dense>
+#include <iostream>
+
+#include "../include/benchmark.hpp"
+#include "../include/dynamics.hpp"
+#include "../include/observer.hpp"
+#include "../include/parser.hpp"
+
+using namespace tinyrobotics;
+
+int main(int argc, char* argv[]) {
+    // Load model
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto model          = import_urdf<double, n_joints>("../data/urdfs/kuka.urdf");
+    Configuration q     = model.random_configuration();
+    Configuration dq    = Configuration::Random();
+    Configuration tau   = gravity_torque(model, q);
+    const double dt     = 1e-3;
+
+    // ************ Assembled terms: mass matrix, finite difference Coriolis and gravity ************
+    Configuration r_assembled = Configuration::Zero();
+    Configuration integral    = mass_matrix(model, q) * dq;
+
+    auto assembled = benchmark("Observer tick (assembled terms)", [&] {
+        const double h                                    = 1e-6;
+        const Eigen::Matrix<double, n_joints, n_joints> M = mass_matrix(model, q);
+        const Eigen::Matrix<double, n_joints, n_joints> dM =
+            (mass_matrix(model, Configuration(q + dq * h)) - mass_matrix(model, Configuration(q - dq * h))) / (2 * h);
+        const Configuration g           = gravity_torque(model, q);
+        const Configuration coriolis    = inverse_dynamics(model, q, dq, Configuration::Zero().eval()) - g;
+        const Configuration coriolis_tr = dM * dq - coriolis;
+        integral += (tau + coriolis_tr - g + r_assembled) * dt;
+        r_assembled = 100.0 * (M * dq - integral);
+    });
+    std::cout << assembled << std::endl;
+
+    // ************ Momentum observer: one recursive pass ************
+    MomentumObserver<double, n_joints> observer(model, Configuration::Constant(100.0));
+    observer.reset(q, dq);
+    auto recursive = benchmark("Observer tick (momentum observer)", [&] { observer.update(q, dq, tau, dt); });
+    std::cout << recursive << std::endl;
+
+    // ************ Share of the 1 kHz control period ************
+    std::cout << "Share of a 1 kHz tick: assembled " << 100 * assembled.median_ns / 1e6 << " %, observer "
+              << 100 * recursive.median_ns / 1e6 << " %, speedup " << assembled.median_ns / recursive.median_ns << "x"
+              << std::endl;
+}
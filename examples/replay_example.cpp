@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <iostream>
+
+#include "../include/dispatch.hpp"
+#include "../include/replay.hpp"
+
+using namespace tinyrobotics;
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <urdf> <capture> [n_repeats] [n_slowest]" << std::endl;
+        return 1;
+    }
+    const std::string path_to_urdf = argv[1];
+    const int n_repeats            = argc > 3 ? std::stoi(argv[3]) : 10;
+    const int n_slowest            = argc > 4 ? std::stoi(argv[4]) : 10;
+
+    try {
+        // Load the captured calls, written in production with CaptureBuffer::dump
+        const CaptureBuffer capture = CaptureBuffer::load(argv[2]);
+        std::cout << "Loaded " << capture.records().size() << " captured calls" << std::endl;
+
+        dispatch_nq(urdf_n_q(path_to_urdf), [&](auto n) {
+            constexpr int nq = decltype(n)::value;
+            auto model       = import_urdf<double, nq>(path_to_urdf);
+
+            // Re-run every call and report the calls which were slowest when captured
+            std::vector<ReplayResult> results = replay(model, capture, n_repeats);
+            std::sort(results.begin(), results.end(), [](const ReplayResult& a, const ReplayResult& b) {
+                return a.captured_ns > b.captured_ns;
+            });
+            for (int i = 0; i < std::min<int>(n_slowest, results.size()); ++i) {
+                std::cout << "captured " << results[i].captured_ns / 1e3 << " us, replayed " << results[i].benchmark
+                          << std::endl;
+            }
+        });
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
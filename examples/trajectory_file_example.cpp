@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include "../include/parser.hpp"
+#include "../include/trajectoryfile.hpp"
+
+using namespace tinyrobotics;
+
+int main(int argc, char* argv[]) {
+    // Load model
+    const int n_joints = 7;
+    auto model         = import_urdf<double, n_joints>("../data/urdfs/panda_arm.urdf");
+
+    // Record an hour of a 1 kHz log by default
+    const int n_samples    = argc > 1 ? std::stoi(argv[1]) : 3600 * 1000;
+    const std::string path = argc > 2 ? argv[2] : "trajectory.trj";
+    {
+        auto file = TrajectoryFile::create(path, model_hash(model), n_joints, 1000.0, n_samples);
+        file.add_column("q", n_joints);
+        file.add_column("dq", n_joints);
+        file.add_column("ddq", n_joints);
+        auto q   = file.mutable_column("q");
+        auto dq  = file.mutable_column("dq");
+        auto ddq = file.mutable_column("ddq");
+        for (int i = 0; i < n_samples; ++i) {
+            const double t = i / 1000.0;
+            for (int j = 0; j < n_joints; ++j) {
+                q(i, j)   = std::sin(t + j);
+                dq(i, j)  = std::cos(t + j);
+                ddq(i, j) = -std::sin(t + j);
+            }
+        }
+    }
+
+    // Derive the joint torques and center of mass in place
+    auto file  = TrajectoryFile::open(path, true);
+    auto start = std::chrono::high_resolution_clock::now();
+    apply_inverse_dynamics(file, model);
+    apply_center_of_mass(file, model);
+    auto stop     = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+    const double megabytes = n_samples * (4 * n_joints + 3) * sizeof(double) / 1e6;
+    std::cout << "Processed " << n_samples << " samples in " << duration.count() << " us ("
+              << n_samples / (duration.count() * 1e-6) << " samples/s, " << megabytes / (duration.count() * 1e-6)
+              << " MB/s)" << std::endl;
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,230 @@
+#ifndef TR_BENCHMARK_HPP
+#define TR_BENCHMARK_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/** \file benchmark.hpp
+ * @brief Contains a small harness for timing tinyrobotics algorithms, with hardware performance counters on Linux.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Hardware events counted by the benchmark harness.
+     */
+    enum class PerfEvent { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, COUNT };
+
+    /**
+     * @brief Hardware performance counters of the calling thread, read through Linux perf_event. Counters which cannot
+     * be opened, for example without permission, on virtual machines or on other platforms, are skipped.
+     */
+    class PerfCounters {
+    public:
+        /// @brief Number of events.
+        static constexpr int n_events = static_cast<int>(PerfEvent::COUNT);
+
+        PerfCounters() {
+            fds.fill(-1);
+#ifdef __linux__
+            const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                           | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const std::array<std::pair<uint32_t, uint64_t>, n_events> events = {{
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HW_CACHE, l1d_read_miss},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            }};
+            for (int i = 0; i < n_events; ++i) {
+                perf_event_attr attr{};
+                attr.size           = sizeof(attr);
+                attr.type           = events[i].first;
+                attr.config         = events[i].second;
+                attr.disabled       = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv     = 1;
+                fds[i]              = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            }
+#endif
+        }
+
+        ~PerfCounters() {
+#ifdef __linux__
+            for (const int fd : fds) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+#endif
+        }
+
+        PerfCounters(const PerfCounters&)            = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        /// @brief Whether an event is being counted.
+        bool available(const PerfEvent event) const {
+            return fds[static_cast<int>(event)] >= 0;
+        }
+
+        /// @brief Resets and starts all counters.
+        void start() {
+#ifdef __linux__
+            for (const int fd : fds) {
+                if (fd >= 0) {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+#endif
+        }
+
+        /**
+         * @brief Stops all counters and reads them.
+         * @return Count of each event since start, NaN for unavailable events.
+         */
+        std::array<double, n_events> stop() {
+            std::array<double, n_events> counts;
+            counts.fill(std::numeric_limits<double>::quiet_NaN());
+#ifdef __linux__
+            for (int i = 0; i < n_events; ++i) {
+                if (fds[i] >= 0) {
+                    ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+                }
+            }
+            for (int i = 0; i < n_events; ++i) {
+                uint64_t count = 0;
+                if (fds[i] >= 0 && read(fds[i], &count, sizeof(count)) == sizeof(count)) {
+                    counts[i] = count;
+                }
+            }
+#endif
+            return counts;
+        }
+
+    private:
+        /// @brief File descriptor of each counter, -1 if unavailable.
+        std::array<int, n_events> fds;
+    };
+
+    /**
+     * @brief Timing statistics of a benchmarked function.
+     */
+    struct BenchmarkResult {
+        /// @brief Name of the benchmark.
+        std::string name = "";
+
+        /// @brief Number of timed repetitions.
+        int n_repeats = 0;
+
+        /// @brief Mean, median, minimum and maximum time of a repetition in nanoseconds.
+        double mean_ns   = 0;
+        double median_ns = 0;
+        double min_ns    = 0;
+        double max_ns    = 0;
+
+        /// @brief Mean count of each PerfEvent per call, NaN if the counter is unavailable.
+        std::array<double, PerfCounters::n_events> per_call = {};
+
+        /// @brief Get the mean count of an event per call, NaN if the counter is unavailable.
+        double count(const PerfEvent event) const {
+            return per_call[static_cast<int>(event)];
+        }
+
+        /// @brief Instructions per cycle, NaN if the counters are unavailable.
+        double ipc() const {
+            return count(PerfEvent::INSTRUCTIONS) / count(PerfEvent::CYCLES);
+        }
+    };
+
+    /**
+     * @brief Times repeated calls of a function after a number of untimed warm up calls. The repetitions are then run
+     * again with hardware performance counters enabled around the whole loop, so the counts are not polluted by the
+     * timing calls.
+     * @param name Name of the benchmark.
+     * @param function Function to benchmark, called with no arguments.
+     * @param n_repeats Number of timed repetitions.
+     * @param n_warmup Number of untimed warm up calls.
+     * @tparam Function Type of the function.
+     * @return Timing statistics of the function.
+     */
+    template <typename Function>
+    BenchmarkResult benchmark(const std::string& name,
+                              const Function& function,
+                              const int n_repeats = 100,
+                              const int n_warmup  = 10) {
+        for (int i = 0; i < n_warmup; ++i) {
+            function();
+        }
+        std::vector<double> times(std::max(1, n_repeats));
+        for (auto& time : times) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const auto stop = std::chrono::steady_clock::now();
+            time            = std::chrono::duration<double, std::nano>(stop - start).count();
+        }
+        BenchmarkResult result;
+        result.name      = name;
+        result.n_repeats = times.size();
+        for (const double time : times) {
+            result.mean_ns += time / times.size();
+        }
+        std::sort(times.begin(), times.end());
+        result.median_ns = times[times.size() / 2];
+        result.min_ns    = times.front();
+        result.max_ns    = times.back();
+
+        // Count hardware events over a second run of the repetitions
+        PerfCounters counters;
+        counters.start();
+        for (int i = 0; i < result.n_repeats; ++i) {
+            function();
+        }
+        result.per_call = counters.stop();
+        for (auto& count : result.per_call) {
+            count /= result.n_repeats;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Prints the timing statistics of a benchmark on one line.
+     * @param os Output stream.
+     * @param result Timing statistics.
+     * @return The output stream.
+     */
+    inline std::ostream& operator<<(std::ostream& os, const BenchmarkResult& result) {
+        os << result.name << ": mean " << result.mean_ns / 1e3 << " us, median " << result.median_ns / 1e3
+           << " us, min " << result.min_ns / 1e3 << " us, max " << result.max_ns / 1e3 << " us (" << result.n_repeats
+           << " repeats)";
+        if (!std::isnan(result.ipc())) {
+            os << ", IPC " << result.ipc();
+        }
+        const std::array<std::pair<PerfEvent, const char*>, 3> misses = {{{PerfEvent::L1D_MISSES, "L1D misses"},
+                                                                           {PerfEvent::LLC_MISSES, "LLC misses"},
+                                                                           {PerfEvent::BRANCH_MISSES, "branch misses"}}};
+        for (const auto& miss : misses) {
+            if (!std::isnan(result.count(miss.first))) {
+                os << ", " << miss.second << "/call " << result.count(miss.first);
+            }
+        }
+        return os;
+    }
+
+}  // namespace tinyrobotics
+
+#endif
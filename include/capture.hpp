@@ -0,0 +1,209 @@
+#ifndef TR_CAPTURE_HPP
+#define TR_CAPTURE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** \file capture.hpp
+ * @brief Contains a ring buffer recording the inputs of solver calls, so slow calls seen in production can be
+ * replayed and profiled offline.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Types of solver calls which can be captured.
+     */
+    enum class CaptureCallType : uint32_t {
+        /// @brief inverse_kinematics, see encode_inverse_kinematics_call for the layout of the values.
+        INVERSE_KINEMATICS = 0,
+
+        /// @brief forward_dynamics, see encode_forward_dynamics_call for the layout of the values.
+        FORWARD_DYNAMICS = 1
+    };
+
+    /**
+     * @brief Inputs and timing of one captured solver call.
+     */
+    struct CaptureRecord {
+        /// @brief Type of the call.
+        CaptureCallType type = CaptureCallType::INVERSE_KINEMATICS;
+
+        /// @brief Wall clock time the call finished, in nanoseconds since the epoch.
+        int64_t timestamp_ns = 0;
+
+        /// @brief Duration of the call in nanoseconds.
+        int64_t duration_ns = 0;
+
+        /// @brief Inputs of the call.
+        std::vector<double> values = {};
+    };
+
+    /**
+     * @brief Get the current time of the monotonic clock used to time captured calls.
+     * @return Time in nanoseconds.
+     */
+    inline int64_t capture_clock_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * @brief Fixed capacity ring buffer of captured solver calls. Once full the oldest calls are overwritten. Slots are
+     * reused, so recording does not allocate once each slot has held a call of the same type. Recording is thread
+     * safe, so copies of a model used on different threads can share one buffer.
+     */
+    class CaptureBuffer {
+    public:
+        /**
+         * @brief Constructs an empty capture buffer.
+         * @param model_hash Hash of the model the calls are captured from, see model_hash.
+         * @param n_q Number of configuration coordinates of the model.
+         * @param capacity Maximum number of calls kept.
+         */
+        CaptureBuffer(const uint64_t model_hash, const int n_q, const size_t capacity)
+            : model_hash(model_hash), n_q(n_q), slots(std::max<size_t>(1, capacity)) {}
+
+        /// @brief Hash of the model the calls are captured from.
+        const uint64_t model_hash;
+
+        /// @brief Number of configuration coordinates of the model.
+        const int n_q;
+
+        /**
+         * @brief Records a call.
+         * @param type Type of the call.
+         * @param start_ns Time the call started, from capture_clock_ns.
+         * @param end_ns Time the call finished, from capture_clock_ns.
+         * @param values Inputs of the call.
+         */
+        void record(const CaptureCallType type,
+                    const int64_t start_ns,
+                    const int64_t end_ns,
+                    const std::vector<double>& values) {
+            const int64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::system_clock::now().time_since_epoch())
+                                             .count();
+            std::lock_guard<std::mutex> lock(mutex);
+            CaptureRecord& slot = slots[next];
+            slot.type           = type;
+            slot.timestamp_ns   = timestamp_ns;
+            slot.duration_ns    = end_ns - start_ns;
+            slot.values.assign(values.begin(), values.end());
+            next  = (next + 1) % slots.size();
+            count = std::min(count + 1, slots.size());
+        }
+
+        /**
+         * @brief Get the captured calls, oldest first.
+         * @return The captured calls.
+         */
+        std::vector<CaptureRecord> records() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<CaptureRecord> result;
+            result.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                result.push_back(slots[(next + slots.size() - count + i) % slots.size()]);
+            }
+            return result;
+        }
+
+        /// @brief Removes all captured calls.
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            next  = 0;
+            count = 0;
+        }
+
+        /**
+         * @brief Writes the captured calls to a binary file. The file holds an 8 byte magic string, the model hash,
+         * number of configuration coordinates and number of records, followed by each record as its type, number of
+         * values, timestamp, duration and values.
+         * @param path Path of the file.
+         * @throws std::runtime_error if the file cannot be written.
+         */
+        void dump(const std::string& path) const {
+            const std::vector<CaptureRecord> calls = records();
+            std::ofstream file(path, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("Error! Could not open [" + path + "] for writing.");
+            }
+            const uint64_t header[3] = {model_hash, uint64_t(n_q), calls.size()};
+            file.write(magic, sizeof(magic));
+            file.write(reinterpret_cast<const char*>(header), sizeof(header));
+            for (const auto& call : calls) {
+                const uint32_t sizes[2] = {static_cast<uint32_t>(call.type), uint32_t(call.values.size())};
+                const int64_t times[2]  = {call.timestamp_ns, call.duration_ns};
+                file.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+                file.write(reinterpret_cast<const char*>(times), sizeof(times));
+                file.write(reinterpret_cast<const char*>(call.values.data()), call.values.size() * sizeof(double));
+            }
+            if (!file) {
+                throw std::runtime_error("Error! Could not write [" + path + "].");
+            }
+        }
+
+        /**
+         * @brief Reads captured calls from a file written by dump.
+         * @param path Path of the file.
+         * @return Capture buffer holding the calls, with capacity equal to the number of calls.
+         * @throws std::runtime_error if the file cannot be read or is not a capture file.
+         */
+        static CaptureBuffer load(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            char file_magic[8];
+            uint64_t header[3];
+            if (!file.read(file_magic, sizeof(file_magic)) || std::memcmp(file_magic, magic, sizeof(magic)) != 0
+                || !file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+                throw std::runtime_error("Error! [" + path + "] is not a capture file.");
+            }
+            CaptureBuffer buffer(header[0], int(header[1]), header[2]);
+            for (uint64_t i = 0; i < header[2]; ++i) {
+                uint32_t sizes[2];
+                int64_t times[2];
+                file.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+                file.read(reinterpret_cast<char*>(times), sizeof(times));
+                CaptureRecord& slot = buffer.slots[i];
+                slot.type           = static_cast<CaptureCallType>(sizes[0]);
+                slot.timestamp_ns   = times[0];
+                slot.duration_ns    = times[1];
+                slot.values.resize(sizes[1]);
+                if (!file.read(reinterpret_cast<char*>(slot.values.data()), slot.values.size() * sizeof(double))) {
+                    throw std::runtime_error("Error! [" + path + "] is truncated.");
+                }
+            }
+            buffer.count = header[2];
+            buffer.next  = 0;
+            return buffer;
+        }
+
+        CaptureBuffer(const CaptureBuffer& other)
+            : model_hash(other.model_hash), n_q(other.n_q), slots(other.slots), next(other.next), count(other.count) {}
+
+    private:
+        /// @brief Magic string identifying capture files and their version.
+        static constexpr char magic[8] = {'T', 'R', 'C', 'A', 'P', 'T', '0', '2'};
+
+        /// @brief Ring of captured calls.
+        std::vector<CaptureRecord> slots;
+
+        /// @brief Index of the slot the next call is recorded into.
+        size_t next = 0;
+
+        /// @brief Number of calls held.
+        size_t count = 0;
+
+        /// @brief Guards the ring.
+        mutable std::mutex mutex;
+    };
+
+}  // namespace tinyrobotics
+
+#endif
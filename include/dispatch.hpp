@@ -0,0 +1,62 @@
+#ifndef TR_DISPATCH_HPP
+#define TR_DISPATCH_HPP
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "parser.hpp"
+
+/// @brief Largest number of configuration coordinates supported when the model size is only known at runtime.
+#ifndef TR_MAX_DISPATCH_NQ
+#define TR_MAX_DISPATCH_NQ 32
+#endif
+
+/** \file dispatch.hpp
+ * @brief Contains functions for calling tinyrobotics algorithms on models whose size is only known at runtime, as
+ * required by language bindings.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Calls a visitor with the number of configuration coordinates as a compile time constant.
+     * @param n Number of configuration coordinates.
+     * @param visitor Visitor called as visitor(std::integral_constant<int, n>()).
+     * @tparam Visitor Type of the visitor.
+     * @tparam nq Number of configuration coordinates to compare against, used for the recursion.
+     * @return The result of the visitor.
+     * @throws std::invalid_argument if n is not within [1, TR_MAX_DISPATCH_NQ].
+     */
+    template <typename Visitor, int nq = 1>
+    decltype(auto) dispatch_nq(const int n, Visitor&& visitor) {
+        if constexpr (nq >= TR_MAX_DISPATCH_NQ) {
+            if (n != nq) {
+                throw std::invalid_argument("Error! Models with " + std::to_string(n)
+                                            + " configuration coordinates are not supported, the maximum is "
+                                            + std::to_string(TR_MAX_DISPATCH_NQ) + ".");
+            }
+            return visitor(std::integral_constant<int, nq>());
+        }
+        else {
+            if (n == nq) {
+                return visitor(std::integral_constant<int, nq>());
+            }
+            return dispatch_nq<Visitor, nq + 1>(n, std::forward<Visitor>(visitor));
+        }
+    }
+
+    /**
+     * @brief Get the number of configuration coordinates of a URDF robot description.
+     * @param path_to_urdf Path to the URDF file.
+     * @tparam Scalar Scalar type used for parsing.
+     * @return Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar = double>
+    int urdf_n_q(const std::string& path_to_urdf) {
+        // The link tree does not depend on the model size, so parse with the smallest one
+        return import_urdf<Scalar, 1>(path_to_urdf).n_q;
+    }
+
+}  // namespace tinyrobotics
+
+#endif
@@ -4,6 +4,7 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
+#include <utility>
 
 #include "kinematics.hpp"
 #include "model.hpp"
@@ -50,6 +51,138 @@ namespace tinyrobotics {
         return m.mass_matrix;
     }
 
+    /**
+     * @brief Compute the mass matrix and its time derivative of the tinyrobotics model in O(n^2). The forward pass
+     * computes the link velocities and the time derivatives of the motion subspaces dS = v x S and link inertias, which
+     * are accumulated with the composite inertias and propagated up the tree alongside each mass matrix column.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return The time derivative of the mass matrix, also stored in m.mass_matrix_derivative, with the mass matrix
+     * stored in m.mass_matrix.
+     */
+    template <typename Scalar, int nq>
+    Eigen::Matrix<Scalar, nq, nq> mass_matrix_derivative(Model<Scalar, nq>& m,
+                                                         const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                         const Eigen::Matrix<Scalar, nq, 1>& dq) {
+        m.mass_matrix.setZero();
+        m.mass_matrix_derivative.setZero();
+
+        for (int i = 0; i < nq; i++) {
+            const Eigen::Matrix<Scalar, 6, 6>& I = m.links[m.q_map[i]].I;
+            m.Xup[i] = homogeneous_to_spatial(m.links[m.q_map[i]].joint.get_parent_to_child_transform(q(i)).inverse());
+            m.vJ     = m.links[m.q_map[i]].joint.S * dq(i);
+            m.v[i]   = m.parent[i] == -1 ? m.vJ : Eigen::Matrix<Scalar, 6, 1>(m.Xup[i] * m.v[m.parent[i]] + m.vJ);
+            m.dS[i]  = cross_spatial(m.v[i]) * m.links[m.q_map[i]].joint.S;
+            m.IC[i]  = I;
+            m.dIC[i] = cross_motion(m.v[i]) * I - I * cross_spatial(m.v[i]);
+        }
+
+        for (int i = nq - 1; i >= 0; i--) {
+            if (m.parent[i] != -1) {
+                m.IC[m.parent[i]] += m.Xup[i].transpose() * m.IC[i] * m.Xup[i];
+                m.dIC[m.parent[i]] += m.Xup[i].transpose() * m.dIC[i] * m.Xup[i];
+            }
+        }
+
+        for (int j = 0; j < nq; j++) {
+            const Eigen::Matrix<Scalar, 6, 1>& Sj = m.links[m.q_map[j]].joint.S;
+            // Column j of the mass matrix is S_i^T f and its derivative dS_i^T f + S_i^T df
+            Eigen::Matrix<Scalar, 6, 1> f  = m.IC[j] * Sj;
+            Eigen::Matrix<Scalar, 6, 1> df = m.dIC[j] * Sj + m.IC[j] * m.dS[j];
+            m.mass_matrix(j, j)            = Sj.dot(f);
+            m.mass_matrix_derivative(j, j) = m.dS[j].dot(f) + Sj.dot(df);
+            int i                          = j;
+            while (m.parent[i] != -1) {
+                f  = m.Xup[i].transpose() * f;
+                df = m.Xup[i].transpose() * df;
+                i  = m.parent[i];
+                const Eigen::Matrix<Scalar, 6, 1>& Si = m.links[m.q_map[i]].joint.S;
+                m.mass_matrix(i, j)                   = Si.dot(f);
+                m.mass_matrix(j, i)                   = m.mass_matrix(i, j);
+                m.mass_matrix_derivative(i, j)        = m.dS[i].dot(f) + Si.dot(df);
+                m.mass_matrix_derivative(j, i)        = m.mass_matrix_derivative(i, j);
+            }
+        }
+
+        return m.mass_matrix_derivative;
+    }
+
+    /**
+     * @brief Compute the mass matrix and its time derivative of the tinyrobotics model together in O(n^2).
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return The mass matrix and its time derivative.
+     */
+    template <typename Scalar, int nq>
+    std::pair<Eigen::Matrix<Scalar, nq, nq>, Eigen::Matrix<Scalar, nq, nq>> mass_matrix_and_derivative(
+        Model<Scalar, nq>& m,
+        const Eigen::Matrix<Scalar, nq, 1>& q,
+        const Eigen::Matrix<Scalar, nq, 1>& dq) {
+        mass_matrix_derivative(m, q, dq);
+        return {m.mass_matrix, m.mass_matrix_derivative};
+    }
+
+    /**
+     * @brief Compute the Coriolis matrix of the tinyrobotics model in O(n^2), such that C(q, dq) dq is the Coriolis and
+     * centrifugal torque and dM/dt - 2 C is skew symmetric. The forward pass computes the composite inertias m.IC and
+     * composite Coriolis matrices m.BC of every subtree, then each column is propagated up the tree as in mass_matrix.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return The Coriolis matrix, also stored in m.coriolis_matrix.
+     */
+    template <typename Scalar, int nq>
+    Eigen::Matrix<Scalar, nq, nq> coriolis_matrix(Model<Scalar, nq>& m,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& dq) {
+        m.coriolis_matrix.setZero();
+
+        for (int i = 0; i < nq; i++) {
+            const Eigen::Matrix<Scalar, 6, 6>& I = m.links[m.q_map[i]].I;
+            m.Xup[i] = homogeneous_to_spatial(m.links[m.q_map[i]].joint.get_parent_to_child_transform(q(i)).inverse());
+            m.vJ     = m.links[m.q_map[i]].joint.S * dq(i);
+            m.v[i]   = m.parent[i] == -1 ? m.vJ : Eigen::Matrix<Scalar, 6, 1>(m.Xup[i] * m.v[m.parent[i]] + m.vJ);
+            m.dS[i]  = cross_spatial(m.v[i]) * m.links[m.q_map[i]].joint.S;
+            m.IC[i]  = I;
+            // B = (v x* I + (I v) x- - I v x) / 2, whose product with v is v x* I v
+            m.BC[i] = Scalar(0.5)
+                      * (cross_motion(m.v[i]) * I + cross_force_bar(Eigen::Matrix<Scalar, 6, 1>(I * m.v[i]))
+                         - I * cross_spatial(m.v[i]));
+        }
+
+        for (int j = nq - 1; j >= 0; j--) {
+            const Eigen::Matrix<Scalar, 6, 1>& Sj = m.links[m.q_map[j]].joint.S;
+            Eigen::Matrix<Scalar, 6, 1> f1        = m.IC[j] * m.dS[j] + m.BC[j] * Sj;
+            Eigen::Matrix<Scalar, 6, 1> f2        = m.IC[j] * Sj;
+            Eigen::Matrix<Scalar, 6, 1> f3        = m.BC[j].transpose() * Sj;
+            m.coriolis_matrix(j, j)               = Sj.dot(f1);
+            int i                                 = j;
+            while (m.parent[i] != -1) {
+                f1 = m.Xup[i].transpose() * f1;
+                f2 = m.Xup[i].transpose() * f2;
+                f3 = m.Xup[i].transpose() * f3;
+                i  = m.parent[i];
+                const Eigen::Matrix<Scalar, 6, 1>& Si = m.links[m.q_map[i]].joint.S;
+                m.coriolis_matrix(i, j)               = Si.dot(f1);
+                m.coriolis_matrix(j, i)               = m.dS[i].dot(f2) + Si.dot(f3);
+            }
+            if (m.parent[j] != -1) {
+                m.IC[m.parent[j]] += m.Xup[j].transpose() * m.IC[j] * m.Xup[j];
+                m.BC[m.parent[j]] += m.Xup[j].transpose() * m.BC[j] * m.Xup[j];
+            }
+        }
+
+        return m.coriolis_matrix;
+    }
+
     /**
      * @brief Compute the kinetic_energy of the tinyrobotics model.
      * @param m tinyrobotics model.
@@ -129,11 +262,134 @@ namespace tinyrobotics {
     }
 
     /**
-     * @brief Compute the forward dynamics of the tinyrobotics model via Articulated-Body Algorithm
+     * @brief Motion of the base link and gravity for dynamics of a robot mounted on a moving base, such as a vehicle or
+     * ship. Spatial vectors are expressed in the base link frame with the angular part stacked above the linear part.
+     * @tparam Scalar type of the tinyrobotics model.
+     */
+    template <typename Scalar>
+    struct BaseState {
+        /// @brief Spatial velocity of the base link.
+        Eigen::Matrix<Scalar, 6, 1> velocity = Eigen::Matrix<Scalar, 6, 1>::Zero();
+
+        /// @brief Spatial acceleration of the base link, the derivative of its spatial velocity. For a base with
+        /// angular velocity w, linear velocity v and classical linear acceleration a the linear part is a - w x v.
+        Eigen::Matrix<Scalar, 6, 1> acceleration = Eigen::Matrix<Scalar, 6, 1>::Zero();
+
+        /// @brief Gravitational acceleration expressed in the base link frame.
+        Eigen::Matrix<Scalar, 3, 1> gravity = Eigen::Matrix<Scalar, 3, 1>(0, 0, -9.81);
+    };
+
+    /**
+     * @brief Get the base state of a fixed base model, at rest under the model's gravity.
+     * @param m tinyrobotics model.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Base state at rest with gravity m.gravity.
+     */
+    template <typename Scalar, int nq>
+    BaseState<Scalar> fixed_base(const Model<Scalar, nq>& m) {
+        BaseState<Scalar> base;
+        base.gravity = m.gravity;
+        return base;
+    }
+
+    /**
+     * @brief Get the spatial acceleration the root links are driven by, the base acceleration minus gravity.
+     * @param base Base state.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @return Spatial acceleration applied at the base in the root recursion step.
+     */
+    template <typename Scalar>
+    Eigen::Matrix<Scalar, 6, 1> base_acceleration_with_gravity(const BaseState<Scalar>& base) {
+        Eigen::Matrix<Scalar, 6, 1> a0 = base.acceleration;
+        a0.template tail<3>() -= base.gravity;
+        return a0;
+    }
+
+    /**
+     * @brief Inputs of a forward dynamics call, as captured for offline replay.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    struct ForwardDynamicsCall {
+        /// @brief Joint configuration
+        Eigen::Matrix<Scalar, nq, 1> q;
+
+        /// @brief Joint velocity
+        Eigen::Matrix<Scalar, nq, 1> dq;
+
+        /// @brief Joint torque
+        Eigen::Matrix<Scalar, nq, 1> tau;
+
+        /// @brief Base motion and gravity
+        BaseState<Scalar> base;
+
+        /// @brief External forces
+        std::vector<Eigen::Matrix<Scalar, 6, 1>> f_ext;
+    };
+
+    /**
+     * @brief Encodes the inputs of a forward dynamics call as doubles for a capture buffer, (q, dq, tau, base velocity,
+     * base acceleration, gravity, f_ext).
+     * @param call Inputs of the call.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return The encoded call.
+     */
+    template <typename Scalar, int nq>
+    std::vector<double> encode_forward_dynamics_call(const ForwardDynamicsCall<Scalar, nq>& call) {
+        std::vector<double> values;
+        values.reserve(3 * nq + 15 + 6 * call.f_ext.size());
+        for (const auto* v : {&call.q, &call.dq, &call.tau}) {
+            values.insert(values.end(), v->data(), v->data() + nq);
+        }
+        values.insert(values.end(), call.base.velocity.data(), call.base.velocity.data() + 6);
+        values.insert(values.end(), call.base.acceleration.data(), call.base.acceleration.data() + 6);
+        values.insert(values.end(), call.base.gravity.data(), call.base.gravity.data() + 3);
+        for (const auto& f : call.f_ext) {
+            values.insert(values.end(), f.data(), f.data() + 6);
+        }
+        return values;
+    }
+
+    /**
+     * @brief Decodes the inputs of a forward dynamics call encoded by encode_forward_dynamics_call.
+     * @param values The encoded call.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Inputs of the call.
+     * @throws std::invalid_argument if the values do not match the model.
+     */
+    template <typename Scalar, int nq>
+    ForwardDynamicsCall<Scalar, nq> decode_forward_dynamics_call(const std::vector<double>& values) {
+        if (values.size() < 3 * nq + 15 || (values.size() - 3 * nq - 15) % 6 != 0) {
+            throw std::invalid_argument("Error! Captured forward dynamics call does not match the model.");
+        }
+        ForwardDynamicsCall<Scalar, nq> call;
+        call.q   = Eigen::Map<const Eigen::Matrix<double, nq, 1>>(values.data()).template cast<Scalar>();
+        call.dq  = Eigen::Map<const Eigen::Matrix<double, nq, 1>>(values.data() + nq).template cast<Scalar>();
+        call.tau = Eigen::Map<const Eigen::Matrix<double, nq, 1>>(values.data() + 2 * nq).template cast<Scalar>();
+        call.base.velocity =
+            Eigen::Map<const Eigen::Matrix<double, 6, 1>>(values.data() + 3 * nq).template cast<Scalar>();
+        call.base.acceleration =
+            Eigen::Map<const Eigen::Matrix<double, 6, 1>>(values.data() + 3 * nq + 6).template cast<Scalar>();
+        call.base.gravity =
+            Eigen::Map<const Eigen::Matrix<double, 3, 1>>(values.data() + 3 * nq + 12).template cast<Scalar>();
+        for (size_t i = 3 * nq + 15; i < values.size(); i += 6) {
+            call.f_ext.push_back(Eigen::Map<const Eigen::Matrix<double, 6, 1>>(values.data() + i).template cast<Scalar>());
+        }
+        return call;
+    }
+
+    /**
+     * @brief Compute the forward dynamics of the tinyrobotics model on a moving base via Articulated-Body Algorithm.
+     * The base motion and gravity are applied in the root recursion step.
      * @param m tinyrobotics model.
      * @param q Joint configuration of the robot.
      * @param dq Joint velocity of the robot.
      * @param tau Joint torque of the robot.
+     * @param base Motion of the base link and gravity, expressed in the base link frame.
      * @param f_ext External forces acting on the robot.
      * @return Joint accelerations of the model.
      */
@@ -142,57 +398,83 @@ namespace tinyrobotics {
                                                   const Eigen::Matrix<Scalar, nq, 1>& q,
                                                   const Eigen::Matrix<Scalar, nq, 1>& dq,
                                                   const Eigen::Matrix<Scalar, nq, 1>& tau,
+                                                  const BaseState<Scalar>& base,
                                                   const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
-        for (int i = 0; i < nq; i++) {
-            // Compute the joint transform and motion subspace matrices
-            m.vJ = m.links[m.q_map[i]].joint.S * dq(i);
-            // Compute the spatial transform from the parent to the current body
-            m.Xup[i] = homogeneous_to_spatial(m.links[m.q_map[i]].joint.get_parent_to_child_transform(q(i)).inverse());
-            // Check if the m.parent link is the base link
-            if (m.parent[i] == -1) {
-                m.v[i] = m.vJ;
-                m.c[i] = Eigen::Matrix<Scalar, 6, 1>::Zero();
-            }
-            else {
-                m.v[i] = m.Xup[i] * m.v[m.parent[i]] + m.vJ;
+        const int64_t capture_start_ns = m.capture != nullptr ? capture_clock_ns() : 0;
+        const Eigen::Matrix<Scalar, 6, 1> a0 = base_acceleration_with_gravity(base);
+        // Forward pass computing velocities and bias forces
+        {
+            TR_TRACE_SPAN("forward_dynamics forward pass");
+            for (int i = 0; i < nq; i++) {
+                // Compute the joint transform and motion subspace matrices
+                m.vJ = m.links[m.q_map[i]].joint.S * dq(i);
+                // Compute the spatial transform from the parent to the current body
+                m.Xup[i] =
+                    homogeneous_to_spatial(m.links[m.q_map[i]].joint.get_parent_to_child_transform(q(i)).inverse());
+                // Check if the m.parent link is the base link
+                if (m.parent[i] == -1) {
+                    m.v[i] = m.Xup[i] * base.velocity + m.vJ;
+                }
+                else {
+                    m.v[i] = m.Xup[i] * m.v[m.parent[i]] + m.vJ;
+                }
                 m.c[i] = cross_spatial(m.v[i]) * m.vJ;
+                m.IA[i] = m.links[m.q_map[i]].I;
+                m.pA[i] = cross_motion(m.v[i]) * m.IA[i] * m.v[i];
             }
-            m.IA[i] = m.links[m.q_map[i]].I;
-            m.pA[i] = cross_motion(m.v[i]) * m.IA[i] * m.v[i];
-        }
 
-        // Apply external forces if non-zero
-        if (!f_ext.empty()) {
-            m.pA = apply_external_forces(m, m.Xup, m.pA, f_ext);
+            // Apply external forces if non-zero
+            if (!f_ext.empty()) {
+                m.pA = apply_external_forces(m, m.Xup, m.pA, f_ext);
+            }
         }
 
-        for (int i = nq - 1; i >= 0; i--) {
-            m.U[i] = m.IA[i] * m.links[m.q_map[i]].joint.S;
-            m.d[i] = m.links[m.q_map[i]].joint.S.transpose() * m.U[i];
-            m.u[i] = Scalar(tau(i) - m.links[m.q_map[i]].joint.S.transpose() * m.pA[i]);
-            if (m.parent[i] != -1) {
-                Eigen::Matrix<Scalar, 6, 6> Ia = m.IA[i] - (m.U[i] / m.d[i]) * m.U[i].transpose();
-                Eigen::Matrix<Scalar, 6, 1> pa = m.pA[i] + Ia * m.c[i] + m.U[i] * (m.u[i] / m.d[i]);
-                m.IA[m.parent[i]] += m.Xup[i].transpose() * Ia * m.Xup[i];
-                m.pA[m.parent[i]] += m.Xup[i].transpose() * pa;
+        // Backward pass computing articulated inertias
+        {
+            TR_TRACE_SPAN("forward_dynamics backward pass");
+            for (int i = nq - 1; i >= 0; i--) {
+                m.U[i] = m.IA[i] * m.links[m.q_map[i]].joint.S;
+                m.d[i] = m.links[m.q_map[i]].joint.S.transpose() * m.U[i];
+                m.u[i] = Scalar(tau(i) - m.links[m.q_map[i]].joint.S.transpose() * m.pA[i]);
+                if (m.parent[i] != -1) {
+                    Eigen::Matrix<Scalar, 6, 6> Ia = m.IA[i] - (m.U[i] / m.d[i]) * m.U[i].transpose();
+                    Eigen::Matrix<Scalar, 6, 1> pa = m.pA[i] + Ia * m.c[i] + m.U[i] * (m.u[i] / m.d[i]);
+                    m.IA[m.parent[i]] += m.Xup[i].transpose() * Ia * m.Xup[i];
+                    m.pA[m.parent[i]] += m.Xup[i].transpose() * pa;
+                }
             }
         }
 
-        for (int i = 0; i < nq; i++) {
-            if (m.parent[i] == -1) {
-                m.a[i] = m.Xup[i] * -m.spatial_gravity + m.c[i];
+        // Forward pass computing accelerations
+        {
+            TR_TRACE_SPAN("forward_dynamics acceleration pass");
+            for (int i = 0; i < nq; i++) {
+                if (m.parent[i] == -1) {
+                    m.a[i] = m.Xup[i] * a0 + m.c[i];
+                }
+                else {
+                    m.a[i] = m.Xup[i] * m.a[m.parent[i]] + m.c[i];
+                }
+                m.ddq(i) = (m.u[i] - m.U[i].transpose() * m.a[i]) / m.d[i];
+                m.a[i]   = m.a[i] + m.links[m.q_map[i]].joint.S * m.ddq(i);
             }
-            else {
-                m.a[i] = m.Xup[i] * m.a[m.parent[i]] + m.c[i];
+        }
+
+        // Record the inputs and duration of the call if capture is enabled
+        if constexpr (std::is_arithmetic<Scalar>::value) {
+            if (m.capture != nullptr) {
+                const int64_t end_ns = capture_clock_ns();
+                m.capture->record(CaptureCallType::FORWARD_DYNAMICS,
+                                  capture_start_ns,
+                                  end_ns,
+                                  encode_forward_dynamics_call(ForwardDynamicsCall<Scalar, nq>{q, dq, tau, base, f_ext}));
             }
-            m.ddq(i) = (m.u[i] - m.U[i].transpose() * m.a[i]) / m.d[i];
-            m.a[i]   = m.a[i] + m.links[m.q_map[i]].joint.S * m.ddq(i);
         }
         return m.ddq;
     }
 
     /**
-     * @brief Compute the forward dynamics of the tinyrobotics model via Composite-Rigid-Body Algorithm
+     * @brief Compute the forward dynamics of the tinyrobotics model via Articulated-Body Algorithm
      * @param m tinyrobotics model.
      * @param q Joint configuration of the robot.
      * @param dq Joint velocity of the robot.
@@ -201,11 +483,33 @@ namespace tinyrobotics {
      * @return Joint accelerations of the model.
      */
     template <typename Scalar, int nq>
+    Eigen::Matrix<Scalar, nq, 1> forward_dynamics(Model<Scalar, nq>& m,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& dq,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& tau,
+                                                  const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        return forward_dynamics(m, q, dq, tau, fixed_base(m), f_ext);
+    }
+
+    /**
+     * @brief Compute the forward dynamics of the tinyrobotics model on a moving base via Composite-Rigid-Body
+     * Algorithm. The base motion and gravity are applied in the root recursion step.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param tau Joint torque of the robot.
+     * @param base Motion of the base link and gravity, expressed in the base link frame.
+     * @param f_ext External forces acting on the robot.
+     * @return Joint accelerations of the model.
+     */
+    template <typename Scalar, int nq>
     Eigen::Matrix<Scalar, nq, 1> forward_dynamics_crb(Model<Scalar, nq>& m,
                                                       const Eigen::Matrix<Scalar, nq, 1>& q,
                                                       const Eigen::Matrix<Scalar, nq, 1>& dq,
                                                       const Eigen::Matrix<Scalar, nq, 1>& tau,
+                                                      const BaseState<Scalar>& base,
                                                       const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        const Eigen::Matrix<Scalar, 6, 1> a0 = base_acceleration_with_gravity(base);
         for (int i = 0; i < nq; i++) {
             // Compute the joint transform and motion subspace matrices
             m.vJ = m.links[m.q_map[i]].joint.S * dq(i);
@@ -213,8 +517,8 @@ namespace tinyrobotics {
             m.Xup[i] = homogeneous_to_spatial(m.links[m.q_map[i]].joint.get_parent_to_child_transform(q(i)).inverse());
             // Check if the m.parent link is the base link
             if (m.parent[i] == -1) {
-                m.v[i] = m.vJ;
-                m.a[i] = m.Xup[i] * -m.spatial_gravity;
+                m.v[i] = m.Xup[i] * base.velocity + m.vJ;
+                m.a[i] = m.Xup[i] * a0 + cross_spatial(m.v[i]) * m.vJ;
             }
             else {
                 m.v[i] = m.Xup[i] * m.v[m.parent[i]] + m.vJ;
@@ -226,7 +530,7 @@ namespace tinyrobotics {
 
         // Apply external forces if non-zero
         if (!f_ext.empty()) {
-            m.fvp = apply_external_forces(m, m.Xup, m.pA, f_ext);
+            m.fvp = apply_external_forces(m, m.Xup, m.fvp, f_ext);
         }
 
         for (int i = nq - 1; i >= 0; i--) {
@@ -258,10 +562,31 @@ namespace tinyrobotics {
     }
 
     /**
-     * @brief Compute the inverse dynamics of a tinyrobotics model
+     * @brief Compute the forward dynamics of the tinyrobotics model via Composite-Rigid-Body Algorithm
      * @param m tinyrobotics model.
      * @param q Joint configuration of the robot.
      * @param dq Joint velocity of the robot.
+     * @param tau Joint torque of the robot.
+     * @param f_ext External forces acting on the robot.
+     * @return Joint accelerations of the model.
+     */
+    template <typename Scalar, int nq>
+    Eigen::Matrix<Scalar, nq, 1> forward_dynamics_crb(Model<Scalar, nq>& m,
+                                                      const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                      const Eigen::Matrix<Scalar, nq, 1>& dq,
+                                                      const Eigen::Matrix<Scalar, nq, 1>& tau,
+                                                      const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        return forward_dynamics_crb(m, q, dq, tau, fixed_base(m), f_ext);
+    }
+
+    /**
+     * @brief Compute the inverse dynamics of a tinyrobotics model on a moving base. The base motion and gravity are
+     * applied in the root recursion step.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param ddq Joint acceleration of the robot.
+     * @param base Motion of the base link and gravity, expressed in the base link frame.
      * @param f_ext External forces acting on the robot.
      * @return tau
      */
@@ -270,7 +595,9 @@ namespace tinyrobotics {
                                                   const Eigen::Matrix<Scalar, nq, 1>& q,
                                                   const Eigen::Matrix<Scalar, nq, 1>& dq,
                                                   const Eigen::Matrix<Scalar, nq, 1>& ddq,
+                                                  const BaseState<Scalar>& base,
                                                   const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        const Eigen::Matrix<Scalar, 6, 1> a0 = base_acceleration_with_gravity(base);
         for (int i = 0; i < nq; i++) {
             // Compute the joint transform and motion subspace matrices
             m.vJ = m.links[m.q_map[i]].joint.S * dq(i);
@@ -278,8 +605,8 @@ namespace tinyrobotics {
             m.Xup[i] = homogeneous_to_spatial(m.links[m.q_map[i]].joint.get_parent_to_child_transform(q(i)).inverse());
             // Check if the m.parent link is the base link
             if (m.parent[i] == -1) {
-                m.v[i] = m.vJ;
-                m.a[i] = m.Xup[i] * -m.spatial_gravity + m.links[m.q_map[i]].joint.S * ddq(i);
+                m.v[i] = m.Xup[i] * base.velocity + m.vJ;
+                m.a[i] = m.Xup[i] * a0 + m.links[m.q_map[i]].joint.S * ddq(i) + cross_spatial(m.v[i]) * m.vJ;
             }
             else {
                 m.v[i] = m.Xup[i] * m.v[m.parent[i]] + m.vJ;
@@ -291,7 +618,7 @@ namespace tinyrobotics {
 
         // Apply external forces if non-zero
         if (!f_ext.empty()) {
-            m.fvp = apply_external_forces(m, m.Xup, m.pA, f_ext);
+            m.fvp = apply_external_forces(m, m.Xup, m.fvp, f_ext);
         }
 
         for (int i = nq - 1; i >= 0; i--) {
@@ -303,6 +630,248 @@ namespace tinyrobotics {
         return m.tau;
     }
 
+    /**
+     * @brief Compute the inverse dynamics of a tinyrobotics model
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param ddq Joint acceleration of the robot.
+     * @param f_ext External forces acting on the robot.
+     * @return tau
+     */
+    template <typename Scalar, int nq>
+    Eigen::Matrix<Scalar, nq, 1> inverse_dynamics(Model<Scalar, nq>& m,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& dq,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& ddq,
+                                                  const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        return inverse_dynamics(m, q, dq, ddq, fixed_base(m), f_ext);
+    }
+
+    /**
+     * @brief Compute the wrenches transmitted through the joints of all links of a tinyrobotics model on a moving base,
+     * including fixed joints, from one inverse dynamics pass. Entry i is the wrench the parent of link i applies to
+     * link i and its descendants through the joint of link i, and the entry of the base link is the wrench the base
+     * link applies to the rest of the robot. The wrenches are stored in m.joint_wrenches, and the link transforms in
+     * m.forward_kinematics, without allocating after the first call.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param ddq Joint acceleration of the robot.
+     * @param base Motion of the base link and gravity, expressed in the base link frame.
+     * @param frame Reference frame in which the wrenches are expressed, LOCAL about the origin of each link in its
+     * frame, WORLD about the base link origin in its frame, or LOCAL_WORLD_ALIGNED about the origin of each link in
+     * the base link axes.
+     * @param f_ext External forces acting on the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Joint wrenches [torque; force], indexed by link.
+     */
+    template <typename Scalar, int nq>
+    const std::vector<Eigen::Matrix<Scalar, 6, 1>>& joint_wrenches(
+        Model<Scalar, nq>& m,
+        const Eigen::Matrix<Scalar, nq, 1>& q,
+        const Eigen::Matrix<Scalar, nq, 1>& dq,
+        const Eigen::Matrix<Scalar, nq, 1>& ddq,
+        const BaseState<Scalar>& base,
+        const ReferenceFrame frame                            = ReferenceFrame::LOCAL,
+        const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        // Wrenches through the non-fixed joints, accumulated over their subtrees in m.fvp
+        inverse_dynamics(m, q, dq, ddq, base, f_ext);
+        const Eigen::Matrix<Scalar, 6, 1> a0 = base_acceleration_with_gravity(base);
+
+        // Link transforms, parents come before their children in the link vector
+        const int n_links = m.links.size();
+        m.forward_kinematics.resize(n_links, Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity());
+        m.joint_wrenches.resize(n_links, Eigen::Matrix<Scalar, 6, 1>::Zero());
+        for (int l = 0; l < n_links; l++) {
+            const Link<Scalar>& link = m.links[l];
+            m.forward_kinematics[l]  = link.joint.parent_transform;
+            if (link.joint.idx != -1) {
+                m.forward_kinematics[l] = m.forward_kinematics[l] * link.joint.get_joint_transform(q(link.joint.idx));
+            }
+            if (link.parent != -1) {
+                m.forward_kinematics[l] = m.forward_kinematics[link.parent] * m.forward_kinematics[l];
+            }
+        }
+
+        // Non-fixed joints take their subtree wrench, links with a fixed joint start from the wrench moving their own
+        // inertia with the nearest ancestor link with a non-fixed joint
+        for (int l = 0; l < n_links; l++) {
+            const Link<Scalar>& link = m.links[l];
+            m.joint_wrenches[l].setZero();
+            if (l == m.base_link_idx) {
+                continue;
+            }
+            int body = l;
+            while (body != m.base_link_idx && m.links[body].joint.type == JointType::FIXED) {
+                body = m.links[body].parent;
+            }
+            int i = -1;
+            for (int j = 0; j < nq; j++) {
+                if (m.q_map[j] == body) {
+                    i = j;
+                }
+            }
+            if (body == l) {
+                m.joint_wrenches[l] = m.fvp[i];
+                continue;
+            }
+            const Eigen::Matrix<Scalar, 6, 6> X =
+                homogeneous_to_spatial(Eigen::Transform<Scalar, 3, Eigen::Isometry>(
+                    m.forward_kinematics[l].inverse() * m.forward_kinematics[body]));
+            const Eigen::Matrix<Scalar, 6, 1> v = X * (i == -1 ? base.velocity : m.v[i]);
+            const Eigen::Matrix<Scalar, 6, 1> a = X * (i == -1 ? a0 : m.a[i]);
+            const Eigen::Matrix<Scalar, 3, 1> c = link.center_of_mass.translation();
+            const Eigen::Matrix<Scalar, 6, 6> I = inertia_to_spatial(link.mass, c, link.inertia);
+            m.joint_wrenches[l] = I * a + cross_motion(v) * I * v;
+        }
+
+        // Accumulate children into the links with a fixed joint and the base link, whose wrenches are not already
+        // accumulated by the inverse dynamics
+        for (int l = n_links - 1; l >= 0; l--) {
+            const int parent = m.links[l].parent;
+            if (parent != -1 && (parent == m.base_link_idx || m.links[parent].joint.type == JointType::FIXED)) {
+                const Eigen::Matrix<Scalar, 6, 6> X =
+                    homogeneous_to_spatial(Eigen::Transform<Scalar, 3, Eigen::Isometry>(
+                        m.forward_kinematics[l].inverse() * m.forward_kinematics[parent]));
+                m.joint_wrenches[parent] += X.transpose() * m.joint_wrenches[l];
+            }
+        }
+
+        // Express the wrenches in the requested frame
+        if (frame != ReferenceFrame::LOCAL) {
+            for (int l = 0; l < n_links; l++) {
+                const Eigen::Transform<Scalar, 3, Eigen::Isometry>& H = m.forward_kinematics[l];
+                const Eigen::Matrix<Scalar, 3, 1> torque = H.linear() * m.joint_wrenches[l].template head<3>();
+                const Eigen::Matrix<Scalar, 3, 1> force  = H.linear() * m.joint_wrenches[l].template tail<3>();
+                m.joint_wrenches[l].template head<3>() =
+                    frame == ReferenceFrame::WORLD ? Eigen::Matrix<Scalar, 3, 1>(torque + H.translation().cross(force))
+                                                   : torque;
+                m.joint_wrenches[l].template tail<3>() = force;
+            }
+        }
+        return m.joint_wrenches;
+    }
+
+    /**
+     * @brief Compute the wrenches transmitted through the joints of all links of a tinyrobotics model, including fixed
+     * joints, from one inverse dynamics pass.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param ddq Joint acceleration of the robot.
+     * @param frame Reference frame in which the wrenches are expressed.
+     * @param f_ext External forces acting on the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Joint wrenches [torque; force], indexed by link.
+     */
+    template <typename Scalar, int nq>
+    const std::vector<Eigen::Matrix<Scalar, 6, 1>>& joint_wrenches(
+        Model<Scalar, nq>& m,
+        const Eigen::Matrix<Scalar, nq, 1>& q,
+        const Eigen::Matrix<Scalar, nq, 1>& dq,
+        const Eigen::Matrix<Scalar, nq, 1>& ddq,
+        const ReferenceFrame frame                            = ReferenceFrame::LOCAL,
+        const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        return joint_wrenches(m, q, dq, ddq, fixed_base(m), frame, f_ext);
+    }
+
+    /**
+     * @brief Compute the readings of all sensors of a tinyrobotics model on a moving base from one inverse dynamics
+     * pass. A sensor on a link with a fixed joint moves with the nearest ancestor link with a non-fixed joint, and a
+     * force-torque sensor reads the wrench transmitted into that link through its joint, or from the base link into
+     * the robot if the sensor is on the base link. The readings are also stored in m.sensor_readings.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param ddq Joint acceleration of the robot.
+     * @param base Motion of the base link and gravity, expressed in the base link frame.
+     * @param f_ext External forces acting on the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Readings of the sensors, [angular velocity; specific force] for an IMU and [torque; force] for a
+     * force-torque sensor, in the sensor frame.
+     */
+    template <typename Scalar, int nq>
+    std::vector<Eigen::Matrix<Scalar, 6, 1>> sensor_readings(
+        Model<Scalar, nq>& m,
+        const Eigen::Matrix<Scalar, nq, 1>& q,
+        const Eigen::Matrix<Scalar, nq, 1>& dq,
+        const Eigen::Matrix<Scalar, nq, 1>& ddq,
+        const BaseState<Scalar>& base,
+        const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        // Link velocities, accelerations (including gravity) and transmitted wrenches
+        inverse_dynamics(m, q, dq, ddq, base, f_ext);
+        const Eigen::Matrix<Scalar, 6, 1> a0 = base_acceleration_with_gravity(base);
+
+        m.sensor_readings.resize(m.sensors.size());
+        for (size_t s = 0; s < m.sensors.size(); s++) {
+            // Find the link the sensor moves with and the pose of the sensor in its frame
+            int link                                       = m.sensors[s].link;
+            Eigen::Transform<Scalar, 3, Eigen::Isometry> T = m.sensors[s].origin;
+            while (link != m.base_link_idx && m.links[link].joint.type == JointType::FIXED) {
+                T    = m.links[link].joint.get_parent_to_child_transform(0) * T;
+                link = m.links[link].parent;
+            }
+            int i = -1;
+            for (int j = 0; j < nq; j++) {
+                if (m.q_map[j] == link) {
+                    i = j;
+                }
+            }
+
+            if (m.sensors[s].type == SensorType::IMU) {
+                // Express the link motion in the sensor frame, the specific force is the classical acceleration of the
+                // sensor origin minus gravity
+                const Eigen::Matrix<Scalar, 6, 6> X  = homogeneous_to_spatial(T.inverse());
+                const Eigen::Matrix<Scalar, 6, 1> vs = X * (i == -1 ? base.velocity : m.v[i]);
+                const Eigen::Matrix<Scalar, 6, 1> as = X * (i == -1 ? a0 : m.a[i]);
+                m.sensor_readings[s].template head<3>() = vs.template head<3>();
+                m.sensor_readings[s].template tail<3>() =
+                    as.template tail<3>() + vs.template head<3>().cross(vs.template tail<3>());
+            }
+            else {
+                // Sum the wrenches transmitted into the root links if the sensor is on the base link
+                Eigen::Matrix<Scalar, 6, 1> f = Eigen::Matrix<Scalar, 6, 1>::Zero();
+                if (i == -1) {
+                    for (int j = 0; j < nq; j++) {
+                        if (m.parent[j] == -1) {
+                            f += m.Xup[j].transpose() * m.fvp[j];
+                        }
+                    }
+                }
+                else {
+                    f = m.fvp[i];
+                }
+                m.sensor_readings[s] = homogeneous_to_spatial(T).transpose() * f;
+            }
+        }
+        return m.sensor_readings;
+    }
+
+    /**
+     * @brief Compute the readings of all sensors of a tinyrobotics model from one inverse dynamics pass.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param ddq Joint acceleration of the robot.
+     * @param f_ext External forces acting on the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Readings of the sensors in the sensor frame.
+     */
+    template <typename Scalar, int nq>
+    std::vector<Eigen::Matrix<Scalar, 6, 1>> sensor_readings(
+        Model<Scalar, nq>& m,
+        const Eigen::Matrix<Scalar, nq, 1>& q,
+        const Eigen::Matrix<Scalar, nq, 1>& dq,
+        const Eigen::Matrix<Scalar, nq, 1>& ddq,
+        const std::vector<Eigen::Matrix<Scalar, 6, 1>>& f_ext = {}) {
+        return sensor_readings(m, q, dq, ddq, fixed_base(m), f_ext);
+    }
+
     /**
      * @brief Compute the gravity vector (generalized gravity forces) for the tinyrobotics model.
      * @param m The tinyrobotics model.
@@ -0,0 +1,504 @@
+#ifndef TR_INTEGRATOR_HPP
+#define TR_INTEGRATOR_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "dynamics.hpp"
+#include "model.hpp"
+#include "observer.hpp"
+#include "parallel.hpp"
+
+/** \file integrator.hpp
+ * @brief Contains integrators for simulating a tinyrobotics model over time.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Options for the variational integrator.
+     * @tparam Scalar type of the tinyrobotics model.
+     */
+    template <typename Scalar>
+    struct VariationalIntegratorOptions {
+        /// @brief Maximum number of Newton iterations per step.
+        int max_iterations = 20;
+
+        /// @brief Tolerance on the norm of the discrete Euler-Lagrange residual [N m s].
+        Scalar tolerance = 1e-10;
+    };
+
+    /**
+     * @brief Variational integrator solving the discrete Euler-Lagrange equations of the midpoint discrete Lagrangian
+     * L_d(q_k, q_k+1) = h L((q_k + q_k+1) / 2, (q_k+1 - q_k) / h) in position-momentum form, with the joint torques
+     * applied through the discrete Lagrange-d'Alembert principle. Being symplectic, its energy error stays bounded
+     * over long horizons instead of drifting, which permits much larger steps than explicit integration of
+     * forward_dynamics.
+     *
+     * Each step solves p_k + h/2 (C^T dq - g + tau) - M dq = 0 for q_k+1, with M, C^T dq and g evaluated at the
+     * midpoint and dq = (q_k+1 - q_k) / h, by Newton iterations. The residual terms come from one momentum_terms pass
+     * per iteration, and its jacobian from nq more passes by forward differences, formed once per step.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    class VariationalIntegrator {
+    public:
+        /**
+         * @brief Constructs an integrator with its own copy of the model.
+         * @param model tinyrobotics model.
+         * @param options Variational integrator options.
+         */
+        VariationalIntegrator(
+            const Model<Scalar, nq>& model,
+            const VariationalIntegratorOptions<Scalar>& options = VariationalIntegratorOptions<Scalar>())
+            : model(model), options(options) {}
+
+        /**
+         * @brief Resets the state of the integrator.
+         * @param q Joint configuration of the robot.
+         * @param dq Joint velocity of the robot.
+         */
+        void reset(const Eigen::Matrix<Scalar, nq, 1>& q, const Eigen::Matrix<Scalar, nq, 1>& dq) {
+            q_k = q;
+            p_k = mass_matrix(model, q) * dq;
+        }
+
+        /**
+         * @brief Advances the state by one step.
+         * @param tau Joint torque applied over the step.
+         * @param h Step size [s].
+         * @return Joint configuration at the end of the step.
+         */
+        const Eigen::Matrix<Scalar, nq, 1>& step(const Eigen::Matrix<Scalar, nq, 1>& tau, const Scalar h) {
+            // Initial guess from the current momentum
+            Eigen::Matrix<Scalar, nq, 1> dq     = mass_matrix(model, q_k).ldlt().solve(p_k);
+            Eigen::Matrix<Scalar, nq, 1> q_next = q_k + h * dq;
+
+            const Scalar sqrt_epsilon = std::sqrt(std::numeric_limits<Scalar>::epsilon());
+            for (n_iterations = 0;; ++n_iterations) {
+                dq = (q_next - q_k) / h;
+                const Eigen::Matrix<Scalar, nq, 1> q_mid = (q_k + q_next) / 2;
+                terms                                    = momentum_terms(model, q_mid, dq);
+                residual = p_k + h / 2 * (terms.coriolis_transpose - terms.gravity + tau) - terms.momentum;
+                if (residual.norm() < options.tolerance || n_iterations == options.max_iterations) {
+                    break;
+                }
+                // Jacobian of the residual with respect to q_k+1 by forward differences of the momentum terms, kept
+                // for the remaining iterations of the step
+                if (n_iterations == 0) {
+                    for (int j = 0; j < nq; j++) {
+                        const Scalar eps = sqrt_epsilon * std::max(Scalar(1), std::abs(q_next(j)));
+                        Eigen::Matrix<Scalar, nq, 1> q_eps = q_next;
+                        q_eps(j) += eps;
+                        const MomentumTerms<Scalar, nq> terms_eps =
+                            momentum_terms(model,
+                                           Eigen::Matrix<Scalar, nq, 1>((q_k + q_eps) / 2),
+                                           Eigen::Matrix<Scalar, nq, 1>((q_eps - q_k) / h));
+                        jacobian.col(j) = (h / 2 * (terms_eps.coriolis_transpose - terms_eps.gravity)
+                                           - terms_eps.momentum - h / 2 * (terms.coriolis_transpose - terms.gravity)
+                                           + terms.momentum)
+                                          / eps;
+                    }
+                    lu.compute(jacobian);
+                }
+                q_next -= lu.solve(residual);
+            }
+
+            // Momentum at the end of the step
+            q_k = q_next;
+            p_k = terms.momentum + h / 2 * (terms.coriolis_transpose - terms.gravity + tau);
+            return q_k;
+        }
+
+        /// @brief Get the joint configuration.
+        const Eigen::Matrix<Scalar, nq, 1>& q() const {
+            return q_k;
+        }
+
+        /// @brief Get the generalized momentum.
+        const Eigen::Matrix<Scalar, nq, 1>& momentum() const {
+            return p_k;
+        }
+
+        /// @brief Get the joint velocity, recovered from the momentum as M(q)^-1 p.
+        Eigen::Matrix<Scalar, nq, 1> dq() {
+            return mass_matrix(model, q_k).ldlt().solve(p_k);
+        }
+
+        /// @brief Get the number of Newton iterations of the last step.
+        int iterations() const {
+            return n_iterations;
+        }
+
+        /// @brief Get the norm of the discrete Euler-Lagrange residual of the last step.
+        Scalar residual_norm() const {
+            return residual.norm();
+        }
+
+    private:
+        /// @brief Model used as the workspace of the recursive passes.
+        Model<Scalar, nq> model;
+
+        /// @brief Variational integrator options.
+        VariationalIntegratorOptions<Scalar> options;
+
+        /// @brief Joint configuration.
+        Eigen::Matrix<Scalar, nq, 1> q_k = Eigen::Matrix<Scalar, nq, 1>::Zero();
+
+        /// @brief Generalized momentum.
+        Eigen::Matrix<Scalar, nq, 1> p_k = Eigen::Matrix<Scalar, nq, 1>::Zero();
+
+        /// @brief Momentum terms at the midpoint of the last Newton iteration.
+        MomentumTerms<Scalar, nq> terms;
+
+        /// @brief Jacobian of the discrete Euler-Lagrange residual with respect to the next configuration.
+        Eigen::Matrix<Scalar, nq, nq> jacobian = Eigen::Matrix<Scalar, nq, nq>::Zero();
+
+        /// @brief LU decomposition of the jacobian.
+        Eigen::PartialPivLU<Eigen::Matrix<Scalar, nq, nq>> lu;
+
+        /// @brief Discrete Euler-Lagrange residual of the last Newton iteration.
+        Eigen::Matrix<Scalar, nq, 1> residual = Eigen::Matrix<Scalar, nq, 1>::Zero();
+
+        /// @brief Number of Newton iterations of the last step.
+        int n_iterations = 0;
+    };
+
+    /**
+     * @brief Options for the Dormand-Prince integrator.
+     * @tparam Scalar type of the tinyrobotics model.
+     */
+    template <typename Scalar>
+    struct DormandPrinceOptions {
+        /// @brief Relative tolerance on the local error of each state component.
+        Scalar relative_tolerance = 1e-6;
+
+        /// @brief Absolute tolerance on the local error of each state component.
+        Scalar absolute_tolerance = 1e-8;
+
+        /// @brief Size of the first step [s].
+        Scalar initial_step = 1e-3;
+
+        /// @brief Smallest step size before integration fails [s].
+        Scalar min_step = 1e-12;
+
+        /// @brief Largest step size [s].
+        Scalar max_step = 0.1;
+
+        /// @brief Safety factor applied to the optimal step size.
+        Scalar safety = 0.9;
+    };
+
+    /**
+     * @brief Adaptive step Dormand-Prince 5(4) integrator of forward_dynamics, with the state x = [q; dq]. The local
+     * error is estimated from the embedded 4th order solution and controls the step size. The last stage of an accepted
+     * step is the first stage of the next one (first same as last), so each accepted step costs six forward dynamics
+     * calls instead of seven. A 4th order dense output interpolates the state anywhere within the last step, so logs
+     * can be sampled at any rate without stepping at it. All stage buffers are preallocated.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    class DormandPrinceIntegrator {
+    public:
+        /// @brief State of the integrator, the joint configuration stacked on the joint velocity.
+        using State = Eigen::Matrix<Scalar, 2 * nq, 1>;
+
+        /**
+         * @brief Constructs an integrator with its own copy of the model.
+         * @param model tinyrobotics model.
+         * @param options Dormand-Prince options.
+         */
+        DormandPrinceIntegrator(const Model<Scalar, nq>& model,
+                                const DormandPrinceOptions<Scalar>& options = DormandPrinceOptions<Scalar>())
+            : model(model), options(options) {}
+
+        /**
+         * @brief Resets the state of the integrator.
+         * @param q Joint configuration of the robot.
+         * @param dq Joint velocity of the robot.
+         * @param t Time of the state [s].
+         */
+        void reset(const Eigen::Matrix<Scalar, nq, 1>& q,
+                   const Eigen::Matrix<Scalar, nq, 1>& dq,
+                   const Scalar t = 0) {
+            x << q, dq;
+            time       = t;
+            time_prev  = t;
+            h          = options.initial_step;
+            k_valid    = false;
+            dense_prev = x;
+            dense.fill(State::Zero());
+            n_evaluations = 0;
+            n_accepted    = 0;
+            n_rejected    = 0;
+        }
+
+        /**
+         * @brief Takes one accepted step, retrying with smaller steps while the error is too large.
+         * @param tau Joint torque, held constant over the step.
+         * @param t_end Time the step must not pass [s].
+         * @throws std::runtime_error if the step size falls below the minimum step.
+         */
+        void step(const Eigen::Matrix<Scalar, nq, 1>& tau, const Scalar t_end) {
+            // Dormand-Prince tableau
+            static const Scalar a21 = Scalar(1) / 5;
+            static const Scalar a31 = Scalar(3) / 40, a32 = Scalar(9) / 40;
+            static const Scalar a41 = Scalar(44) / 45, a42 = Scalar(-56) / 15, a43 = Scalar(32) / 9;
+            static const Scalar a51 = Scalar(19372) / 6561, a52 = Scalar(-25360) / 2187, a53 = Scalar(64448) / 6561,
+                                a54 = Scalar(-212) / 729;
+            static const Scalar a61 = Scalar(9017) / 3168, a62 = Scalar(-355) / 33, a63 = Scalar(46732) / 5247,
+                                a64 = Scalar(49) / 176, a65 = Scalar(-5103) / 18656;
+            static const Scalar a71 = Scalar(35) / 384, a73 = Scalar(500) / 1113, a74 = Scalar(125) / 192,
+                                a75 = Scalar(-2187) / 6784, a76 = Scalar(11) / 84;
+            static const Scalar e1 = Scalar(71) / 57600, e3 = Scalar(-71) / 16695, e4 = Scalar(71) / 1920,
+                                e5 = Scalar(-17253) / 339200, e6 = Scalar(22) / 525, e7 = Scalar(-1) / 40;
+
+            // The first stage is reused from the last step unless the torque changed
+            if (!k_valid || tau != tau_k) {
+                evaluate(x, tau, k[0]);
+                tau_k   = tau;
+                k_valid = true;
+            }
+
+            while (true) {
+                h = std::min({h, options.max_step, t_end - time});
+                if (h < options.min_step) {
+                    throw std::runtime_error("Error! Dormand-Prince step size fell below the minimum step.");
+                }
+                evaluate(x + h * a21 * k[0], tau, k[1]);
+                evaluate(x + h * (a31 * k[0] + a32 * k[1]), tau, k[2]);
+                evaluate(x + h * (a41 * k[0] + a42 * k[1] + a43 * k[2]), tau, k[3]);
+                evaluate(x + h * (a51 * k[0] + a52 * k[1] + a53 * k[2] + a54 * k[3]), tau, k[4]);
+                evaluate(x + h * (a61 * k[0] + a62 * k[1] + a63 * k[2] + a64 * k[3] + a65 * k[4]), tau, k[5]);
+                x_next = x + h * (a71 * k[0] + a73 * k[2] + a74 * k[3] + a75 * k[4] + a76 * k[5]);
+                evaluate(x_next, tau, k[6]);
+
+                // Scaled RMS norm of the difference between the 5th and embedded 4th order solutions
+                error = h * (e1 * k[0] + e3 * k[2] + e4 * k[3] + e5 * k[4] + e6 * k[5] + e7 * k[6]);
+                scale = options.absolute_tolerance
+                        + options.relative_tolerance * x.cwiseAbs().cwiseMax(x_next.cwiseAbs()).array();
+                const Scalar norm = std::sqrt((error.array() / scale).square().mean());
+
+                // Adapt the step size within a factor of [0.2, 5]
+                const Scalar optimal = norm == 0 ? Scalar(5) : options.safety * std::pow(norm, Scalar(-0.2));
+                const Scalar factor  = std::min(Scalar(5), std::max(Scalar(0.2), optimal));
+                if (norm <= 1) {
+                    update_dense_output();
+                    time_prev = time;
+                    time += h;
+                    x = x_next;
+                    k[0].swap(k[6]);
+                    h *= factor;
+                    n_accepted++;
+                    return;
+                }
+                h *= std::min(Scalar(1), factor);
+                n_rejected++;
+            }
+        }
+
+        /**
+         * @brief Integrates up to a time.
+         * @param tau Joint torque, held constant until t_end.
+         * @param t_end Time to integrate to [s].
+         */
+        void integrate(const Eigen::Matrix<Scalar, nq, 1>& tau, const Scalar t_end) {
+            while (time < t_end) {
+                step(tau, t_end);
+            }
+        }
+
+        /**
+         * @brief Integrates up to a time, sampling the state at a fixed period from the dense output.
+         * @param tau Joint torque, held constant until t_end.
+         * @param t_end Time to integrate to [s].
+         * @param period Sample period [s].
+         * @param callback Function called as callback(t, q, dq) at the current time and every period after it.
+         * @tparam Callback Type of the callback.
+         */
+        template <typename Callback>
+        void integrate(const Eigen::Matrix<Scalar, nq, 1>& tau,
+                       const Scalar t_end,
+                       const Scalar period,
+                       const Callback& callback) {
+            const Scalar t_start = time;
+            int n_samples        = 0;
+            Eigen::Matrix<Scalar, nq, 1> q_sample, dq_sample;
+            callback(time, q(), dq());
+            while (time < t_end) {
+                step(tau, t_end);
+                for (Scalar t = t_start + (n_samples + 1) * period; t <= time; t = t_start + (n_samples + 1) * period) {
+                    dense_output(t, q_sample, dq_sample);
+                    callback(t, q_sample, dq_sample);
+                    n_samples++;
+                }
+            }
+        }
+
+        /**
+         * @brief Interpolates the state within the last accepted step.
+         * @param t Time to interpolate at, between the start and end of the last step [s].
+         * @param q Interpolated joint configuration.
+         * @param dq Interpolated joint velocity.
+         */
+        void dense_output(const Scalar t, Eigen::Matrix<Scalar, nq, 1>& q, Eigen::Matrix<Scalar, nq, 1>& dq) const {
+            const Scalar theta  = time == time_prev ? Scalar(1) : (t - time_prev) / (time - time_prev);
+            const Scalar theta1 = 1 - theta;
+            const State x_t =
+                dense_prev + theta * (dense[0] + theta1 * (dense[1] + theta * (dense[2] + theta1 * dense[3])));
+            q  = x_t.template head<nq>();
+            dq = x_t.template tail<nq>();
+        }
+
+        /// @brief Get the joint configuration.
+        Eigen::Matrix<Scalar, nq, 1> q() const {
+            return x.template head<nq>();
+        }
+
+        /// @brief Get the joint velocity.
+        Eigen::Matrix<Scalar, nq, 1> dq() const {
+            return x.template tail<nq>();
+        }
+
+        /// @brief Get the time of the state [s].
+        Scalar t() const {
+            return time;
+        }
+
+        /// @brief Get the size of the next step [s].
+        Scalar step_size() const {
+            return h;
+        }
+
+        /// @brief Get the number of forward dynamics calls since the last reset.
+        int evaluations() const {
+            return n_evaluations;
+        }
+
+        /// @brief Get the number of accepted steps since the last reset.
+        int accepted_steps() const {
+            return n_accepted;
+        }
+
+        /// @brief Get the number of rejected steps since the last reset.
+        int rejected_steps() const {
+            return n_rejected;
+        }
+
+    private:
+        /// @brief Evaluates the state derivative [dq; ddq] with forward dynamics.
+        void evaluate(const State& state, const Eigen::Matrix<Scalar, nq, 1>& tau, State& derivative) {
+            const Eigen::Matrix<Scalar, nq, 1> q  = state.template head<nq>();
+            const Eigen::Matrix<Scalar, nq, 1> dq = state.template tail<nq>();
+            derivative << dq, forward_dynamics(model, q, dq, tau);
+            n_evaluations++;
+        }
+
+        /// @brief Computes the dense output coefficients of the step from x to x_next.
+        void update_dense_output() {
+            static const Scalar d1 = Scalar(-12715105075.0) / Scalar(11282082432.0),
+                                d3 = Scalar(87487479700.0) / Scalar(32700410799.0),
+                                d4 = Scalar(-10690763975.0) / Scalar(1880347072.0),
+                                d5 = Scalar(701980252875.0) / Scalar(199316789632.0),
+                                d6 = Scalar(-1453857185.0) / Scalar(822651844.0),
+                                d7 = Scalar(69997945.0) / Scalar(29380423.0);
+            dense_prev = x;
+            dense[0]   = x_next - x;
+            dense[1]   = h * k[0] - dense[0];
+            dense[2]   = dense[0] - h * k[6] - dense[1];
+            dense[3]   = h * (d1 * k[0] + d3 * k[2] + d4 * k[3] + d5 * k[4] + d6 * k[5] + d7 * k[6]);
+        }
+
+        /// @brief Model used as the workspace of forward dynamics.
+        Model<Scalar, nq> model;
+
+        /// @brief Dormand-Prince options.
+        DormandPrinceOptions<Scalar> options;
+
+        /// @brief State and time.
+        State x     = State::Zero();
+        Scalar time = 0;
+
+        /// @brief Start time of the last accepted step.
+        Scalar time_prev = 0;
+
+        /// @brief Size of the next step.
+        Scalar h = 0;
+
+        /// @brief Stage derivatives.
+        std::array<State, 7> k;
+
+        /// @brief Whether k[0] holds the derivative at the current state for the torque tau_k.
+        bool k_valid = false;
+
+        /// @brief Torque the first stage was evaluated with.
+        Eigen::Matrix<Scalar, nq, 1> tau_k = Eigen::Matrix<Scalar, nq, 1>::Zero();
+
+        /// @brief Candidate state at the end of the step, its error estimate and the error scale of each component.
+        State x_next = State::Zero();
+        State error  = State::Zero();
+        Eigen::Array<Scalar, 2 * nq, 1> scale = Eigen::Array<Scalar, 2 * nq, 1>::Zero();
+
+        /// @brief State at the start of the last accepted step and the dense output coefficients of the step.
+        State dense_prev = State::Zero();
+        std::array<State, 4> dense;
+
+        /// @brief Number of forward dynamics calls, accepted steps and rejected steps since the last reset.
+        int n_evaluations = 0;
+        int n_accepted    = 0;
+        int n_rejected    = 0;
+    };
+
+    /**
+     * @brief Integrates many initial conditions in parallel with the Dormand-Prince integrator, each with its own
+     * adaptive steps. Each thread reuses one integrator, and its preallocated buffers, for all of its initial
+     * conditions.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of each initial condition, overwritten with the configuration at t_end.
+     * @param dq Joint velocity of each initial condition, overwritten with the velocity at t_end.
+     * @param tau Joint torque, held constant until t_end.
+     * @param t_end Time to integrate to, starting from zero [s].
+     * @param options Dormand-Prince options.
+     * @param n_threads Number of threads to use, the default thread count if zero or less.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @throws std::invalid_argument if q and dq have different sizes.
+     */
+    template <typename Scalar, int nq>
+    void integrate_batch(const Model<Scalar, nq>& model,
+                         std::vector<Eigen::Matrix<Scalar, nq, 1>>& q,
+                         std::vector<Eigen::Matrix<Scalar, nq, 1>>& dq,
+                         const Eigen::Matrix<Scalar, nq, 1>& tau,
+                         const Scalar t_end,
+                         const DormandPrinceOptions<Scalar>& options = DormandPrinceOptions<Scalar>(),
+                         int n_threads                                = 0) {
+        if (q.size() != dq.size()) {
+            throw std::invalid_argument("Error! Batch joint configurations and velocities have different sizes.");
+        }
+        const int threads = n_threads > 0 ? n_threads : default_thread_count();
+        std::vector<DormandPrinceIntegrator<Scalar, nq>> integrators(
+            threads, DormandPrinceIntegrator<Scalar, nq>(model, options));
+        parallel_for(
+            q.size(),
+            [&](const int begin, const int end, const int thread_idx) {
+                DormandPrinceIntegrator<Scalar, nq>& integrator = integrators[thread_idx];
+                for (int i = begin; i < end; ++i) {
+                    integrator.reset(q[i], dq[i]);
+                    integrator.integrate(tau, t_end);
+                    q[i]  = integrator.q();
+                    dq[i] = integrator.dq();
+                }
+            },
+            threads);
+    }
+
+}  // namespace tinyrobotics
+
+#endif
@@ -3,12 +3,14 @@
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <algorithm>
 #include <nlopt.hpp>
 #include <unsupported/Eigen/AutoDiff>
 
 #include "kinematics.hpp"
 #include "math.hpp"
 #include "model.hpp"
+#include "trace.hpp"
 
 /** \file inversekinematics.hpp
  * @brief Contains inverse kinematics algorithms.
@@ -68,6 +70,7 @@ namespace tinyrobotics {
      */
     template <typename Scalar, int nv>
     inline Scalar eigen_objective_wrapper(unsigned n, const Scalar* x, Scalar* grad, void* data) {
+        TR_TRACE_SPAN("nlopt objective");
         ObjectiveFunction<Scalar, nv>& obj_fun = *static_cast<ObjectiveFunction<Scalar, nv>*>(data);
 
         // Convert input from NLopt format to Eigen format
@@ -292,6 +295,7 @@ namespace tinyrobotics {
 
         // Iterate until the maximum number of iterations is reached
         for (int iteration = 0; iteration < options.max_iterations; ++iteration) {
+            TR_TRACE_SPAN("inverse_kinematics_jacobian iteration");
 
             // Compute the current pose
             Eigen::Transform<Scalar, 3, Eigen::Isometry> current_pose =
@@ -308,9 +312,9 @@ namespace tinyrobotics {
             // Compute the Jacobian matrix
             Eigen::Matrix<Scalar, 6, nq> J = jacobian(model, q_current, target_link_name);
 
-            // Compute the change in configuration
+            // Compute the change in configuration, the minimum norm least squares solution of J * delta_q = -step * e
             Eigen::Matrix<Scalar, nq, 1> delta_q =
-                J.completeOrthogonalDecomposition().pseudoInverse() * (-options.step_size * pose_error);
+                J.completeOrthogonalDecomposition().solve(-options.step_size * pose_error);
 
             // Update the current configuration
             q_current += delta_q;
@@ -348,6 +352,7 @@ namespace tinyrobotics {
 
         // Iterate until the maximum number of iterations is reached
         for (int iteration = 0; iteration < options.max_iterations; ++iteration) {
+            TR_TRACE_SPAN("inverse_kinematics_levenberg_marquardt iteration");
 
             // Compute the current pose
             Eigen::Transform<Scalar, 3, Eigen::Isometry> current_pose =
@@ -396,6 +401,403 @@ namespace tinyrobotics {
         return q_current;
     }
 
+    /**
+     * @brief Pose of a batch of problems stored across vector lanes. Each column holds one component of the pose for
+     * all lanes, so that arithmetic on a column is vectorized across the problems.
+     * @tparam Scalar The scalar type of the pose.
+     * @tparam Lanes Number of problems stored across the lanes.
+     */
+    template <typename Scalar, int Lanes>
+    struct LanePose {
+        /// @brief Rotation matrix components, element (r, c) is stored in column 3 * r + c.
+        Eigen::Array<Scalar, Lanes, 9> R = Eigen::Array<Scalar, Lanes, 9>::Zero();
+
+        /// @brief Translation components.
+        Eigen::Array<Scalar, Lanes, 3> p = Eigen::Array<Scalar, Lanes, 3>::Zero();
+
+        /// @brief Set every lane to the identity pose.
+        void set_identity() {
+            R.setZero();
+            p.setZero();
+            R.col(0).setOnes();
+            R.col(4).setOnes();
+            R.col(8).setOnes();
+        }
+
+        /**
+         * @brief Set a single lane from a homogeneous transform.
+         * @param lane The lane to set.
+         * @param H The homogeneous transform.
+         */
+        void set_lane(const int lane, const Eigen::Transform<Scalar, 3, Eigen::Isometry>& H) {
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c) {
+                    R(lane, 3 * r + c) = H.linear()(r, c);
+                }
+                p(lane, r) = H.translation()(r);
+            }
+        }
+    };
+
+    /**
+     * @brief Computes the chain of links from the source link (exclusive) down to the target link (inclusive).
+     * @param model tinyrobotics model.
+     * @param target_idx Index of the target link.
+     * @param source_idx Index of the source link, which must be an ancestor of the target link.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Indices of the links in the chain, ordered from the source towards the target.
+     */
+    template <typename Scalar, int nq>
+    std::vector<int> kinematic_chain(const Model<Scalar, nq>& model, const int target_idx, const int source_idx) {
+        std::vector<int> chain;
+        int current_idx = target_idx;
+        while (current_idx != source_idx) {
+            if (current_idx == -1) {
+                throw std::runtime_error("Error! Link [" + model.links[source_idx].name
+                                         + "] is not an ancestor of link [" + model.links[target_idx].name + "].");
+            }
+            chain.push_back(current_idx);
+            current_idx = model.links[current_idx].parent;
+        }
+        std::reverse(chain.begin(), chain.end());
+        return chain;
+    }
+
+    /**
+     * @brief Computes the pose of the last link in a kinematic chain for every lane, and optionally the geometric
+     * jacobian of the chain joints about the origin of the last link, expressed in the source link frame.
+     * @param model tinyrobotics model.
+     * @param chain Kinematic chain from the source link to the target link.
+     * @param q Joint configurations, one row per lane.
+     * @param pose The resulting pose of the target link in the source link frame.
+     * @param J Optional jacobian, column 6 * j + r holds row r of the jacobian column of the jth joint in the chain.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @tparam Lanes Number of problems stored across the lanes.
+     */
+    template <typename Scalar, int nq, int Lanes>
+    void lane_forward_kinematics(const Model<Scalar, nq>& model,
+                                 const std::vector<int>& chain,
+                                 const Eigen::Array<Scalar, Lanes, nq>& q,
+                                 LanePose<Scalar, Lanes>& pose,
+                                 Eigen::Array<Scalar, Lanes, 6 * nq>* J = nullptr) {
+        Eigen::Array<Scalar, Lanes, 9> R;
+        Eigen::Array<Scalar, Lanes, 1> c;
+        Eigen::Array<Scalar, Lanes, 1> s;
+        Eigen::Array<Scalar, Lanes, 1> v;
+        pose.set_identity();
+        int j = 0;
+        for (const int link_idx : chain) {
+            const Joint<Scalar>& joint = model.links[link_idx].joint;
+
+            // Apply the constant transform from the parent link to the joint
+            const Eigen::Matrix<Scalar, 3, 3> Rp = joint.parent_transform.linear();
+            const Eigen::Matrix<Scalar, 3, 1> pp = joint.parent_transform.translation();
+            for (int r = 0; r < 3; ++r) {
+                pose.p.col(r) +=
+                    pose.R.col(3 * r) * pp(0) + pose.R.col(3 * r + 1) * pp(1) + pose.R.col(3 * r + 2) * pp(2);
+                for (int k = 0; k < 3; ++k) {
+                    R.col(3 * r + k) = pose.R.col(3 * r) * Rp(0, k) + pose.R.col(3 * r + 1) * Rp(1, k)
+                                       + pose.R.col(3 * r + 2) * Rp(2, k);
+                }
+            }
+            pose.R = R;
+
+            if (joint.idx == -1) {
+                continue;
+            }
+            const Eigen::Matrix<Scalar, 3, 1>& a = joint.axis;
+
+            // Store the joint axis and origin, the linear part is completed once the target origin is known
+            if (J != nullptr) {
+                for (int r = 0; r < 3; ++r) {
+                    J->col(6 * j + 3 + r) =
+                        pose.R.col(3 * r) * a(0) + pose.R.col(3 * r + 1) * a(1) + pose.R.col(3 * r + 2) * a(2);
+                    J->col(6 * j + r) = pose.p.col(r);
+                }
+            }
+            ++j;
+
+            // Apply the joint transform
+            if (joint.type == JointType::REVOLUTE) {
+                c                             = q.col(joint.idx).cos();
+                s                             = q.col(joint.idx).sin();
+                Eigen::Matrix<Scalar, 3, 3> K = skew(a);
+                for (int r = 0; r < 3; ++r) {
+                    for (int k = 0; k < 3; ++k) {
+                        // Rodrigues formula, R_joint = c * I + s * [a]x + (1 - c) * a * a^T
+                        R.col(3 * r + k) = pose.R.col(3 * r + k) * c;
+                        for (int l = 0; l < 3; ++l) {
+                            R.col(3 * r + k) += pose.R.col(3 * r + l) * (s * K(l, k) + (1 - c) * (a(l) * a(k)));
+                        }
+                    }
+                }
+                pose.R = R;
+            }
+            else if (joint.type == JointType::PRISMATIC) {
+                for (int r = 0; r < 3; ++r) {
+                    v = pose.R.col(3 * r) * a(0) + pose.R.col(3 * r + 1) * a(1) + pose.R.col(3 * r + 2) * a(2);
+                    pose.p.col(r) += v * q.col(joint.idx);
+                }
+            }
+        }
+
+        // Complete the linear part of the jacobian columns, z x (p_target - p_joint) for revolute joints
+        if (J != nullptr) {
+            j = 0;
+            for (const int link_idx : chain) {
+                const Joint<Scalar>& joint = model.links[link_idx].joint;
+                if (joint.idx == -1) {
+                    continue;
+                }
+                if (joint.type == JointType::REVOLUTE) {
+                    const Eigen::Array<Scalar, Lanes, 3> d = pose.p - J->template middleCols<3>(6 * j);
+                    J->col(6 * j + 0) = J->col(6 * j + 4) * d.col(2) - J->col(6 * j + 5) * d.col(1);
+                    J->col(6 * j + 1) = J->col(6 * j + 5) * d.col(0) - J->col(6 * j + 3) * d.col(2);
+                    J->col(6 * j + 2) = J->col(6 * j + 3) * d.col(1) - J->col(6 * j + 4) * d.col(0);
+                }
+                else {
+                    J->template middleCols<3>(6 * j)     = J->template middleCols<3>(6 * j + 3);
+                    J->template middleCols<3>(6 * j + 3) = Eigen::Array<Scalar, Lanes, 3>::Zero();
+                }
+                ++j;
+            }
+        }
+    }
+
+    /**
+     * @brief Computes the error between two poses for every lane, see homogeneous_error.
+     * @param H1 The first pose.
+     * @param H2 The second pose.
+     * @param e The resulting error, one row per lane.
+     * @tparam Scalar Scalar type.
+     * @tparam Lanes Number of problems stored across the lanes.
+     */
+    template <typename Scalar, int Lanes>
+    void lane_homogeneous_error(const LanePose<Scalar, Lanes>& H1,
+                                const LanePose<Scalar, Lanes>& H2,
+                                Eigen::Array<Scalar, Lanes, 6>& e) {
+        using LaneScalar = Eigen::Array<Scalar, Lanes, 1>;
+
+        // Translational error
+        e.template leftCols<3>() = H1.p - H2.p;
+
+        // Orientation error, Re = R1 * R2^T
+        Eigen::Array<Scalar, Lanes, 9> Re;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                Re.col(3 * r + c) = H1.R.col(3 * r) * H2.R.col(3 * c) + H1.R.col(3 * r + 1) * H2.R.col(3 * c + 1)
+                                    + H1.R.col(3 * r + 2) * H2.R.col(3 * c + 2);
+            }
+        }
+        const LaneScalar t = Re.col(0) + Re.col(4) + Re.col(8);
+        Eigen::Array<Scalar, Lanes, 3> eps;
+        eps.col(0)                = Re.col(7) - Re.col(5);
+        eps.col(1)                = Re.col(2) - Re.col(6);
+        eps.col(2)                = Re.col(3) - Re.col(1);
+        const LaneScalar eps_norm = eps.square().rowwise().sum().sqrt();
+
+        // Evaluate every branch of homogeneous_error and select the right one per lane
+        const LaneScalar angle =
+            eps_norm.binaryExpr(t - 1, [](const Scalar& y, const Scalar& x) { return Scalar(std::atan2(y, x)); });
+        const LaneScalar scale = (eps_norm < Scalar(1e-3))
+                                     .select(Scalar(0.75) - t / 12,
+                                             angle / (eps_norm < Scalar(1e-3)).select(LaneScalar::Ones(), eps_norm));
+        const Eigen::Array<bool, Lanes, 1> regular = (t > Scalar(-.99)) || (eps_norm > Scalar(1e-10));
+        for (int r = 0; r < 3; ++r) {
+            e.col(3 + r) = regular.select(scale * eps.col(r), Scalar(M_PI_2) * (Re.col(4 * r) + 1));
+        }
+    }
+
+    /**
+     * @brief Solves A x = b for a symmetric positive semi-definite matrix in every lane via an LDL^T factorization.
+     * Directions with a vanishing pivot are left at zero.
+     * @param A Matrices to factorize, element (r, c) is stored in column nq * r + c. Overwritten by the factorization.
+     * @param b Right hand sides.
+     * @param x The resulting solutions.
+     * @param m Size of the systems, which can be smaller than nq.
+     * @tparam Scalar Scalar type.
+     * @tparam nq Maximum size of the systems.
+     * @tparam Lanes Number of problems stored across the lanes.
+     */
+    template <typename Scalar, int nq, int Lanes>
+    void lane_ldlt_solve(Eigen::Array<Scalar, Lanes, nq * nq>& A,
+                         const Eigen::Array<Scalar, Lanes, nq>& b,
+                         Eigen::Array<Scalar, Lanes, nq>& x,
+                         const int m) {
+        using LaneScalar = Eigen::Array<Scalar, Lanes, 1>;
+
+        // Pivots below this threshold are treated as zero
+        LaneScalar tiny = LaneScalar::Zero();
+        for (int k = 0; k < m; ++k) {
+            tiny = tiny.max(A.col(nq * k + k).abs());
+        }
+        tiny *= Scalar(1e-12);
+
+        // Factorize, storing L in the strict lower triangle of A
+        Eigen::Array<Scalar, Lanes, nq> D;
+        Eigen::Array<Scalar, Lanes, nq> D_inv;
+        Eigen::Array<Scalar, Lanes, nq> w;
+        LaneScalar l;
+        for (int j = 0; j < m; ++j) {
+            D.col(j) = A.col(nq * j + j);
+            for (int k = 0; k < j; ++k) {
+                w.col(k) = A.col(nq * j + k) * D.col(k);
+                D.col(j) -= A.col(nq * j + k) * w.col(k);
+            }
+            D_inv.col(j) = (D.col(j) > tiny).select(D.col(j).inverse(), Scalar(0));
+            D.col(j)     = (D.col(j) > tiny).select(D.col(j), Scalar(0));
+            for (int i = j + 1; i < m; ++i) {
+                l = A.col(nq * i + j);
+                for (int k = 0; k < j; ++k) {
+                    l -= A.col(nq * i + k) * w.col(k);
+                }
+                A.col(nq * i + j) = l * D_inv.col(j);
+            }
+        }
+
+        // Solve L y = b, z = D^-1 y and L^T x = z
+        x = b;
+        for (int i = 0; i < m; ++i) {
+            for (int k = 0; k < i; ++k) {
+                x.col(i) -= A.col(nq * i + k) * x.col(k);
+            }
+        }
+        for (int i = 0; i < m; ++i) {
+            x.col(i) *= D_inv.col(i);
+        }
+        for (int i = m - 1; i >= 0; --i) {
+            for (int k = i + 1; k < m; ++k) {
+                x.col(i) -= A.col(nq * k + i) * x.col(k);
+            }
+        }
+    }
+
+    /**
+     * @brief Solves many inverse kinematics problems between two links using the Levenberg-Marquardt method. Problems
+     * are advanced in lockstep, Lanes at a time, with forward kinematics, jacobians and the linear solves vectorized
+     * across the problems. Converged problems are masked out until every problem in the batch has converged.
+     * @param model tinyrobotics model.
+     * @param target_link_name {t} Link to which the transform is computed.
+     * @param source_link_name {s} Link from which the transform is computed, must be an ancestor of the target link.
+     * @param desired_poses Desired poses of the target link in the source link frame, one per problem.
+     * @param q0 The initial guesses for the configuration vector, one per problem.
+     * @param options Inverse kinematics options, see inverse_kinematics_levenberg_marquardt.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @tparam Lanes Number of problems solved in lockstep, best chosen as a multiple of the SIMD width.
+     * @return The configuration vectors of the robot model which achieve the desired poses.
+     */
+    template <typename Scalar, int nq, int Lanes = 4>
+    std::vector<Eigen::Matrix<Scalar, nq, 1>> inverse_kinematics_levenberg_marquardt_batch(
+        const Model<Scalar, nq>& model,
+        const std::string& target_link_name,
+        const std::string& source_link_name,
+        const std::vector<Eigen::Transform<Scalar, 3, Eigen::Isometry>>& desired_poses,
+        const std::vector<Eigen::Matrix<Scalar, nq, 1>>& q0,
+        const InverseKinematicsOptions<Scalar, nq>& options) {
+        using LaneScalar = Eigen::Array<Scalar, Lanes, 1>;
+        if (desired_poses.size() != q0.size()) {
+            throw std::invalid_argument("Error! Number of desired poses and initial guesses must match.");
+        }
+        const int target_idx = model.get_link(target_link_name).idx;
+        const int source_idx = model.get_link(source_link_name).idx;
+        if (target_idx == -1 || source_idx == -1) {
+            throw std::invalid_argument("Error! Link [" + (target_idx == -1 ? target_link_name : source_link_name)
+                                        + "] not found.");
+        }
+
+        // Configuration indices of the joints which move the target link relative to the source link
+        const std::vector<int> chain = kinematic_chain(model, target_idx, source_idx);
+        std::vector<int> joints;
+        for (const int link_idx : chain) {
+            if (model.links[link_idx].joint.idx != -1) {
+                joints.push_back(model.links[link_idx].joint.idx);
+            }
+        }
+        const int m = joints.size();
+
+        std::vector<Eigen::Matrix<Scalar, nq, 1>> q_solution(q0);
+        Eigen::Array<Scalar, Lanes, nq> q;
+        Eigen::Array<Scalar, Lanes, nq> q_new;
+        LanePose<Scalar, Lanes> desired_pose;
+        LanePose<Scalar, Lanes> current_pose;
+        LanePose<Scalar, Lanes> new_pose;
+        Eigen::Array<Scalar, Lanes, 6 * nq> J;
+        Eigen::Array<Scalar, Lanes, 6> pose_error;
+        Eigen::Array<Scalar, Lanes, 6> new_pose_error;
+        Eigen::Array<Scalar, Lanes, nq * nq> H;
+        Eigen::Array<Scalar, Lanes, nq> g;
+        Eigen::Array<Scalar, Lanes, nq> delta_q;
+        LaneScalar lambda;
+        LaneScalar error_norm;
+        LaneScalar new_error_norm;
+        Eigen::Array<bool, Lanes, 1> active;
+        Eigen::Array<bool, Lanes, 1> accept;
+
+        for (size_t first = 0; first < q0.size(); first += Lanes) {
+            // Load the problems into the lanes, padding the last batch with inactive copies of its last problem
+            for (int lane = 0; lane < Lanes; ++lane) {
+                const size_t idx = std::min(first + lane, q0.size() - 1);
+                q.row(lane)      = q0[idx].transpose().array();
+                desired_pose.set_lane(lane, desired_poses[idx]);
+                active(lane) = first + lane < q0.size();
+            }
+            lambda.setConstant(options.initial_damping);
+
+            for (int iteration = 0; iteration < options.max_iterations; ++iteration) {
+                TR_TRACE_SPAN("inverse_kinematics_levenberg_marquardt_batch iteration");
+                // Compute the current poses, jacobians and pose error vectors
+                lane_forward_kinematics(model, chain, q, current_pose, &J);
+                lane_homogeneous_error(current_pose, desired_pose, pose_error);
+                error_norm = pose_error.square().rowwise().sum().sqrt();
+
+                // Mask out the problems which are within tolerance
+                active = active && (error_norm >= options.tolerance);
+                if (!active.any()) {
+                    break;
+                }
+
+                // Compute the Hessian approximation and the gradient over the chain joints
+                for (int a = 0; a < m; ++a) {
+                    g.col(a) = -(J.template middleCols<6>(6 * a) * pose_error).rowwise().sum();
+                    for (int b = 0; b <= a; ++b) {
+                        H.col(nq * a + b) =
+                            (J.template middleCols<6>(6 * a) * J.template middleCols<6>(6 * b)).rowwise().sum();
+                        H.col(nq * b + a) = H.col(nq * a + b);
+                    }
+                    // Levenberg-Marquardt damping, H + lambda * diag(H)
+                    H.col(nq * a + a) *= 1 + lambda;
+                }
+                lane_ldlt_solve<Scalar, nq, Lanes>(H, g, delta_q, m);
+
+                // Test the new configurations
+                q_new = q;
+                for (int a = 0; a < m; ++a) {
+                    q_new.col(joints[a]) += delta_q.col(a);
+                }
+                lane_forward_kinematics(model, chain, q_new, new_pose);
+                lane_homogeneous_error(new_pose, desired_pose, new_pose_error);
+                new_error_norm = new_pose_error.square().rowwise().sum().sqrt();
+
+                // Accept configurations which reduce the error and decrease their damping, otherwise increase it
+                accept = active && (new_error_norm < error_norm);
+                for (const int joint_idx : joints) {
+                    q.col(joint_idx) = accept.select(q_new.col(joint_idx), q.col(joint_idx));
+                }
+                lambda = accept.select(lambda * options.damping_decrease_factor,
+                                       active.select(lambda * options.damping_increase_factor, lambda));
+            }
+
+            // Store the final configurations
+            for (int lane = 0; lane < Lanes && first + lane < q0.size(); ++lane) {
+                q_solution[first + lane] = q.row(lane).transpose().matrix();
+            }
+        }
+        return q_solution;
+    }
+
     /**
      * @brief Solves the inverse kinematics problem between two links using Particle Swarm Optimization.
      * @param model tinyrobotics model.
@@ -435,6 +837,7 @@ namespace tinyrobotics {
 
         // Main optimization loop
         for (int iteration = 0; iteration < options.max_iterations; ++iteration) {
+            TR_TRACE_SPAN("inverse_kinematics_pso iteration");
             for (int i = 0; i < num_particles; ++i) {
                 // Evaluate the fitness of the particle
                 Eigen::Transform<Scalar, 3, Eigen::Isometry> current_pose =
@@ -500,6 +903,7 @@ namespace tinyrobotics {
         Eigen::Matrix<Scalar, nq, nq> inverse_hessian = Eigen::Matrix<Scalar, nq, nq>::Identity();
 
         for (int iteration = 0; iteration < options.max_iterations; ++iteration) {
+            TR_TRACE_SPAN("inverse_kinematics_bfgs iteration");
             // Compute the gradient and cost using the provided cost function
             Scalar cost_value = cost(q, model, target_link_name, source_link_name, desired_pose, q0, grad, options);
 
@@ -535,6 +939,119 @@ namespace tinyrobotics {
         return q;
     }
 
+    /**
+     * @brief Inputs of an inverse kinematics call, as captured for offline replay.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    struct InverseKinematicsCall {
+        /// @brief Name of the target link
+        std::string target_link_name;
+
+        /// @brief Name of the source link
+        std::string source_link_name;
+
+        /// @brief Desired pose of the target link in the source link frame
+        Eigen::Transform<Scalar, 3, Eigen::Isometry> desired_pose;
+
+        /// @brief Initial guess for the configuration vector
+        Eigen::Matrix<Scalar, nq, 1> q0;
+
+        /// @brief Inverse kinematics options
+        InverseKinematicsOptions<Scalar, nq> options;
+    };
+
+    /**
+     * @brief Encodes the inputs of an inverse kinematics call as doubles for a capture buffer. The values are the
+     * target and source link indices, the desired pose (16, column major), q0 (nq), then the options in declaration
+     * order with K (36) and W (nq x nq) column major.
+     * @param model tinyrobotics model.
+     * @param call Inputs of the call.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return The encoded call.
+     */
+    template <typename Scalar, int nq>
+    std::vector<double> encode_inverse_kinematics_call(const Model<Scalar, nq>& model,
+                                                       const InverseKinematicsCall<Scalar, nq>& call) {
+        const InverseKinematicsOptions<Scalar, nq>& o = call.options;
+        std::vector<double> values                    = {double(model.get_link(call.target_link_name).idx),
+                                                         double(model.get_link(call.source_link_name).idx)};
+        auto append = [&](const auto& matrix) {
+            for (int i = 0; i < matrix.size(); ++i) {
+                values.push_back(double(matrix.data()[i]));
+            }
+        };
+        append(call.desired_pose.matrix());
+        append(call.q0);
+        values.insert(values.end(),
+                      {double(o.tolerance),
+                       double(o.xtol_rel),
+                       double(o.max_iterations),
+                       double(o.method),
+                       double(o.step_size),
+                       double(o.algorithm)});
+        append(o.K);
+        append(o.W);
+        values.insert(values.end(),
+                      {double(o.initial_damping),
+                       double(o.damping_decrease_factor),
+                       double(o.damping_increase_factor),
+                       double(o.num_particles),
+                       double(o.omega),
+                       double(o.c1),
+                       double(o.c2),
+                       double(o.init_position_scale)});
+        return values;
+    }
+
+    /**
+     * @brief Decodes the inputs of an inverse kinematics call encoded by encode_inverse_kinematics_call.
+     * @param model tinyrobotics model.
+     * @param values The encoded call.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Inputs of the call.
+     * @throws std::invalid_argument if the values do not match the model.
+     */
+    template <typename Scalar, int nq>
+    InverseKinematicsCall<Scalar, nq> decode_inverse_kinematics_call(const Model<Scalar, nq>& model,
+                                                                     const std::vector<double>& values) {
+        if (values.size() != size_t(2 + 16 + nq + 6 + 36 + nq * nq + 8)) {
+            throw std::invalid_argument("Error! Captured inverse kinematics call does not match the model.");
+        }
+        InverseKinematicsCall<Scalar, nq> call;
+        InverseKinematicsOptions<Scalar, nq>& o = call.options;
+        const double* v                         = values.data();
+        auto read_matrix = [&](auto& matrix) {
+            for (int i = 0; i < matrix.size(); ++i) {
+                matrix.data()[i] = Scalar(*v++);
+            }
+        };
+        call.target_link_name = model.links.at(int(*v++)).name;
+        call.source_link_name = model.links.at(int(*v++)).name;
+        read_matrix(call.desired_pose.matrix());
+        read_matrix(call.q0);
+        o.tolerance      = Scalar(*v++);
+        o.xtol_rel       = Scalar(*v++);
+        o.max_iterations = int(*v++);
+        o.method         = static_cast<InverseKinematicsMethod>(int(*v++));
+        o.step_size      = Scalar(*v++);
+        o.algorithm      = static_cast<nlopt::algorithm>(int(*v++));
+        read_matrix(o.K);
+        read_matrix(o.W);
+        o.initial_damping         = Scalar(*v++);
+        o.damping_decrease_factor = Scalar(*v++);
+        o.damping_increase_factor = Scalar(*v++);
+        o.num_particles           = int(*v++);
+        o.omega                   = Scalar(*v++);
+        o.c1                      = Scalar(*v++);
+        o.c2                      = Scalar(*v++);
+        o.init_position_scale     = Scalar(*v++);
+        return call;
+    }
+
     /**
      * @brief Solves the inverse kinematics problem between two links using user specified method.
      * @param model tinyrobotics model.
@@ -553,29 +1070,52 @@ namespace tinyrobotics {
                                                     const Eigen::Transform<Scalar, 3, Eigen::Isometry>& desired_pose,
                                                     const Eigen::Matrix<Scalar, nq, 1> q0,
                                                     const InverseKinematicsOptions<Scalar, nq>& options) {
-        switch (options.method) {
-            case InverseKinematicsMethod::NLOPT:
-                return inverse_kinematics_nlopt(model, target_link_name, source_link_name, desired_pose, q0, options);
-            case InverseKinematicsMethod::JACOBIAN:
-                return inverse_kinematics_jacobian(model,
-                                                   target_link_name,
-                                                   source_link_name,
-                                                   desired_pose,
-                                                   q0,
-                                                   options);
-            case InverseKinematicsMethod::LEVENBERG_MARQUARDT:
-                return inverse_kinematics_levenberg_marquardt(model,
-                                                              target_link_name,
-                                                              source_link_name,
-                                                              desired_pose,
-                                                              q0,
-                                                              options);
-            case InverseKinematicsMethod::PARTICLE_SWARM:
-                return inverse_kinematics_pso(model, target_link_name, source_link_name, desired_pose, q0, options);
-            case InverseKinematicsMethod::BFGS:
-                return inverse_kinematics_bfgs(model, target_link_name, source_link_name, desired_pose, q0, options);
-            default: throw std::runtime_error("Unknown inverse kinematics method");
+        auto solve = [&]() -> Eigen::Matrix<Scalar, nq, 1> {
+            switch (options.method) {
+                case InverseKinematicsMethod::NLOPT:
+                    return inverse_kinematics_nlopt(model, target_link_name, source_link_name, desired_pose, q0, options);
+                case InverseKinematicsMethod::JACOBIAN:
+                    return inverse_kinematics_jacobian(model,
+                                                       target_link_name,
+                                                       source_link_name,
+                                                       desired_pose,
+                                                       q0,
+                                                       options);
+                case InverseKinematicsMethod::LEVENBERG_MARQUARDT:
+                    return inverse_kinematics_levenberg_marquardt(model,
+                                                                  target_link_name,
+                                                                  source_link_name,
+                                                                  desired_pose,
+                                                                  q0,
+                                                                  options);
+                case InverseKinematicsMethod::PARTICLE_SWARM:
+                    return inverse_kinematics_pso(model, target_link_name, source_link_name, desired_pose, q0, options);
+                case InverseKinematicsMethod::BFGS:
+                    return inverse_kinematics_bfgs(model, target_link_name, source_link_name, desired_pose, q0, options);
+                default: throw std::runtime_error("Unknown inverse kinematics method");
+            }
+        };
+
+        // Record the inputs and duration of the call if capture is enabled
+        if constexpr (std::is_arithmetic<Scalar>::value) {
+            if (model.capture != nullptr) {
+                const int64_t start_ns               = capture_clock_ns();
+                const Eigen::Matrix<Scalar, nq, 1> q = solve();
+                const int64_t end_ns                 = capture_clock_ns();
+                model.capture->record(
+                    CaptureCallType::INVERSE_KINEMATICS,
+                    start_ns,
+                    end_ns,
+                    encode_inverse_kinematics_call(model,
+                                                   InverseKinematicsCall<Scalar, nq>{target_link_name,
+                                                                                     source_link_name,
+                                                                                     desired_pose,
+                                                                                     q0,
+                                                                                     options}));
+                return q;
+            }
         }
+        return solve();
     }
 }  // namespace tinyrobotics
 #endif
@@ -5,6 +5,8 @@
 #include <Eigen/Geometry>
 #include <iostream>
 
+#include "pose.hpp"
+
 /** \file joint.hpp
  * @brief Contains struct for representing a joint in a tinyrobotics model.
  */
@@ -97,12 +99,32 @@ namespace tinyrobotics {
             return T;
         }
 
+        /**
+         * @brief Compute the pose of the joint frame in the parent link frame, parent_transform *
+         * get_joint_transform(q), without multiplying by the identity parts of the joint motion.
+         * @param q The joint position variable.
+         * @return Pose of the joint frame in the parent link frame.
+         */
+        Pose<Scalar> get_local_pose(const Scalar& q) const {
+            switch (type) {
+                case JointType::REVOLUTE:
+                    return Pose<Scalar>(
+                        parent_transform.linear() * Eigen::AngleAxis<Scalar>(q, axis).toRotationMatrix(),
+                        parent_transform.translation());
+                case JointType::PRISMATIC:
+                    return Pose<Scalar>(parent_transform.linear(),
+                                        parent_transform.translation() + parent_transform.linear() * (q * axis));
+                case JointType::FIXED: return Pose<Scalar>(parent_transform);
+                default: throw std::runtime_error("Joint type not supported.");
+            }
+        }
+
         /**
          * @brief Compute the transform from parent to child.
          * @param q The joint position variable.
          * @return Homogeneous transform from parent to child.
          */
-        Eigen::Transform<Scalar, 3, Eigen::Isometry> get_parent_to_child_transform(const Scalar& q) {
+        Eigen::Transform<Scalar, 3, Eigen::Isometry> get_parent_to_child_transform(const Scalar& q) const {
             return parent_transform * get_joint_transform(q) * child_transform;
         }
 
@@ -3,9 +3,14 @@
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #include "math.hpp"
 #include "model.hpp"
+#include "pose.hpp"
+#include "trace.hpp"
 
 /** \file kinematics.hpp
  * @brief Contains functions for computing various kinematic quantities of a tinyrobotics model.
@@ -35,33 +40,74 @@ namespace tinyrobotics {
         }
     }
 
+    /**
+     * @brief Computes the pose of a link in its parent link frame, the joint transform applied to the parent transform
+     * for links with a non-fixed joint.
+     * @param link Link of the tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Pose of the link in its parent link frame.
+     */
+    template <typename Scalar, int nq>
+    Pose<Scalar> link_local_pose(const Link<Scalar>& link, const Eigen::Matrix<Scalar, nq, 1>& q) {
+        if (link.joint.idx == -1) {
+            return Pose<Scalar>(link.joint.parent_transform);
+        }
+        return link.joint.get_local_pose(q[link.joint.idx]);
+    }
+
     /**
      * @brief Computes the transform to all the links in the tinyrobotics model.
      * @param model tinyrobotics model.
      * @param q Joint configuration of the robot.
      * @tparam Scalar type of the tinyrobotics model.
      * @tparam nq Number of configuration coordinates (degrees of freedom).
-     * @return Stores the transform to all the links in model.forward_kinematics.
+     * @return Stores the transform to all the links in model.forward_kinematics, and their compact poses in
+     * model.link_poses.
      */
     template <typename Scalar, int nq>
     std::vector<Eigen::Transform<Scalar, 3, Eigen::Isometry>> forward_kinematics(
         Model<Scalar, nq>& model,
         const Eigen::Matrix<Scalar, nq, 1>& q) {
+        TR_TRACE_SPAN("forward_kinematics");
         model.forward_kinematics.resize(model.links.size(), Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity());
-        for (auto const link : model.links) {
-            model.forward_kinematics[link.idx] = link.joint.parent_transform;
-            if (link.joint.idx != -1) {
-                model.forward_kinematics[link.idx] =
-                    model.forward_kinematics[link.idx] * link.joint.get_joint_transform(q[link.joint.idx]);
-            }
+        model.link_poses.resize(model.links.size());
+        for (const Link<Scalar>& link : model.links) {
             if (link.parent != -1) {
-                model.forward_kinematics[link.idx] =
-                    model.forward_kinematics[link.parent] * model.forward_kinematics[link.idx];
+                model.link_poses[link.idx] = model.link_poses[link.parent] * link_local_pose(link, q);
             }
+            else {
+                model.link_poses[link.idx] = link_local_pose(link, q);
+            }
+            model.forward_kinematics[link.idx] = model.link_poses[link.idx].isometry();
         }
         return model.forward_kinematics;
     }
 
+    /**
+     * @brief Computes the pose of a link relative to one of its ancestors. The poses of the links on the path are
+     * multiplied from the target upwards, so no pose is inverted.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param target_idx Index of the target link.
+     * @param ancestor_idx Index of an ancestor of the target link.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Pose of the target link in the ancestor link frame.
+     */
+    template <typename Scalar, int nq>
+    Pose<Scalar> forward_kinematics_from_ancestor(const Model<Scalar, nq>& model,
+                                                  const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                  const int target_idx,
+                                                  const int ancestor_idx) {
+        Pose<Scalar> Hat;
+        for (int idx = target_idx; idx != ancestor_idx && idx != -1; idx = model.links[idx].parent) {
+            Hat = link_local_pose(model.links[idx], q) * Hat;
+        }
+        return Hat;
+    }
+
     /**
      * @brief Computes the transform between target and the base link. The transform converts points in target
      * frame to the base link frame.
@@ -77,24 +123,14 @@ namespace tinyrobotics {
     Eigen::Transform<Scalar, 3, Eigen::Isometry> forward_kinematics(const Model<Scalar, nq>& model,
                                                                     const Eigen::Matrix<Scalar, nq, 1>& q,
                                                                     const TargetLink& target_link) {
-        Link<Scalar> current_link = model.links[get_link_idx(model, target_link)];
-
-        // Build kinematic tree from base {b} to target {t} link
-        Eigen::Transform<Scalar, 3, Eigen::Isometry> Htb = Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity();
-        while (current_link.idx != model.base_link_idx) {
-            // Apply joint transform if joint is actuatable
-            if (current_link.joint.idx != -1) {
-                Htb = Htb * current_link.joint.get_joint_transform(q[current_link.joint.idx]).inverse();
-            }
-            Htb          = Htb * current_link.joint.parent_transform.inverse();
-            current_link = model.links[current_link.parent];
-        }
-        return Htb.inverse();
+        return forward_kinematics_from_ancestor(model, q, get_link_idx(model, target_link), model.base_link_idx)
+            .isometry();
     }
 
     /**
      * @brief Computes the transform between target and the source link. The transform converts points in target
-     * frame to the source link frame.
+     * frame to the source link frame. Only the path from the source up to the lowest common ancestor of the links and
+     * down to the target is traversed.
      * @param model tinyrobotics model.
      * @param q Joint configuration of the robot.
      * @param target_link Target link, which can be an integer (index) or a string (name).
@@ -110,8 +146,128 @@ namespace tinyrobotics {
                                                                     const Eigen::Matrix<Scalar, nq, 1>& q,
                                                                     const TargetLink& target_link,
                                                                     const SourceLink& source_link) {
-        return forward_kinematics(model, q, get_link_idx(model, source_link)).inverse()
-               * forward_kinematics(model, q, get_link_idx(model, target_link));
+        const int target = get_link_idx(model, target_link);
+        const int source = get_link_idx(model, source_link);
+        const int lca    = model.lowest_common_ancestor(target, source);
+        if (lca == source) {
+            return forward_kinematics_from_ancestor(model, q, target, source).isometry();
+        }
+        return forward_kinematics_from_ancestor(model, q, source, lca)
+            .inverse_compose(forward_kinematics_from_ancestor(model, q, target, lca))
+            .isometry();
+    }
+
+    /**
+     * @brief Precompiled subset of links for pruned forward kinematics. Holds the union of the paths from each
+     * requested link up to the root, ordered parents first, so only the transforms those links depend on are
+     * evaluated.
+     * @tparam Scalar type of the tinyrobotics model.
+     */
+    template <typename Scalar>
+    struct LinkSet {
+        /// @brief Indices of the requested links, in the order of the output transforms.
+        std::vector<int> links;
+
+        /// @brief Indices of the links to evaluate, parents before children.
+        std::vector<int> order;
+
+        /// @brief Position in order of the parent of each evaluated link, -1 for the root.
+        std::vector<int> parent;
+
+        /// @brief Position in order of each requested link.
+        std::vector<int> output;
+
+        /// @brief Pose of each evaluated link in the base link frame.
+        std::vector<Pose<Scalar>> workspace;
+
+        /// @brief Transform of each requested link to the base link, in the order of links.
+        std::vector<Eigen::Transform<Scalar, 3, Eigen::Isometry>> transforms;
+    };
+
+    /**
+     * @brief Builds the link set of the requested links, the union of their paths up to the root in topological order.
+     * @param model tinyrobotics model.
+     * @param links Requested links, each an integer (index) or a string (name).
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @tparam Links Type of the requested links, std::vector<int> or std::vector<std::string>.
+     * @return Link set of the requested links.
+     * @throws std::invalid_argument if a link index is out of range.
+     */
+    template <typename Scalar, int nq, typename Links>
+    LinkSet<Scalar> link_set(const Model<Scalar, nq>& model, const Links& links) {
+        LinkSet<Scalar> set;
+        const int n_links = model.links.size();
+        std::vector<int> depth(n_links, -1);
+        for (const auto& link : links) {
+            const int idx = get_link_idx(model, link);
+            if (idx < 0 || idx >= n_links) {
+                throw std::invalid_argument("Error! Link index " + std::to_string(idx) + " is not in the model.");
+            }
+            set.links.push_back(idx);
+
+            // Mark the path up to the first link already in the set
+            std::vector<int> path;
+            for (int i = idx; i != -1 && depth[i] == -1; i = model.links[i].parent) {
+                path.push_back(i);
+            }
+            const int top = model.links[path.empty() ? idx : path.back()].parent;
+            int d         = top == -1 ? 0 : depth[top] + 1;
+            for (auto i = path.rbegin(); i != path.rend(); ++i) {
+                depth[*i] = d++;
+                set.order.push_back(*i);
+            }
+        }
+
+        // Order by depth so every parent is evaluated before its children
+        std::stable_sort(set.order.begin(), set.order.end(), [&](const int a, const int b) {
+            return depth[a] < depth[b];
+        });
+        std::vector<int> position(n_links, -1);
+        for (size_t k = 0; k < set.order.size(); ++k) {
+            position[set.order[k]] = k;
+        }
+        for (const int idx : set.order) {
+            const int parent = model.links[idx].parent;
+            set.parent.push_back(parent == -1 ? -1 : position[parent]);
+        }
+        for (const int idx : set.links) {
+            set.output.push_back(position[idx]);
+        }
+        set.workspace.resize(set.order.size());
+        set.transforms.resize(set.links.size(), Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity());
+        return set;
+    }
+
+    /**
+     * @brief Computes the transforms of the links of a link set to the base link, evaluating only the links on their
+     * paths to the root.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param set Link set built with link_set for this model.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Transform of each requested link to the base link, stored in set.transforms.
+     */
+    template <typename Scalar, int nq>
+    const std::vector<Eigen::Transform<Scalar, 3, Eigen::Isometry>>& forward_kinematics(
+        const Model<Scalar, nq>& model,
+        const Eigen::Matrix<Scalar, nq, 1>& q,
+        LinkSet<Scalar>& set) {
+        TR_TRACE_SPAN("forward_kinematics link set");
+        for (size_t k = 0; k < set.order.size(); ++k) {
+            const Link<Scalar>& link = model.links[set.order[k]];
+            if (set.parent[k] != -1) {
+                set.workspace[k] = set.workspace[set.parent[k]] * link_local_pose(link, q);
+            }
+            else {
+                set.workspace[k] = link_local_pose(link, q);
+            }
+        }
+        for (size_t k = 0; k < set.links.size(); ++k) {
+            set.transforms[k] = set.workspace[set.output[k]].isometry();
+        }
+        return set.transforms;
     }
 
     /**
@@ -161,93 +317,437 @@ namespace tinyrobotics {
                * model.links[get_link_idx(model, target_link)].center_of_mass;
     }
 
+    /// @brief Reference frames in which jacobians and spatial velocities can be expressed.
+    enum class ReferenceFrame {
+        /// @brief Expressed in the target link frame, about the origin of the target link.
+        LOCAL,
+
+        /// @brief Expressed in the base (or source) link frame, about the origin of the base (or source) link.
+        WORLD,
+
+        /// @brief Expressed in the axes of the base (or source) link frame, about the origin of the target link.
+        LOCAL_WORLD_ALIGNED
+    };
+
+    /**
+     * @brief Fills the jacobian columns of the joints between the target link and the source link, where the source
+     * link is an ancestor of the target link. Assumes forward_kinematics(model, q) has been computed, and reads the
+     * link poses from model.link_poses.
+     * @param model tinyrobotics model.
+     * @param target_idx Index of the target link.
+     * @param source_idx Index of the source link.
+     * @param frame Reference frame in which the jacobian is expressed.
+     * @param J The jacobian to fill, only columns of joints between the target and source links are written.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    void fill_jacobian(const Model<Scalar, nq>& model,
+                       const int target_idx,
+                       const int source_idx,
+                       const ReferenceFrame frame,
+                       Eigen::Matrix<Scalar, 6, nq>& J) {
+        TR_TRACE_SPAN("fill_jacobian");
+        const Pose<Scalar>& Hbs = model.link_poses[source_idx];
+        const Pose<Scalar>& Hbt = model.link_poses[target_idx];
+
+        // Rotation from base {b} to the frame the jacobian is expressed in {e}
+        const Eigen::Matrix<Scalar, 3, 3>& Rbe = frame == ReferenceFrame::LOCAL ? Hbt.rotation : Hbs.rotation;
+
+        // Point about which the linear velocity is taken {p}, in the base frame
+        const Eigen::Matrix<Scalar, 3, 1>& rPBb = frame == ReferenceFrame::WORLD ? Hbs.translation : Hbt.translation;
+
+        int current_idx = target_idx;
+        while (current_idx != source_idx && current_idx != model.base_link_idx) {
+            const Link<Scalar>& current_link = model.links[current_idx];
+            if (current_link.joint.idx != -1) {
+                // Joint axis and lever arm from joint to point {p}, rotated into the frame {e}
+                Eigen::Matrix<Scalar, 3, 1> zIEe =
+                    Rbe.transpose() * (model.link_poses[current_idx].rotation * current_link.joint.axis);
+                if (current_link.joint.type == JointType::PRISMATIC) {
+                    J.template block<3, 1>(0, current_link.joint.idx) = zIEe;
+                    J.template block<3, 1>(3, current_link.joint.idx).setZero();
+                }
+                else if (current_link.joint.type == JointType::REVOLUTE) {
+                    Eigen::Matrix<Scalar, 3, 1> rPIe =
+                        Rbe.transpose() * (rPBb - model.link_poses[current_idx].translation);
+                    J.template block<3, 1>(0, current_link.joint.idx) = zIEe.cross(rPIe);
+                    J.template block<3, 1>(3, current_link.joint.idx) = zIEe;
+                }
+            }
+            // Move up the tree to parent towards the source
+            current_idx = current_link.parent;
+        }
+    }
+
     /**
-     * @brief Computes the geometric jacobian of the target link from the base link, in the base link frame.
+     * @brief Computes the geometric jacobian of the target link from the base link. The linear part is stacked above
+     * the angular part.
      * @param model tinyrobotics model.
      * @param q Joint configuration of the robot.
      * @param target_link Target link, which can be an integer (index) or a string (name).
+     * @param frame Reference frame in which the jacobian is expressed, by default the base link axes about the target.
      * @tparam Scalar type of the tinyrobotics model.
      * @tparam nq Number of configuration coordinates (degrees of freedom).
      * @tparam TargetLink Type of target_link parameter, which can be int or std::string.
-     * @return The geometric jacobian of the target link from the base link, in the base link frame.
+     * @return The geometric jacobian of the target link from the base link, in the requested frame.
      */
     template <typename Scalar, int nq, typename TargetLink>
     Eigen::Matrix<Scalar, 6, nq> jacobian(Model<Scalar, nq>& model,
                                           const Eigen::Matrix<Scalar, nq, 1>& q,
-                                          const TargetLink& target_link) {
+                                          const TargetLink& target_link,
+                                          const ReferenceFrame frame = ReferenceFrame::LOCAL_WORLD_ALIGNED) {
         // Compute forward kinematics for all the links
         forward_kinematics(model, q);
 
-        model.J.setZero();
-        Eigen::Matrix<Scalar, 3, 1> zIBb;
-        Eigen::Matrix<Scalar, 3, 1> rIBb;
-        Link<Scalar> current_link        = model.links[get_link_idx(model, target_link)];
-        Eigen::Matrix<Scalar, 3, 1> rTBb = model.forward_kinematics[current_link.idx].translation();
-
         // Compute the jacobian
-        while (current_link.idx != model.base_link_idx) {
-            if (current_link.joint.idx != -1) {
-                zIBb = model.forward_kinematics[current_link.idx].linear() * current_link.joint.axis;
-                rIBb = model.forward_kinematics[current_link.idx].translation();
-                if (current_link.joint.type == JointType::PRISMATIC) {
-                    model.J.block(0, current_link.joint.idx, 3, 1) = zIBb;
-                    model.J.block(3, current_link.joint.idx, 3, 1) = Eigen::Matrix<Scalar, 3, 1>::Zero();
-                }
-                else if (current_link.joint.type == JointType::REVOLUTE) {
-                    model.J.block(0, current_link.joint.idx, 3, 1) = (zIBb).cross(rTBb - rIBb);
-                    model.J.block(3, current_link.joint.idx, 3, 1) = zIBb;
-                }
-            }
-            // Move up the tree to parent towards the base
-            current_link = model.links[current_link.parent];
-        }
+        model.J.setZero();
+        fill_jacobian(model, get_link_idx(model, target_link), model.base_link_idx, frame, model.J);
         return model.J;
     }
 
+    /**
+     * @brief Computes the geometric jacobian of the target link relative to the source link, which can be any link of
+     * the model. Only the links on the path from the source up to the lowest common ancestor of the links and down to
+     * the target are evaluated, with their transforms relative to the lowest common ancestor formed by forward
+     * products. Joints on the target side move the target, and joints on the source side move the source, which the
+     * target sees as the opposite motion. The linear part is stacked above the angular part.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param target_link Target link, which can be an integer (index) or a string (name).
+     * @param source_link Source link, which can be an integer (index) or a string (name).
+     * @param frame Reference frame in which the jacobian is expressed, by default the source link axes about the
+     * target.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @tparam TargetLink Type of target_link parameter, which can be int or std::string.
+     * @tparam SourceLink Type of source_link parameter, which can be int or std::string.
+     * @return The geometric jacobian of the target link relative to the source link, in the requested frame.
+     */
     template <typename Scalar, int nq, typename TargetLink, typename SourceLink = int>
     Eigen::Matrix<Scalar, 6, nq> jacobian(Model<Scalar, nq>& model,
                                           const Eigen::Matrix<Scalar, nq, 1>& q,
                                           const TargetLink& target_link,
-                                          const SourceLink& source_link) {
-        // Compute forward kinematics for all the links
-        forward_kinematics(model, q);
+                                          const SourceLink& source_link,
+                                          const ReferenceFrame frame = ReferenceFrame::LOCAL_WORLD_ALIGNED) {
+        TR_TRACE_SPAN("relative jacobian");
+        const int target = get_link_idx(model, target_link);
+        const int source = get_link_idx(model, source_link);
+        const int lca    = model.lowest_common_ancestor(target, source);
 
-        Eigen::Matrix<Scalar, 6, nq> J;
-        J.setZero();
+        // Links below the lowest common ancestor, the target side then the source side, each from the bottom up
+        model.link_path.clear();
+        for (int idx = target; idx != lca; idx = model.links[idx].parent) {
+            model.link_path.push_back(idx);
+        }
+        const int n_target = model.link_path.size();
+        for (int idx = source; idx != lca; idx = model.links[idx].parent) {
+            model.link_path.push_back(idx);
+        }
+        const int n_path = model.link_path.size();
 
-        // Get indices of target and source links
-        int target_idx = get_link_idx(model, target_link);
-        int source_idx = get_link_idx(model, source_link);
+        // Poses relative to the lowest common ancestor {l}, from the top of each side down
+        model.link_path_kinematics.resize(n_path);
+        for (const auto& side : {std::make_pair(0, n_target), std::make_pair(n_target, n_path)}) {
+            for (int k = side.second - 1; k >= side.first; --k) {
+                const Link<Scalar>& link = model.links[model.link_path[k]];
+                if (k + 1 < side.second) {
+                    model.link_path_kinematics[k] = model.link_path_kinematics[k + 1] * link_local_pose(link, q);
+                }
+                else {
+                    model.link_path_kinematics[k] = link_local_pose(link, q);
+                }
+            }
+        }
+        const Pose<Scalar> identity = Pose<Scalar>::Identity();
+        const Pose<Scalar>& Hlt     = n_target > 0 ? model.link_path_kinematics[0] : identity;
+        const Pose<Scalar>& Hls     = n_path > n_target ? model.link_path_kinematics[n_target] : identity;
 
-        // Transform from base to source link
-        Eigen::Transform<Scalar, 3, Eigen::Isometry> Hbs = forward_kinematics(model, q, source_idx);
-        Eigen::Matrix<Scalar, 3, 3> Rbs                  = Hbs.linear();  // Rotation matrix from base to source
+        // Rotation from {l} to the frame the jacobian is expressed in {e}, and the point {p} about which the linear
+        // velocity is taken in {l}
+        const Eigen::Matrix<Scalar, 3, 3>& Rle  = frame == ReferenceFrame::LOCAL ? Hlt.rotation : Hls.rotation;
+        const Eigen::Matrix<Scalar, 3, 1>& rPLl = frame == ReferenceFrame::WORLD ? Hls.translation : Hlt.translation;
 
-        Link<Scalar> current_link        = model.links[target_idx];
-        Eigen::Matrix<Scalar, 3, 1> rTSs = Hbs.inverse() * model.forward_kinematics[current_link.idx].translation();
+        Eigen::Matrix<Scalar, 6, nq> J = Eigen::Matrix<Scalar, 6, nq>::Zero();
+        for (int k = 0; k < n_path; ++k) {
+            const Link<Scalar>& link = model.links[model.link_path[k]];
+            if (link.joint.idx == -1) {
+                continue;
+            }
+            const Scalar sign = k < n_target ? 1 : -1;
+            const Eigen::Matrix<Scalar, 3, 1> zIEe =
+                sign * (Rle.transpose() * (model.link_path_kinematics[k].rotation * link.joint.axis));
+            if (link.joint.type == JointType::PRISMATIC) {
+                J.template block<3, 1>(0, link.joint.idx) = zIEe;
+            }
+            else if (link.joint.type == JointType::REVOLUTE) {
+                const Eigen::Matrix<Scalar, 3, 1> rPIe =
+                    Rle.transpose() * (rPLl - model.link_path_kinematics[k].translation);
+                J.template block<3, 1>(0, link.joint.idx) = zIEe.cross(rPIe);
+                J.template block<3, 1>(3, link.joint.idx) = zIEe;
+            }
+        }
+        return J;
+    }
 
-        // Compute the Jacobian
-        while (current_link.idx != source_idx) {
-            if (current_link.joint.idx != -1) {
-                Eigen::Matrix<Scalar, 3, 1> zIBb =
-                    model.forward_kinematics[current_link.idx].linear() * current_link.joint.axis;
-                Eigen::Matrix<Scalar, 3, 1> rISs =
-                    Hbs.inverse() * model.forward_kinematics[current_link.idx].translation();
-                Eigen::Matrix<Scalar, 3, 1> zISs = Rbs.transpose() * zIBb;  // Transform joint axis to source frame
+    /**
+     * @brief Computes the spatial velocity of the target link from the base link. The linear part is stacked above
+     * the angular part.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param target_link Target link, which can be an integer (index) or a string (name).
+     * @param frame Reference frame in which the velocity is expressed, by default the base link axes about the target.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @tparam TargetLink Type of target_link parameter, which can be int or std::string.
+     * @return The spatial velocity of the target link from the base link, in the requested frame.
+     */
+    template <typename Scalar, int nq, typename TargetLink>
+    Eigen::Matrix<Scalar, 6, 1> spatial_velocity(Model<Scalar, nq>& model,
+                                                 const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                 const Eigen::Matrix<Scalar, nq, 1>& dq,
+                                                 const TargetLink& target_link,
+                                                 const ReferenceFrame frame = ReferenceFrame::LOCAL_WORLD_ALIGNED) {
+        return jacobian(model, q, target_link, frame) * dq;
+    }
 
-                if (current_link.joint.type == JointType::PRISMATIC) {
-                    J.block(0, current_link.joint.idx, 3, 1) = zISs;
-                    J.block(3, current_link.joint.idx, 3, 1) = Eigen::Matrix<Scalar, 3, 1>::Zero();
+    /**
+     * @brief Computes the spatial velocity of the target link from the source link, where the source link is an
+     * ancestor of the target link. The linear part is stacked above the angular part.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @param target_link Target link, which can be an integer (index) or a string (name).
+     * @param source_link Source link, which can be an integer (index) or a string (name).
+     * @param frame Reference frame in which the velocity is expressed, by default the source link axes about the
+     * target.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @tparam TargetLink Type of target_link parameter, which can be int or std::string.
+     * @tparam SourceLink Type of source_link parameter, which can be int or std::string.
+     * @return The spatial velocity of the target link from the source link, in the requested frame.
+     */
+    template <typename Scalar, int nq, typename TargetLink, typename SourceLink>
+    Eigen::Matrix<Scalar, 6, 1> spatial_velocity(Model<Scalar, nq>& model,
+                                                 const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                 const Eigen::Matrix<Scalar, nq, 1>& dq,
+                                                 const TargetLink& target_link,
+                                                 const SourceLink& source_link,
+                                                 const ReferenceFrame frame = ReferenceFrame::LOCAL_WORLD_ALIGNED) {
+        return jacobian(model, q, target_link, source_link, frame) * dq;
+    }
+
+    /**
+     * @brief A contact point, such as a taxel of a tactile skin, fixed to a link.
+     * @tparam Scalar type of the tinyrobotics model.
+     */
+    template <typename Scalar>
+    struct ContactPoint {
+        /// @brief Index of the link the point is fixed to.
+        int link = 0;
+
+        /// @brief Position of the point in the link frame.
+        Eigen::Matrix<Scalar, 3, 1> point = Eigen::Matrix<Scalar, 3, 1>::Zero();
+    };
+
+    /**
+     * @brief Linear jacobians of many contact points from the base link, stored as structure of arrays. Row i of x, y
+     * and z holds the x, y and z row of the jacobian of point i in the base frame, so each column is contiguous over
+     * the points.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    struct ContactJacobians {
+        /// @brief Positions of the points in the base frame, one column per point.
+        Eigen::Matrix<Scalar, 3, Eigen::Dynamic> positions;
+
+        /// @brief Rows of the jacobians of the points, one row per point.
+        Eigen::Matrix<Scalar, Eigen::Dynamic, nq> x;
+        Eigen::Matrix<Scalar, Eigen::Dynamic, nq> y;
+        Eigen::Matrix<Scalar, Eigen::Dynamic, nq> z;
+
+        /// @brief Get the 3 x nq linear jacobian of one point.
+        Eigen::Matrix<Scalar, 3, nq> jacobian(const int i) const {
+            Eigen::Matrix<Scalar, 3, nq> J;
+            J.row(0) = x.row(i);
+            J.row(1) = y.row(i);
+            J.row(2) = z.row(i);
+            return J;
+        }
+    };
+
+    /**
+     * @brief Get the indices of the links with joints between a link and the base link.
+     * @param model tinyrobotics model.
+     * @param link Index of the link.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Indices of the links with joints from the link up to the base link.
+     * @throws std::invalid_argument if the link index is out of range.
+     */
+    template <typename Scalar, int nq>
+    std::vector<int> joint_chain(const Model<Scalar, nq>& model, const int link) {
+        if (link < 0 || link >= int(model.links.size())) {
+            throw std::invalid_argument("Error! Link index " + std::to_string(link) + " is not in the model.");
+        }
+        std::vector<int> chain;
+        for (int idx = link; idx != model.base_link_idx && idx != -1; idx = model.links[idx].parent) {
+            if (model.links[idx].joint.idx != -1) {
+                chain.push_back(idx);
+            }
+        }
+        return chain;
+    }
+
+    /**
+     * @brief Computes the linear jacobians of many contact points from the base link. Forward kinematics is run once
+     * and the axis and moment of each joint are shared by all points below it, so each jacobian entry costs a cross
+     * product term.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param contacts Contact points.
+     * @param result Jacobians of the points, resized if the number of points changed.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @throws std::invalid_argument if a contact point is on a link which is not in the model.
+     */
+    template <typename Scalar, int nq>
+    void contact_jacobians(Model<Scalar, nq>& model,
+                           const Eigen::Matrix<Scalar, nq, 1>& q,
+                           const std::vector<ContactPoint<Scalar>>& contacts,
+                           ContactJacobians<Scalar, nq>& result) {
+        forward_kinematics(model, q);
+
+        // Axis z and moment z x o of each joint in the base frame, the column of point p is z x p - z x o
+        Eigen::Matrix<Scalar, 3, nq> axes    = Eigen::Matrix<Scalar, 3, nq>::Zero();
+        Eigen::Matrix<Scalar, 3, nq> moments = Eigen::Matrix<Scalar, 3, nq>::Zero();
+        for (int i = 0; i < nq; ++i) {
+            const Link<Scalar>& link = model.links[model.q_map[i]];
+            axes.col(i)              = model.link_poses[link.idx].rotation * link.joint.axis;
+            if (link.joint.type == JointType::REVOLUTE) {
+                moments.col(i) = axes.col(i).cross(model.link_poses[link.idx].translation);
+            }
+        }
+
+        const int n = contacts.size();
+        result.positions.resize(3, n);
+        result.x.setZero(n, nq);
+        result.y.setZero(n, nq);
+        result.z.setZero(n, nq);
+        std::vector<std::vector<int>> chains(model.links.size());
+        std::vector<bool> has_chain(model.links.size(), false);
+        for (int k = 0; k < n; ++k) {
+            const int link = contacts[k].link;
+            if (link < 0 || link >= int(model.links.size()) || !has_chain[link]) {
+                std::vector<int> chain = joint_chain(model, link);
+                chains[link]           = std::move(chain);
+                has_chain[link]        = true;
+            }
+            const Eigen::Matrix<Scalar, 3, 1> p = model.link_poses[link] * contacts[k].point;
+            result.positions.col(k)             = p;
+            for (const int link_idx : chains[link]) {
+                const Link<Scalar>& chain_link = model.links[link_idx];
+                const int j                    = chain_link.joint.idx;
+                if (chain_link.joint.type == JointType::PRISMATIC) {
+                    result.x(k, j) = axes(0, j);
+                    result.y(k, j) = axes(1, j);
+                    result.z(k, j) = axes(2, j);
                 }
-                else if (current_link.joint.type == JointType::REVOLUTE) {
-                    J.block(0, current_link.joint.idx, 3, 1) = zISs.cross(rTSs - rISs);
-                    J.block(3, current_link.joint.idx, 3, 1) = zISs;
+                else if (chain_link.joint.type == JointType::REVOLUTE) {
+                    result.x(k, j) = axes(1, j) * p(2) - axes(2, j) * p(1) - moments(0, j);
+                    result.y(k, j) = axes(2, j) * p(0) - axes(0, j) * p(2) - moments(1, j);
+                    result.z(k, j) = axes(0, j) * p(1) - axes(1, j) * p(0) - moments(2, j);
                 }
             }
-            current_link = model.links[current_link.parent];
         }
+    }
 
-        return J;
+    /**
+     * @brief Computes the linear jacobians of many contact points from the base link.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param contacts Contact points.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Jacobians of the points.
+     */
+    template <typename Scalar, int nq>
+    ContactJacobians<Scalar, nq> contact_jacobians(Model<Scalar, nq>& model,
+                                                   const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                   const std::vector<ContactPoint<Scalar>>& contacts) {
+        ContactJacobians<Scalar, nq> result;
+        contact_jacobians(model, q, contacts, result);
+        return result;
+    }
+
+    /**
+     * @brief Computes the joint torques of forces acting at many contact points, the sum of J^T f over the points,
+     * without forming the jacobians. The force and moment about the base origin are summed per link, then each joint
+     * projects the sum over the links below it onto its axis.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param contacts Contact points.
+     * @param forces Force at each contact point in the base frame, one column per point.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Joint torques of the contact forces.
+     * @throws std::invalid_argument if the number of forces does not match the contact points or a contact point is
+     * on a link which is not in the model.
+     */
+    template <typename Scalar, int nq>
+    Eigen::Matrix<Scalar, nq, 1> contact_torques(Model<Scalar, nq>& model,
+                                                 const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                 const std::vector<ContactPoint<Scalar>>& contacts,
+                                                 const Eigen::Matrix<Scalar, 3, Eigen::Dynamic>& forces) {
+        if (forces.cols() != int(contacts.size())) {
+            throw std::invalid_argument("Error! Got " + std::to_string(forces.cols()) + " forces for "
+                                        + std::to_string(contacts.size()) + " contact points.");
+        }
+        forward_kinematics(model, q);
+
+        // Sum the force and moment about the base origin on each link
+        const int n_links = model.links.size();
+        using Vectors3        = Eigen::Matrix<Scalar, 3, Eigen::Dynamic>;
+        Vectors3 link_forces  = Vectors3::Zero(3, n_links);
+        Vectors3 link_moments = Vectors3::Zero(3, n_links);
+        for (size_t k = 0; k < contacts.size(); ++k) {
+            const int link = contacts[k].link;
+            if (link < 0 || link >= n_links) {
+                throw std::invalid_argument("Error! Link index " + std::to_string(link) + " is not in the model.");
+            }
+            const Eigen::Matrix<Scalar, 3, 1> p = model.link_poses[link] * contacts[k].point;
+            link_forces.col(link) += forces.col(k);
+            link_moments.col(link) += p.cross(forces.col(k));
+        }
+
+        // Accumulate the sums onto each joint above the loaded links
+        Eigen::Matrix<Scalar, 3, nq> joint_forces  = Eigen::Matrix<Scalar, 3, nq>::Zero();
+        Eigen::Matrix<Scalar, 3, nq> joint_moments = Eigen::Matrix<Scalar, 3, nq>::Zero();
+        for (int link = 0; link < n_links; ++link) {
+            if (link_forces.col(link).isZero(0) && link_moments.col(link).isZero(0)) {
+                continue;
+            }
+            for (const int idx : joint_chain(model, link)) {
+                joint_forces.col(model.links[idx].joint.idx) += link_forces.col(link);
+                joint_moments.col(model.links[idx].joint.idx) += link_moments.col(link);
+            }
+        }
+
+        Eigen::Matrix<Scalar, nq, 1> tau = Eigen::Matrix<Scalar, nq, 1>::Zero();
+        for (int i = 0; i < nq; ++i) {
+            const Link<Scalar>& link            = model.links[model.q_map[i]];
+            const Eigen::Matrix<Scalar, 3, 1> z = model.link_poses[link.idx].rotation * link.joint.axis;
+            const Eigen::Matrix<Scalar, 3, 1> o = model.link_poses[link.idx].translation;
+            if (link.joint.type == JointType::PRISMATIC) {
+                tau(i) = z.dot(joint_forces.col(i));
+            }
+            else if (link.joint.type == JointType::REVOLUTE) {
+                tau(i) = z.dot(joint_moments.col(i) - o.cross(joint_forces.col(i)));
+            }
+        }
+        return tau;
     }
 
     /**
@@ -8,6 +8,67 @@
  */
 namespace tinyrobotics {
 
+    /// @brief Geometry types of link collision elements.
+    enum class CollisionGeometry {
+        /// @brief Box centred on the collision origin.
+        BOX,
+
+        /// @brief Sphere centred on the collision origin.
+        SPHERE,
+
+        /// @brief Cylinder centred on the collision origin with its axis along z.
+        CYLINDER,
+
+        /// @brief Mesh file, which is not loaded.
+        MESH
+    };
+
+    /**
+     * @brief Collision element of a link.
+     * @tparam Scalar Scalar type of the collision element.
+     */
+    template <typename Scalar>
+    struct Collision {
+        /// @brief Geometry type.
+        CollisionGeometry geometry = CollisionGeometry::BOX;
+
+        /// @brief Transform from the collision frame to the link frame.
+        Eigen::Transform<Scalar, 3, Eigen::Isometry> origin = Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity();
+
+        /// @brief Side lengths of a box [m].
+        Eigen::Matrix<Scalar, 3, 1> size = Eigen::Matrix<Scalar, 3, 1>::Zero();
+
+        /// @brief Radius of a sphere or cylinder [m].
+        Scalar radius = 0;
+
+        /// @brief Length of a cylinder [m].
+        Scalar length = 0;
+
+        /// @brief File name of a mesh.
+        std::string filename = "";
+
+        /// @brief Scale of a mesh.
+        Eigen::Matrix<Scalar, 3, 1> scale = Eigen::Matrix<Scalar, 3, 1>::Ones();
+
+        /**
+         * @brief Casts the collision element to a new scalar type.
+         * @tparam NewScalar scalar type to cast the collision element to.
+         * @return Collision element with new scalar type.
+         */
+        template <typename NewScalar>
+        Collision<NewScalar> cast() const {
+            Collision<NewScalar> new_collision = Collision<NewScalar>();
+            new_collision.geometry             = geometry;
+            new_collision.origin               = origin.template cast<NewScalar>();
+            new_collision.size                 = size.template cast<NewScalar>();
+            new_collision.radius               = NewScalar(radius);
+            new_collision.length               = NewScalar(length);
+            new_collision.filename             = filename;
+            new_collision.scale                = scale.template cast<NewScalar>();
+            return new_collision;
+        }
+    };
+
     /**
      * @brief Represents a link in a tinyrobotics model.
      * @tparam Scalar Scalar type of the link.
@@ -43,6 +104,9 @@ namespace tinyrobotics {
         // @brief Spatial inertia matrix of the link.
         Eigen::Matrix<Scalar, 6, 6> I = {};
 
+        /// @brief Collision elements of the link.
+        std::vector<Collision<Scalar>> collisions = {};
+
         /**
          * @brief Add a child link index to the list of child links.
          * @param child_link_idx The index of the child link to add.
@@ -68,6 +132,9 @@ namespace tinyrobotics {
             new_link.mass            = NewScalar(mass);
             new_link.joint           = joint.template cast<NewScalar>();
             new_link.I               = I.template cast<NewScalar>();
+            for (const auto& collision : collisions) {
+                new_link.collisions.push_back(collision.template cast<NewScalar>());
+            }
             return new_link;
         }
     };
@@ -58,6 +58,22 @@ namespace tinyrobotics {
         return -cross_spatial(v).transpose();
     }
 
+    /**
+     * @brief Computes the 6x6 matrix of a force vector whose product with a motion vector v is the force cross product
+     * of v with the force vector, so cross_force_bar(f) * v = cross_motion(v) * f.
+     * @param f The force vector.
+     * @tparam Scalar Scalar type.
+     * @return 6x6 matrix of the force vector.
+     */
+    template <typename Scalar>
+    Eigen::Matrix<Scalar, 6, 6> cross_force_bar(const Eigen::Matrix<Scalar, 6, 1>& f) {
+        Eigen::Matrix<Scalar, 6, 6> fbar = Eigen::Matrix<Scalar, 6, 6>::Zero();
+        fbar.template block<3, 3>(0, 0) = -skew(Eigen::Matrix<Scalar, 3, 1>(f.template head<3>()));
+        fbar.template block<3, 3>(0, 3) = -skew(Eigen::Matrix<Scalar, 3, 1>(f.template tail<3>()));
+        fbar.template block<3, 3>(3, 0) = fbar.template block<3, 3>(0, 3);
+        return fbar;
+    }
+
     /**
      * @brief Spatial coordinate transform from a xyz translation
      * @param v The spatial vector
@@ -6,9 +6,16 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
 
+#include "capture.hpp"
 #include "joint.hpp"
 #include "link.hpp"
+#include "pose.hpp"
+#include "sensor.hpp"
 
 /** \file model.hpp
  * @brief Contains struct for representing a tinyrobotics model.
@@ -41,7 +48,13 @@ namespace tinyrobotics {
         /// @brief Vector of parent link indices of the links which have a non-fixed joints
         std::vector<int> parent = {};
 
-        /// @brief Gravitational acceleration vector experienced by model
+        /// @brief Depth of each link in the link tree, zero for the base link
+        std::vector<int> link_depth = {};
+
+        /// @brief Binary lifting table of the link tree, link_ancestors[k][i] is the 2^k-th ancestor of link i or -1
+        std::vector<std::vector<int>> link_ancestors = {};
+
+        /// @brief Gravitational acceleration vector experienced by model, read by the dynamics on every call
         Eigen::Matrix<Scalar, 3, 1> gravity = {0, 0, -9.81};
 
         /// @brief Total mass of the model
@@ -50,23 +63,42 @@ namespace tinyrobotics {
         /// @brief Vector of links in the model
         std::vector<Link<Scalar>> links = {};
 
+        /// @brief Vector of sensors mounted on links of the model
+        std::vector<Sensor<Scalar>> sensors = {};
+
         /// **************** Pre-allcoated variables for kinematics algorithms ****************
 
         /// @brief Mass matrix
         Eigen::Matrix<Scalar, nq, nq> mass_matrix = Eigen::Matrix<Scalar, nq, nq>::Zero();
 
+        /// @brief Time derivative of the mass matrix
+        Eigen::Matrix<Scalar, nq, nq> mass_matrix_derivative = Eigen::Matrix<Scalar, nq, nq>::Zero();
+
+        /// @brief Coriolis matrix
+        Eigen::Matrix<Scalar, nq, nq> coriolis_matrix = Eigen::Matrix<Scalar, nq, nq>::Zero();
+
         /// @brief Potential energy
         Scalar potential_energy = 0;
 
         /// @brief Vector of forward kinematics data
         std::vector<Eigen::Transform<Scalar, 3, Eigen::Isometry>> forward_kinematics = {};
 
+        /// @brief Pose of each link in the base link frame, the compact form of forward_kinematics read by jacobians
+        std::vector<Pose<Scalar>> link_poses = {};
+
         /// @brief Vector of forward kinematics com data
         std::vector<Eigen::Transform<Scalar, 3, Eigen::Isometry>> forward_kinematics_com = {};
 
         /// @brief center of mass position
         Eigen::Matrix<Scalar, 3, 1> center_of_mass = Eigen::Matrix<Scalar, 3, 1>::Zero();
 
+        /// @brief Links on the path between a target and a source link, target side first, excluding their lowest
+        /// common ancestor
+        std::vector<int> link_path = {};
+
+        /// @brief Poses of the links on link_path relative to the lowest common ancestor
+        std::vector<Pose<Scalar>> link_path_kinematics = {};
+
         /// **************** Pre-allcoated variables for dynamics algorithms ****************
 
         /// @brief Spatial transforms from parent to child links
@@ -124,6 +156,18 @@ namespace tinyrobotics {
         std::vector<Eigen::Matrix<Scalar, 6, 6>> IC =
             std::vector<Eigen::Matrix<Scalar, 6, 6>>(nq, Eigen::Matrix<Scalar, 6, 6>::Zero());
 
+        /// @brief Time derivatives of the composite inertias of the subtrees
+        std::vector<Eigen::Matrix<Scalar, 6, 6>> dIC =
+            std::vector<Eigen::Matrix<Scalar, 6, 6>>(nq, Eigen::Matrix<Scalar, 6, 6>::Zero());
+
+        /// @brief Composite Coriolis matrices of the subtrees
+        std::vector<Eigen::Matrix<Scalar, 6, 6>> BC =
+            std::vector<Eigen::Matrix<Scalar, 6, 6>>(nq, Eigen::Matrix<Scalar, 6, 6>::Zero());
+
+        /// @brief Time derivatives of the motion subspace matrices
+        std::vector<Eigen::Matrix<Scalar, 6, 1>> dS =
+            std::vector<Eigen::Matrix<Scalar, 6, 1>>(nq, Eigen::Matrix<Scalar, 6, 1>::Zero());
+
         /// @brief Gravity vector in spatial coordinates
         Eigen::Matrix<Scalar, 6, 1> spatial_gravity = Eigen::Matrix<Scalar, 6, 1>::Zero();
 
@@ -136,6 +180,18 @@ namespace tinyrobotics {
         /// @brief Joint torque/force
         Eigen::Matrix<Scalar, nq, 1> tau = Eigen::Matrix<Scalar, nq, 1>::Zero();
 
+        /// @brief Wrenches transmitted through the joint of each link into the link, [torque; force], indexed by link
+        std::vector<Eigen::Matrix<Scalar, 6, 1>> joint_wrenches = {};
+
+        /// @brief Readings of the sensors, [angular velocity; specific force] for an IMU and [torque; force] for a
+        /// force-torque sensor, in the sensor frame
+        std::vector<Eigen::Matrix<Scalar, 6, 1>> sensor_readings = {};
+
+        /// **************** Solver call capture ****************
+
+        /// @brief Buffer recording the inputs of solver calls when capture is enabled, shared between copies of the model
+        std::shared_ptr<CaptureBuffer> capture = nullptr;
+
         /**
          * @brief Get a link in the model by name.
          * @param name Name of the link.
@@ -151,6 +207,49 @@ namespace tinyrobotics {
             return Link<Scalar>();
         }
 
+        /**
+         * @brief Get the lowest common ancestor of two links in the link tree, the deepest link which both links are
+         * descendants of (or equal to). Uses the binary lifting table built at load time, in O(log depth).
+         * @param a Index of the first link.
+         * @param b Index of the second link.
+         * @return Index of the lowest common ancestor, or -1 if the links are not in the same tree.
+         */
+        int lowest_common_ancestor(int a, int b) const {
+            if (link_depth.size() != links.size() || link_ancestors.empty()) {
+                // Without a table, mark the ancestors of a and walk up from b
+                std::vector<bool> ancestor(links.size(), false);
+                for (int i = a; i != -1; i = links[i].parent) {
+                    ancestor[i] = true;
+                }
+                for (int i = b; i != -1; i = links[i].parent) {
+                    if (ancestor[i]) {
+                        return i;
+                    }
+                }
+                return -1;
+            }
+            if (link_depth[a] < link_depth[b]) {
+                std::swap(a, b);
+            }
+            // Lift the deeper link to the depth of the other
+            for (int k = link_ancestors.size() - 1; k >= 0; --k) {
+                if (link_depth[a] - (1 << k) >= link_depth[b]) {
+                    a = link_ancestors[k][a];
+                }
+            }
+            if (a == b) {
+                return a;
+            }
+            // Lift both links to just below their lowest common ancestor
+            for (int k = link_ancestors.size() - 1; k >= 0; --k) {
+                if (link_ancestors[k][a] != link_ancestors[k][b]) {
+                    a = link_ancestors[k][a];
+                    b = link_ancestors[k][b];
+                }
+            }
+            return link_ancestors[0][a];
+        }
+
         /**
          * @brief Get the parent link of a link in the model by name.
          * @param link_idx Index of the link in the model.
@@ -184,6 +283,33 @@ namespace tinyrobotics {
             return Joint<Scalar>();
         }
 
+        /**
+         * @brief Mount a sensor on a link in the model.
+         * @param name Name of the sensor.
+         * @param type Type of the sensor.
+         * @param link_name Name of the link the sensor is mounted on.
+         * @param origin Homogeneous transform from the sensor frame to the link frame.
+         * @return Index of the sensor in the model's sensor vector and readings.
+         */
+        int add_sensor(const std::string& name,
+                       const SensorType type,
+                       const std::string& link_name,
+                       const Eigen::Transform<Scalar, 3, Eigen::Isometry>& origin =
+                           Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity()) {
+            const int link_idx = get_link(link_name).idx;
+            if (link_idx == -1) {
+                throw std::runtime_error("Error! Link [" + link_name + "] for sensor [" + name + "] not found!");
+            }
+            Sensor<Scalar> sensor;
+            sensor.name   = name;
+            sensor.type   = type;
+            sensor.link   = link_idx;
+            sensor.origin = origin;
+            sensors.push_back(sensor);
+            sensor_readings.push_back(Eigen::Matrix<Scalar, 6, 1>::Zero());
+            return sensors.size() - 1;
+        }
+
         /**
          * @brief Display details of the model.
          */
@@ -250,12 +376,25 @@ namespace tinyrobotics {
             new_model.name                 = name;
             new_model.n_q                  = n_q;
             new_model.base_link_idx        = base_link_idx;
+            new_model.link_depth           = link_depth;
+            new_model.link_ancestors       = link_ancestors;
             new_model.gravity              = gravity.template cast<NewScalar>();
             new_model.mass                 = NewScalar(mass);
             for (auto& link : links) {
                 new_model.links.push_back(link.template cast<NewScalar>());
             }
+            for (auto& sensor : sensors) {
+                new_model.sensors.push_back(sensor.template cast<NewScalar>());
+            }
+            for (auto& wrench : joint_wrenches) {
+                new_model.joint_wrenches.push_back(wrench.template cast<NewScalar>());
+            }
+            for (auto& reading : sensor_readings) {
+                new_model.sensor_readings.push_back(reading.template cast<NewScalar>());
+            }
             new_model.mass_matrix      = mass_matrix.template cast<NewScalar>();
+            new_model.mass_matrix_derivative = mass_matrix_derivative.template cast<NewScalar>();
+            new_model.coriolis_matrix        = coriolis_matrix.template cast<NewScalar>();
             new_model.potential_energy = NewScalar(potential_energy);
             new_model.C                = C.template cast<NewScalar>();
             new_model.fh               = fh.template cast<NewScalar>();
@@ -266,6 +405,9 @@ namespace tinyrobotics {
             for (int i = 0; i < forward_kinematics.size(); i++) {
                 new_model.forward_kinematics[i] = forward_kinematics[i].template cast<NewScalar>();
             }
+            for (auto& pose : link_poses) {
+                new_model.link_poses.push_back(pose.template cast<NewScalar>());
+            }
             for (int i = 0; i < forward_kinematics_com.size(); i++) {
                 new_model.forward_kinematics_com[i] = forward_kinematics_com[i].template cast<NewScalar>();
             }
@@ -282,10 +424,66 @@ namespace tinyrobotics {
                 new_model.a[i]   = a[i].template cast<NewScalar>();
                 new_model.fvp[i] = fvp[i].template cast<NewScalar>();
                 new_model.IC[i]  = IC[i].template cast<NewScalar>();
+                new_model.dIC[i] = dIC[i].template cast<NewScalar>();
+                new_model.BC[i]  = BC[i].template cast<NewScalar>();
+                new_model.dS[i]  = dS[i].template cast<NewScalar>();
             }
             return new_model;
         }
     };
+
+    /**
+     * @brief Computes a hash of the structure and inertial parameters of a model, used to check trajectory files and
+     * captured calls were recorded with the model they are processed with.
+     * @param model tinyrobotics model.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return 64 bit FNV-1a hash of the model.
+     */
+    template <typename Scalar, int nq>
+    uint64_t model_hash(const Model<Scalar, nq>& model) {
+        uint64_t hash   = 0xcbf29ce484222325ull;
+        auto hash_bytes = [&](const void* data, const size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i) {
+                hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+            }
+        };
+        auto hash_matrix = [&](const auto& matrix) {
+            for (int i = 0; i < matrix.size(); ++i) {
+                const double value = static_cast<double>(matrix.data()[i]);
+                hash_bytes(&value, sizeof(value));
+            }
+        };
+        hash_bytes(&model.n_q, sizeof(model.n_q));
+        for (const auto& link : model.links) {
+            hash_bytes(link.name.data(), link.name.size());
+            hash_bytes(&link.parent, sizeof(link.parent));
+            hash_bytes(&link.joint.idx, sizeof(link.joint.idx));
+            hash_bytes(&link.joint.type, sizeof(link.joint.type));
+            hash_matrix(link.joint.axis);
+            hash_matrix(link.joint.parent_transform.matrix());
+            hash_matrix(link.center_of_mass.matrix());
+            hash_matrix(link.inertia);
+            hash_matrix(Eigen::Matrix<Scalar, 1, 1>(link.mass));
+        }
+        return hash;
+    }
+
+    /**
+     * @brief Enables capture of the inputs of inverse_kinematics and forward_dynamics calls on a model. Copies of the
+     * model made afterwards share the buffer.
+     * @param model tinyrobotics model.
+     * @param capacity Maximum number of calls kept, the oldest calls are overwritten once full.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return The capture buffer.
+     */
+    template <typename Scalar, int nq>
+    std::shared_ptr<CaptureBuffer> enable_capture(Model<Scalar, nq>& model, const size_t capacity = 1024) {
+        model.capture = std::make_shared<CaptureBuffer>(model_hash(model), model.n_q, capacity);
+        return model.capture;
+    }
 }  // namespace tinyrobotics
 
 #endif
\ No newline at end of file
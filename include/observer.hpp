@@ -0,0 +1,158 @@
+#ifndef TR_OBSERVER_HPP
+#define TR_OBSERVER_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "dynamics.hpp"
+#include "math.hpp"
+#include "model.hpp"
+
+/** \file observer.hpp
+ * @brief Contains a generalized momentum observer estimating the external joint torques acting on a tinyrobotics
+ * model.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Terms of the generalized momentum dynamics dp/dt = tau + tau_ext + C(q, dq)^T dq - g(q).
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    struct MomentumTerms {
+        /// @brief Generalized momentum p = M(q) dq.
+        Eigen::Matrix<Scalar, nq, 1> momentum = Eigen::Matrix<Scalar, nq, 1>::Zero();
+
+        /// @brief Transposed Coriolis matrix times the joint velocity, C(q, dq)^T dq.
+        Eigen::Matrix<Scalar, nq, 1> coriolis_transpose = Eigen::Matrix<Scalar, nq, 1>::Zero();
+
+        /// @brief Gravity torque g(q).
+        Eigen::Matrix<Scalar, nq, 1> gravity = Eigen::Matrix<Scalar, nq, 1>::Zero();
+    };
+
+    /**
+     * @brief Compute the generalized momentum, C(q, dq)^T dq and the gravity torque in one recursive pass. The backward
+     * pass accumulates the spatial momentum h_i of each subtree, giving p_i = S_i^T h_i and (C^T dq)_i = (v_i x S_i)^T
+     * h_i, without forming the mass or Coriolis matrices. Uses m.v and m.fvp for the link velocities and subtree
+     * momenta, and m.a and m.pA for the gravity accelerations and forces.
+     * @param m tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param dq Joint velocity of the robot.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return The momentum terms.
+     */
+    template <typename Scalar, int nq>
+    MomentumTerms<Scalar, nq> momentum_terms(Model<Scalar, nq>& m,
+                                             const Eigen::Matrix<Scalar, nq, 1>& q,
+                                             const Eigen::Matrix<Scalar, nq, 1>& dq) {
+        const Eigen::Matrix<Scalar, 6, 1> a0 = base_acceleration_with_gravity(fixed_base(m));
+        for (int i = 0; i < nq; i++) {
+            const Link<Scalar>& link = m.links[m.q_map[i]];
+            m.Xup[i] = homogeneous_to_spatial(link.joint.get_parent_to_child_transform(q(i)).inverse());
+            m.vJ     = link.joint.S * dq(i);
+            if (m.parent[i] == -1) {
+                m.v[i] = m.vJ;
+                m.a[i] = m.Xup[i] * a0;
+            }
+            else {
+                m.v[i] = m.Xup[i] * m.v[m.parent[i]] + m.vJ;
+                m.a[i] = m.Xup[i] * m.a[m.parent[i]];
+            }
+            m.fvp[i] = link.I * m.v[i];
+            m.pA[i]  = link.I * m.a[i];
+        }
+
+        MomentumTerms<Scalar, nq> terms;
+        for (int i = nq - 1; i >= 0; i--) {
+            const Eigen::Matrix<Scalar, 6, 1>& S = m.links[m.q_map[i]].joint.S;
+            terms.momentum(i)                    = S.dot(m.fvp[i]);
+            terms.coriolis_transpose(i)          = (cross_spatial(m.v[i]) * S).dot(m.fvp[i]);
+            terms.gravity(i)                     = S.dot(m.pA[i]);
+            if (m.parent[i] != -1) {
+                m.fvp[m.parent[i]] += m.Xup[i].transpose() * m.fvp[i];
+                m.pA[m.parent[i]] += m.Xup[i].transpose() * m.pA[i];
+            }
+        }
+        return terms;
+    }
+
+    /**
+     * @brief Generalized momentum observer estimating the external joint torques from the measured joint positions,
+     * velocities and commanded torques. The residual r = K (p - p0 - integral of (tau + C^T dq - g + r) dt) follows the
+     * external torques as a first order filter with time constants 1 / K. All state is preallocated, so updates do not
+     * allocate.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    class MomentumObserver {
+    public:
+        /**
+         * @brief Constructs an observer with its own copy of the model.
+         * @param model tinyrobotics model.
+         * @param gains Observer gain of each joint [1/s].
+         */
+        MomentumObserver(const Model<Scalar, nq>& model, const Eigen::Matrix<Scalar, nq, 1>& gains)
+            : model(model), gains(gains) {}
+
+        /**
+         * @brief Resets the observer to zero residual at the current state.
+         * @param q Joint configuration of the robot.
+         * @param dq Joint velocity of the robot.
+         */
+        void reset(const Eigen::Matrix<Scalar, nq, 1>& q, const Eigen::Matrix<Scalar, nq, 1>& dq) {
+            terms    = momentum_terms(model, q, dq);
+            integral = terms.momentum;
+            r.setZero();
+        }
+
+        /**
+         * @brief Updates the residual with a new measurement.
+         * @param q Joint configuration of the robot.
+         * @param dq Joint velocity of the robot.
+         * @param tau Joint torque applied over the last time step.
+         * @param dt Time step since the last update [s].
+         * @return Estimated external joint torques.
+         */
+        const Eigen::Matrix<Scalar, nq, 1>& update(const Eigen::Matrix<Scalar, nq, 1>& q,
+                                                   const Eigen::Matrix<Scalar, nq, 1>& dq,
+                                                   const Eigen::Matrix<Scalar, nq, 1>& tau,
+                                                   const Scalar dt) {
+            integral += (tau + terms.coriolis_transpose - terms.gravity + r) * dt;
+            terms = momentum_terms(model, q, dq);
+            r     = gains.cwiseProduct(terms.momentum - integral);
+            return r;
+        }
+
+        /// @brief Get the estimated external joint torques.
+        const Eigen::Matrix<Scalar, nq, 1>& residual() const {
+            return r;
+        }
+
+        /// @brief Get the momentum terms of the last update.
+        const MomentumTerms<Scalar, nq>& momentum() const {
+            return terms;
+        }
+
+    private:
+        /// @brief Model used as the workspace of the recursive pass.
+        Model<Scalar, nq> model;
+
+        /// @brief Observer gain of each joint.
+        Eigen::Matrix<Scalar, nq, 1> gains;
+
+        /// @brief Momentum terms of the last update.
+        MomentumTerms<Scalar, nq> terms;
+
+        /// @brief Initial momentum plus the integrated momentum rate.
+        Eigen::Matrix<Scalar, nq, 1> integral = Eigen::Matrix<Scalar, nq, 1>::Zero();
+
+        /// @brief Residual, the estimated external joint torques.
+        Eigen::Matrix<Scalar, nq, 1> r = Eigen::Matrix<Scalar, nq, 1>::Zero();
+    };
+
+}  // namespace tinyrobotics
+
+#endif
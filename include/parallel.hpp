@@ -0,0 +1,235 @@
+#ifndef TR_PARALLEL_HPP
+#define TR_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** \file parallel.hpp
+ * @brief Contains helpers for running tinyrobotics algorithms over many samples in parallel.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Get the default number of threads to use for parallel algorithms.
+     * @return Number of hardware threads, or one if it cannot be determined.
+     */
+    inline int default_thread_count() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * @brief Runs a function over the range [0, n) split into contiguous chunks, one chunk per thread. The calling
+     * thread processes the first chunk.
+     * @param n Number of items to process.
+     * @param function Function called as function(begin, end, thread_idx) for each chunk.
+     * @param n_threads Number of threads to use, the default thread count if zero or less.
+     * @tparam Function Type of the function.
+     */
+    template <typename Function>
+    void parallel_for(const int n, const Function& function, int n_threads = 0) {
+        if (n_threads <= 0) {
+            n_threads = default_thread_count();
+        }
+        n_threads = std::max(1, std::min(n_threads, n));
+        if (n_threads == 1) {
+            function(0, n, 0);
+            return;
+        }
+        const int chunk = (n + n_threads - 1) / n_threads;
+        std::vector<std::thread> threads;
+        threads.reserve(n_threads - 1);
+        for (int t = 1; t < n_threads; ++t) {
+            const int begin = std::min(n, t * chunk);
+            const int end   = std::min(n, begin + chunk);
+            threads.emplace_back([&function, begin, end, t]() { function(begin, end, t); });
+        }
+        function(0, std::min(n, chunk), 0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Persistent pool of threads running batches of independent tasks of uneven cost. Each thread owns a queue
+     * of tasks which it works through from the front, and once empty steals from the back of the other queues, so
+     * threads which finish early take over the remaining work. The thread calling run takes part as thread 0.
+     */
+    class WorkStealingScheduler {
+    public:
+        /**
+         * @brief Starts the pool.
+         * @param n_threads Number of threads including the calling thread, the default thread count if zero or less.
+         */
+        explicit WorkStealingScheduler(int n_threads = 0)
+            : queues(n_threads <= 0 ? default_thread_count() : n_threads) {
+            for (auto& queue : queues) {
+                queue = std::make_unique<Queue>();
+            }
+            for (int t = 1; t < int(queues.size()); ++t) {
+                workers.emplace_back([this, t]() { worker_loop(t); });
+            }
+        }
+
+        ~WorkStealingScheduler() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        WorkStealingScheduler(const WorkStealingScheduler&)            = delete;
+        WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+        /// @brief Get the number of threads including the calling thread.
+        int n_threads() const {
+            return queues.size();
+        }
+
+        /**
+         * @brief Runs the tasks [0, n) and waits for all of them to finish. Tasks are dealt round robin over the
+         * thread queues, so tasks expected to take longest should have the lowest indices.
+         * @param n Number of tasks.
+         * @param function Function called as function(task_idx, thread_idx) for each task.
+         * @tparam Function Type of the function.
+         * @throws The first exception thrown by a task, once all tasks have finished.
+         */
+        template <typename Function>
+        void run(const int n, const Function& function) {
+            if (n <= 0) {
+                return;
+            }
+            std::lock_guard<std::mutex> run_lock(run_mutex);
+            job       = [&function](int task, int thread) { function(task, thread); };
+            error     = nullptr;
+            remaining = n;
+            for (int task = 0; task < n; ++task) {
+                Queue& queue = *queues[task % queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(task);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++generation;
+            }
+            wake.notify_all();
+            work(0);
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]() { return remaining == 0; });
+            job = nullptr;
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+    private:
+        /// @brief Task queue owned by one thread.
+        struct Queue {
+            std::mutex mutex;
+            std::deque<int> tasks;
+        };
+
+        /// @brief Waits for batches and works on them until the pool is stopped.
+        void worker_loop(const int thread) {
+            size_t seen = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]() { return stopping || generation != seen; });
+                    if (stopping) {
+                        return;
+                    }
+                    seen = generation;
+                }
+                work(thread);
+            }
+        }
+
+        /// @brief Runs tasks from the thread's own queue, then steals from the others until all queues are empty.
+        void work(const int thread) {
+            int task = 0;
+            while (pop(thread, task)) {
+                try {
+                    job(task, thread);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                if (remaining.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done.notify_all();
+                }
+            }
+        }
+
+        /// @brief Takes the next task from the front of the thread's own queue or the back of another queue.
+        bool pop(const int thread, int& task) {
+            for (size_t i = 0; i < queues.size(); ++i) {
+                Queue& queue = *queues[(thread + i) % queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (!queue.tasks.empty()) {
+                    if (i == 0) {
+                        task = queue.tasks.front();
+                        queue.tasks.pop_front();
+                    }
+                    else {
+                        task = queue.tasks.back();
+                        queue.tasks.pop_back();
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// @brief Task queue of each thread.
+        std::vector<std::unique_ptr<Queue>> queues;
+
+        /// @brief Background threads, the calling thread is thread 0.
+        std::vector<std::thread> workers;
+
+        /// @brief Function run for each task of the current batch, set before its tasks are queued.
+        std::function<void(int, int)> job;
+
+        /// @brief Number of tasks of the current batch which have not finished.
+        std::atomic<int> remaining{0};
+
+        /// @brief First exception thrown by a task of the current batch.
+        std::exception_ptr error = nullptr;
+
+        /// @brief Counts batches so waiting threads can tell a new one has started.
+        size_t generation = 0;
+
+        /// @brief Set when the pool is being destroyed.
+        bool stopping = false;
+
+        /// @brief Guards generation, stopping and error.
+        std::mutex mutex;
+
+        /// @brief Serialises calls to run.
+        std::mutex run_mutex;
+
+        /// @brief Signals a new batch or stopping to the background threads.
+        std::condition_variable wake;
+
+        /// @brief Signals the end of a batch to the calling thread.
+        std::condition_variable done;
+    };
+
+}  // namespace tinyrobotics
+
+#endif
@@ -3,6 +3,9 @@
 
 #include <tinyxml2.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "math.hpp"
 #include "model.hpp"
 
@@ -127,6 +130,75 @@ namespace tinyrobotics {
         return e->Attribute("name");
     }
 
+    /**
+     * @brief Construct a Collision from a URDF collision element.
+     * @param xml The XML element containing the collision description
+     * @param link_name Name of the link the collision element belongs to, for error messages
+     * @return The Collision object
+     */
+    template <typename Scalar>
+    Collision<Scalar> collision_from_xml(tinyxml2::XMLElement* xml, const std::string& link_name) {
+        Collision<Scalar> collision = Collision<Scalar>();
+
+        tinyxml2::XMLElement* o = xml->FirstChildElement("origin");
+        if (o != nullptr) {
+            collision.origin = transform_from_xml<Scalar>(o);
+        }
+
+        tinyxml2::XMLElement* geometry = xml->FirstChildElement("geometry");
+        tinyxml2::XMLElement* shape    = geometry != nullptr ? geometry->FirstChildElement() : nullptr;
+        if (shape == nullptr) {
+            throw std::runtime_error("Error while parsing link '" + link_name
+                                     + "' collision element must have a <geometry> element with a shape!");
+        }
+        const auto scalar_attribute = [&](const char* name) {
+            const char* value = shape->Attribute(name);
+            if (value == nullptr) {
+                throw std::runtime_error("Error while parsing link '" + link_name + "' <" + shape->Value()
+                                         + "> element must have a " + name + " attribute!");
+            }
+            try {
+                return Scalar(std::stod(value));
+            }
+            catch (std::invalid_argument& e) {
+                throw std::runtime_error("Error while parsing link '" + link_name + "': collision " + name + " ["
+                                         + value + "] is not a valid double: " + e.what() + "!");
+            }
+        };
+        const std::string type = shape->Value();
+        if (type == "box") {
+            if (shape->Attribute("size") == nullptr) {
+                throw std::runtime_error("Error while parsing link '" + link_name
+                                         + "' <box> element must have a size attribute!");
+            }
+            collision.geometry = CollisionGeometry::BOX;
+            collision.size     = vec_from_string<Scalar>(shape->Attribute("size"));
+        }
+        else if (type == "sphere") {
+            collision.geometry = CollisionGeometry::SPHERE;
+            collision.radius   = scalar_attribute("radius");
+        }
+        else if (type == "cylinder") {
+            collision.geometry = CollisionGeometry::CYLINDER;
+            collision.radius   = scalar_attribute("radius");
+            collision.length   = scalar_attribute("length");
+        }
+        else if (type == "mesh") {
+            collision.geometry = CollisionGeometry::MESH;
+            if (shape->Attribute("filename") != nullptr) {
+                collision.filename = shape->Attribute("filename");
+            }
+            if (shape->Attribute("scale") != nullptr) {
+                collision.scale = vec_from_string<Scalar>(shape->Attribute("scale"));
+            }
+        }
+        else {
+            throw std::runtime_error("Error while parsing link '" + link_name + "': unknown collision geometry <"
+                                     + type + ">!");
+        }
+        return collision;
+    }
+
     /**
      * @brief Construct a Link from a URDF xml element.
      * @param xml The XML element containing the link description
@@ -222,6 +294,12 @@ namespace tinyrobotics {
         // Add the spatial inertia to the link
         link.I = inertia_to_spatial<Scalar>(link.mass, link.center_of_mass.translation(), link.inertia);
 
+        // Add the collision elements to the link
+        for (tinyxml2::XMLElement* c = xml->FirstChildElement("collision"); c != nullptr;
+             c                       = c->NextSiblingElement("collision")) {
+            link.collisions.push_back(collision_from_xml<Scalar>(c, link.name));
+        }
+
         return link;
     }
 
@@ -416,6 +494,49 @@ namespace tinyrobotics {
         }
     }
 
+    /**
+     * @brief Initialize the depth of each link and the binary lifting table of the link tree, used to find the lowest
+     * common ancestor of two links.
+     * @param model Tinyrobtics model.
+     * @tparam Scalar Scalar type of the model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    void init_link_ancestors(Model<Scalar, nq>& model) {
+        const int n_links = model.links.size();
+        model.link_depth.assign(n_links, -1);
+        int max_depth = 0;
+        for (int i = 0; i < n_links; i++) {
+            // Walk up to a link of known depth, then assign the depths on the way back down
+            std::vector<int> path;
+            int top = i;
+            for (; top != -1 && model.link_depth[top] == -1; top = model.links[top].parent) {
+                path.push_back(top);
+            }
+            int depth = top == -1 ? 0 : model.link_depth[top] + 1;
+            for (auto link = path.rbegin(); link != path.rend(); ++link) {
+                model.link_depth[*link] = depth++;
+            }
+            max_depth = std::max(max_depth, model.link_depth[i]);
+        }
+
+        // link_ancestors[k][i] is the 2^k-th ancestor of link i
+        int n_levels = 1;
+        while ((1 << n_levels) <= max_depth) {
+            n_levels++;
+        }
+        model.link_ancestors.assign(n_levels, std::vector<int>(n_links, -1));
+        for (int i = 0; i < n_links; i++) {
+            model.link_ancestors[0][i] = model.links[i].parent;
+        }
+        for (int k = 1; k < n_levels; k++) {
+            for (int i = 0; i < n_links; i++) {
+                const int half             = model.link_ancestors[k - 1][i];
+                model.link_ancestors[k][i] = half == -1 ? -1 : model.link_ancestors[k - 1][half];
+            }
+        }
+    }
+
     /**
      * @brief Updates dynamic links with any fixed joints associated with them, and updates the indices of the
      * dynamic links and their parents.
@@ -564,6 +685,9 @@ namespace tinyrobotics {
         // Initialize the link tree and find the base link index (should be -1)
         init_link_tree(model, joints);
 
+        // Initialize the lowest common ancestor tables of the link tree
+        init_link_ancestors(model);
+
         // Initialize the q_map and parent_map
         init_dynamics(model);
 
@@ -0,0 +1,104 @@
+#ifndef TR_POSE_HPP
+#define TR_POSE_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+/** \file pose.hpp
+ * @brief Contains a compact rigid body pose used internally by the kinematics of a tinyrobotics model.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Rigid body pose stored as a 3x3 rotation and a translation, 12 scalars instead of the 16 of an
+     * Eigen::Transform. Composition, inversion and application only touch the rotation and translation, so the
+     * constant bottom row of a homogeneous transform is never read, multiplied or written. Convert to and from
+     * Eigen::Transform at the API boundary.
+     * @tparam Scalar Scalar type of the pose.
+     */
+    template <typename Scalar>
+    struct Pose {
+        /// @brief Rotation of the pose.
+        Eigen::Matrix<Scalar, 3, 3> rotation = Eigen::Matrix<Scalar, 3, 3>::Identity();
+
+        /// @brief Translation of the pose.
+        Eigen::Matrix<Scalar, 3, 1> translation = Eigen::Matrix<Scalar, 3, 1>::Zero();
+
+        /// @brief Constructs the identity pose.
+        Pose() = default;
+
+        /**
+         * @brief Constructs a pose from a rotation and a translation.
+         * @param rotation Rotation of the pose.
+         * @param translation Translation of the pose.
+         */
+        Pose(const Eigen::Matrix<Scalar, 3, 3>& rotation, const Eigen::Matrix<Scalar, 3, 1>& translation)
+            : rotation(rotation), translation(translation) {}
+
+        /**
+         * @brief Constructs a pose from a homogeneous transform.
+         * @param H Homogeneous transform.
+         */
+        explicit Pose(const Eigen::Transform<Scalar, 3, Eigen::Isometry>& H)
+            : rotation(H.linear()), translation(H.translation()) {}
+
+        /// @brief Get the identity pose.
+        static Pose Identity() {
+            return Pose();
+        }
+
+        /// @brief Get the pose as a homogeneous transform.
+        Eigen::Transform<Scalar, 3, Eigen::Isometry> isometry() const {
+            Eigen::Transform<Scalar, 3, Eigen::Isometry> H;
+            H.linear()      = rotation;
+            H.translation() = translation;
+            H.makeAffine();
+            return H;
+        }
+
+        /**
+         * @brief Composes this pose with another, this * other.
+         * @param other Pose to apply first.
+         * @return The composed pose.
+         */
+        Pose operator*(const Pose& other) const {
+            return Pose(rotation * other.rotation, rotation * other.translation + translation);
+        }
+
+        /**
+         * @brief Applies the pose to a point.
+         * @param point Point to transform.
+         * @return The transformed point, rotation * point + translation.
+         */
+        Eigen::Matrix<Scalar, 3, 1> operator*(const Eigen::Matrix<Scalar, 3, 1>& point) const {
+            return rotation * point + translation;
+        }
+
+        /// @brief Get the inverse of the pose.
+        Pose inverse() const {
+            return Pose(rotation.transpose(), -(rotation.transpose() * translation));
+        }
+
+        /**
+         * @brief Composes the inverse of this pose with another, this^-1 * other, without forming the inverse.
+         * @param other Pose to apply first.
+         * @return The composed pose.
+         */
+        Pose inverse_compose(const Pose& other) const {
+            return Pose(rotation.transpose() * other.rotation,
+                        rotation.transpose() * (other.translation - translation));
+        }
+
+        /**
+         * @brief Casts the pose to a new scalar type.
+         * @tparam NewScalar Scalar type to cast the pose to.
+         * @return Pose with new scalar type.
+         */
+        template <typename NewScalar>
+        Pose<NewScalar> cast() const {
+            return Pose<NewScalar>(rotation.template cast<NewScalar>(), translation.template cast<NewScalar>());
+        }
+    };
+}  // namespace tinyrobotics
+
+#endif
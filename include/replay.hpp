@@ -0,0 +1,104 @@
+#ifndef TR_REPLAY_HPP
+#define TR_REPLAY_HPP
+
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "capture.hpp"
+#include "dynamics.hpp"
+#include "inversekinematics.hpp"
+#include "model.hpp"
+
+/** \file replay.hpp
+ * @brief Contains functions for re-running captured solver calls offline under the benchmark harness.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Timing of a replayed call.
+     */
+    struct ReplayResult {
+        /// @brief Index of the call in the capture, oldest first.
+        int index = 0;
+
+        /// @brief Type of the call.
+        CaptureCallType type = CaptureCallType::INVERSE_KINEMATICS;
+
+        /// @brief Duration of the call when it was captured in nanoseconds.
+        double captured_ns = 0;
+
+        /// @brief Timing of the replayed call.
+        BenchmarkResult benchmark;
+    };
+
+    /**
+     * @brief Re-runs a captured call.
+     * @param model tinyrobotics model the call was captured from, without capture enabled.
+     * @param record The captured call.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Result of the call, the configuration for inverse kinematics or the joint accelerations for forward
+     * dynamics.
+     */
+    template <typename Scalar, int nq>
+    Eigen::Matrix<Scalar, nq, 1> replay_call(Model<Scalar, nq>& model, const CaptureRecord& record) {
+        switch (record.type) {
+            case CaptureCallType::INVERSE_KINEMATICS: {
+                const auto call = decode_inverse_kinematics_call(model, record.values);
+                return inverse_kinematics(model,
+                                          call.target_link_name,
+                                          call.source_link_name,
+                                          call.desired_pose,
+                                          call.q0,
+                                          call.options);
+            }
+            case CaptureCallType::FORWARD_DYNAMICS: {
+                const auto call = decode_forward_dynamics_call<Scalar, nq>(record.values);
+                return forward_dynamics(model, call.q, call.dq, call.tau, call.base, call.f_ext);
+            }
+            default: throw std::invalid_argument("Error! Unknown captured call type.");
+        }
+    }
+
+    /**
+     * @brief Re-runs every captured call under the benchmark harness.
+     * @param model tinyrobotics model the calls were captured from.
+     * @param capture The captured calls.
+     * @param n_repeats Number of timed repetitions of each call.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Timing of each call, in capture order.
+     * @throws std::invalid_argument if the calls were captured from a different model.
+     */
+    template <typename Scalar, int nq>
+    std::vector<ReplayResult> replay(const Model<Scalar, nq>& model, const CaptureBuffer& capture, const int n_repeats = 10) {
+        if (capture.n_q != nq || capture.model_hash != model_hash(model)) {
+            throw std::invalid_argument("Error! Calls were captured from a different model.");
+        }
+
+        // Replay on a copy of the model so the replayed calls are not captured again
+        Model<Scalar, nq> replay_model = model;
+        replay_model.capture           = nullptr;
+
+        std::vector<ReplayResult> results;
+        const std::vector<CaptureRecord> records = capture.records();
+        for (size_t i = 0; i < records.size(); ++i) {
+            ReplayResult result;
+            result.index       = i;
+            result.type        = records[i].type;
+            result.captured_ns = records[i].duration_ns;
+            result.benchmark   = benchmark(
+                (records[i].type == CaptureCallType::INVERSE_KINEMATICS ? "inverse_kinematics #" : "forward_dynamics #")
+                    + std::to_string(i),
+                [&]() { replay_call(replay_model, records[i]); },
+                n_repeats,
+                1);
+            results.push_back(result);
+        }
+        return results;
+    }
+
+}  // namespace tinyrobotics
+
+#endif
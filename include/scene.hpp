@@ -0,0 +1,388 @@
+#ifndef TR_SCENE_HPP
+#define TR_SCENE_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dynamics.hpp"
+#include "inversekinematics.hpp"
+#include "kinematics.hpp"
+#include "model.hpp"
+#include "parallel.hpp"
+
+/** \file scene.hpp
+ * @brief Contains a scene of several robots with different numbers of joints, each placed in a shared world frame,
+ * whose per-tick algorithms are all run through one work-stealing scheduler.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Algorithms run for every robot of a scene on each update.
+     */
+    struct SceneTasks {
+        /// @brief Compute the world frame pose of every link of each robot.
+        bool forward_kinematics = true;
+
+        /// @brief Compute the joint accelerations of each robot from its joint torques.
+        bool forward_dynamics = false;
+
+        /// @brief Compute the joint torques of each robot from its joint accelerations.
+        bool inverse_dynamics = false;
+
+        /// @brief Solve inverse kinematics for the robots which have an inverse kinematics target link set.
+        bool inverse_kinematics = false;
+    };
+
+    /**
+     * @brief Inputs and outputs of one robot in a scene, independent of its number of joints. Each algorithm writes
+     * its own output, so the algorithms of one robot can run concurrently.
+     * @tparam Scalar type of the tinyrobotics models.
+     */
+    template <typename Scalar>
+    class SceneRobotBase {
+    public:
+        using Vector    = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+        using Isometry3 = Eigen::Transform<Scalar, 3, Eigen::Isometry>;
+
+        virtual ~SceneRobotBase() = default;
+
+        /// @brief Name of the robot in the scene.
+        std::string name = "";
+
+        /// @brief Placement of the robot's base link in the world frame.
+        Isometry3 base_pose = Isometry3::Identity();
+
+        /// **************** Inputs ****************
+
+        /// @brief Joint configuration.
+        Vector q;
+
+        /// @brief Joint velocity.
+        Vector dq;
+
+        /// @brief Joint torque, input of forward dynamics.
+        Vector tau;
+
+        /// @brief Joint acceleration, input of inverse dynamics.
+        Vector ddq;
+
+        /// @brief Link whose pose inverse kinematics solves for, no inverse kinematics is run for the robot if empty.
+        std::string ik_target_link = "";
+
+        /// @brief Desired pose of the inverse kinematics target link in the world frame.
+        Isometry3 ik_target_pose = Isometry3::Identity();
+
+        /// **************** Outputs ****************
+
+        /// @brief Pose of every link in the world frame, indexed by link index.
+        std::vector<Isometry3> link_poses = {};
+
+        /// @brief Joint accelerations from forward dynamics.
+        Vector acceleration;
+
+        /// @brief Joint torques from inverse dynamics.
+        Vector torque;
+
+        /// @brief Joint configuration from inverse kinematics, starting from q.
+        Vector ik_solution;
+
+        /// @brief Get the number of configuration coordinates of the robot.
+        virtual int n_q() const = 0;
+
+        /// @brief Get the number of links of the robot.
+        virtual int n_links() const = 0;
+
+        /// @brief Get the index of a link, or -1 if the robot has no link of that name.
+        virtual int link_index(const std::string& link_name) const = 0;
+
+        /// @brief Computes link_poses.
+        virtual void forward_kinematics() = 0;
+
+        /// @brief Computes acceleration, with gravity given in the world frame.
+        virtual void forward_dynamics(const Eigen::Matrix<Scalar, 3, 1>& gravity) = 0;
+
+        /// @brief Computes torque, with gravity given in the world frame.
+        virtual void inverse_dynamics(const Eigen::Matrix<Scalar, 3, 1>& gravity) = 0;
+
+        /// @brief Computes ik_solution.
+        virtual void inverse_kinematics() = 0;
+
+    protected:
+        /**
+         * @brief Get the base state of the robot at rest in its placement.
+         * @param gravity Gravitational acceleration in the world frame.
+         * @return Base state with gravity in the base frame.
+         */
+        BaseState<Scalar> base_state(const Eigen::Matrix<Scalar, 3, 1>& gravity) const {
+            BaseState<Scalar> base;
+            base.gravity = base_pose.linear().transpose() * gravity;
+            return base;
+        }
+    };
+
+    /**
+     * @brief A robot in a scene. Each algorithm has its own copy of the model as a workspace, so the algorithms of one
+     * robot do not share state when they run on different threads.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    class SceneRobot : public SceneRobotBase<Scalar> {
+    public:
+        using typename SceneRobotBase<Scalar>::Vector;
+        using typename SceneRobotBase<Scalar>::Isometry3;
+
+        /**
+         * @brief Constructs a robot at rest in its home configuration.
+         * @param model tinyrobotics model of the robot.
+         */
+        explicit SceneRobot(const Model<Scalar, nq>& model)
+            : fk_model(model), dynamics_model(model), ik_model(model) {
+            this->name = model.name;
+            this->q    = model.home_configuration();
+            this->dq   = Vector::Zero(nq);
+            this->tau  = Vector::Zero(nq);
+            this->ddq  = Vector::Zero(nq);
+        }
+
+        /// @brief Options of the inverse kinematics solver.
+        InverseKinematicsOptions<Scalar, nq> ik_options;
+
+        int n_q() const override {
+            return nq;
+        }
+
+        int n_links() const override {
+            return fk_model.links.size();
+        }
+
+        int link_index(const std::string& link_name) const override {
+            return fk_model.get_link(link_name).idx;
+        }
+
+        void forward_kinematics() override {
+            tinyrobotics::forward_kinematics(fk_model, configuration(this->q));
+            this->link_poses.resize(fk_model.forward_kinematics.size());
+            for (size_t i = 0; i < fk_model.forward_kinematics.size(); ++i) {
+                this->link_poses[i] = this->base_pose * fk_model.forward_kinematics[i];
+            }
+        }
+
+        void forward_dynamics(const Eigen::Matrix<Scalar, 3, 1>& gravity) override {
+            this->acceleration = tinyrobotics::forward_dynamics(dynamics_model,
+                                                                configuration(this->q),
+                                                                configuration(this->dq),
+                                                                configuration(this->tau),
+                                                                this->base_state(gravity));
+        }
+
+        void inverse_dynamics(const Eigen::Matrix<Scalar, 3, 1>& gravity) override {
+            this->torque = tinyrobotics::inverse_dynamics(dynamics_model,
+                                                          configuration(this->q),
+                                                          configuration(this->dq),
+                                                          configuration(this->ddq),
+                                                          this->base_state(gravity));
+        }
+
+        void inverse_kinematics() override {
+            const Isometry3 desired_pose = this->base_pose.inverse() * this->ik_target_pose;
+            this->ik_solution            = tinyrobotics::inverse_kinematics(ik_model,
+                                                                 this->ik_target_link,
+                                                                 ik_model.links[ik_model.base_link_idx].name,
+                                                                 desired_pose,
+                                                                 configuration(this->q),
+                                                                 ik_options);
+        }
+
+    private:
+        /// @brief Checks the size of an input vector and converts it to a fixed size vector.
+        Eigen::Matrix<Scalar, nq, 1> configuration(const Vector& v) const {
+            if (v.size() != nq) {
+                throw std::invalid_argument("Error! Robot [" + this->name + "] expects inputs of size "
+                                            + std::to_string(nq) + " but got " + std::to_string(v.size()) + ".");
+            }
+            return v;
+        }
+
+        /// @brief Workspace of forward kinematics.
+        Model<Scalar, nq> fk_model;
+
+        /// @brief Workspace of forward and inverse dynamics, which run one after the other.
+        Model<Scalar, nq> dynamics_model;
+
+        /// @brief Workspace of inverse kinematics.
+        Model<Scalar, nq> ik_model;
+    };
+
+    /**
+     * @brief Pose of a link of a robot in the world frame.
+     * @tparam Scalar type of the tinyrobotics models.
+     */
+    template <typename Scalar>
+    struct ScenePlacement {
+        /// @brief Index of the robot in the scene.
+        int robot = 0;
+
+        /// @brief Index of the link in the robot.
+        int link = 0;
+
+        /// @brief Pose of the link in the world frame.
+        Eigen::Transform<Scalar, 3, Eigen::Isometry> pose = Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity();
+    };
+
+    /**
+     * @brief A set of robots sharing a world frame and a scheduler. Each update splits the requested algorithms of
+     * every robot into tasks run by a work-stealing scheduler, so a robot with slow inverse kinematics does not hold
+     * up the others.
+     * @tparam Scalar type of the tinyrobotics models.
+     */
+    template <typename Scalar = double>
+    class Scene {
+    public:
+        /**
+         * @brief Constructs an empty scene.
+         * @param n_threads Number of threads of the scheduler including the calling thread, the default thread count
+         * if zero or less.
+         */
+        explicit Scene(const int n_threads = 0) : scheduler(n_threads) {}
+
+        /// @brief Gravitational acceleration in the world frame.
+        Eigen::Matrix<Scalar, 3, 1> gravity = Eigen::Matrix<Scalar, 3, 1>(0, 0, -9.81);
+
+        /**
+         * @brief Adds a robot to the scene.
+         * @param model tinyrobotics model of the robot, copied into the scene.
+         * @param base_pose Placement of the robot's base link in the world frame.
+         * @param name Name of the robot in the scene, the model name if empty.
+         * @tparam nq Number of configuration coordinates (degrees of freedom).
+         * @return The robot, to set its inputs and inverse kinematics options.
+         */
+        template <int nq>
+        SceneRobot<Scalar, nq>& add_robot(const Model<Scalar, nq>& model,
+                                          const Eigen::Transform<Scalar, 3, Eigen::Isometry>& base_pose =
+                                              Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity(),
+                                          const std::string& name = "") {
+            auto robot       = std::make_unique<SceneRobot<Scalar, nq>>(model);
+            robot->base_pose = base_pose;
+            if (!name.empty()) {
+                robot->name = name;
+            }
+            SceneRobot<Scalar, nq>& result = *robot;
+            robots.push_back(std::move(robot));
+            return result;
+        }
+
+        /// @brief Get the number of robots in the scene.
+        int n_robots() const {
+            return robots.size();
+        }
+
+        /// @brief Get a robot by index.
+        SceneRobotBase<Scalar>& robot(const int idx) {
+            return *robots.at(idx);
+        }
+
+        /**
+         * @brief Get a robot by name.
+         * @param name Name of the robot.
+         * @return The robot.
+         * @throws std::invalid_argument if the scene has no robot of that name.
+         */
+        SceneRobotBase<Scalar>& robot(const std::string& name) {
+            for (auto& robot : robots) {
+                if (robot->name == name) {
+                    return *robot;
+                }
+            }
+            throw std::invalid_argument("Error! Scene has no robot named [" + name + "].");
+        }
+
+        /**
+         * @brief Runs the requested algorithms for every robot. Inverse kinematics tasks are queued first as they are
+         * usually the slowest.
+         * @param tasks Algorithms to run.
+         * @throws The first exception thrown by an algorithm, once all tasks have finished.
+         */
+        void update(const SceneTasks& tasks = SceneTasks()) {
+            enum class Kind { INVERSE_KINEMATICS, DYNAMICS, FORWARD_KINEMATICS };
+            struct Task {
+                SceneRobotBase<Scalar>* robot;
+                Kind kind;
+            };
+            std::vector<Task> queue;
+            const int n = robots.size();
+            for (int i = 0; tasks.inverse_kinematics && i < n; ++i) {
+                if (!robots[i]->ik_target_link.empty()) {
+                    queue.push_back({robots[i].get(), Kind::INVERSE_KINEMATICS});
+                }
+            }
+            for (int i = 0; (tasks.forward_dynamics || tasks.inverse_dynamics) && i < n; ++i) {
+                queue.push_back({robots[i].get(), Kind::DYNAMICS});
+            }
+            for (int i = 0; tasks.forward_kinematics && i < n; ++i) {
+                queue.push_back({robots[i].get(), Kind::FORWARD_KINEMATICS});
+            }
+            scheduler.run(queue.size(), [&](const int task_idx, int) {
+                SceneRobotBase<Scalar>& robot = *queue[task_idx].robot;
+                switch (queue[task_idx].kind) {
+                    case Kind::INVERSE_KINEMATICS: robot.inverse_kinematics(); break;
+                    case Kind::DYNAMICS:
+                        if (tasks.forward_dynamics) {
+                            robot.forward_dynamics(gravity);
+                        }
+                        if (tasks.inverse_dynamics) {
+                            robot.inverse_dynamics(gravity);
+                        }
+                        break;
+                    case Kind::FORWARD_KINEMATICS: robot.forward_kinematics(); break;
+                }
+            });
+        }
+
+        /**
+         * @brief Get the world frame pose of a link from the last forward kinematics update.
+         * @param robot_name Name of the robot.
+         * @param link_name Name of the link.
+         * @return Pose of the link in the world frame.
+         * @throws std::invalid_argument if the robot or link does not exist or forward kinematics has not been run.
+         */
+        Eigen::Transform<Scalar, 3, Eigen::Isometry> link_pose(const std::string& robot_name,
+                                                               const std::string& link_name) {
+            SceneRobotBase<Scalar>& r = robot(robot_name);
+            const int link            = r.link_index(link_name);
+            if (link < 0 || link >= int(r.link_poses.size())) {
+                throw std::invalid_argument("Error! No pose of link [" + link_name + "] of robot [" + robot_name
+                                            + "], check the link name and that forward kinematics has been run.");
+            }
+            return r.link_poses[link];
+        }
+
+        /**
+         * @brief Get the world frame poses of the links of all robots from the last forward kinematics update.
+         * @return Pose of every link of every robot, ordered by robot then link index.
+         */
+        std::vector<ScenePlacement<Scalar>> placements() const {
+            std::vector<ScenePlacement<Scalar>> result;
+            for (int i = 0; i < int(robots.size()); ++i) {
+                for (int link = 0; link < int(robots[i]->link_poses.size()); ++link) {
+                    result.push_back({i, link, robots[i]->link_poses[link]});
+                }
+            }
+            return result;
+        }
+
+    private:
+        /// @brief Robots in the scene.
+        std::vector<std::unique_ptr<SceneRobotBase<Scalar>>> robots;
+
+        /// @brief Scheduler running the tasks of each update.
+        WorkStealingScheduler scheduler;
+    };
+
+}  // namespace tinyrobotics
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef TR_SELFFILTER_HPP
+#define TR_SELFFILTER_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "kinematics.hpp"
+#include "model.hpp"
+#include "parallel.hpp"
+
+/** \file selffilter.hpp
+ * @brief Contains a filter classifying which points of a point cloud lie on the robot itself, using the collision
+ * primitives of its links.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Options for the self filter.
+     * @tparam Scalar type of the tinyrobotics model.
+     */
+    template <typename Scalar>
+    struct SelfFilterOptions {
+        /// @brief Distance each primitive is inflated by, to cover sensor noise and calibration error [m].
+        Scalar padding = 0.02;
+
+        /// @brief Side length of the voxels of the coarse prefilter [m].
+        Scalar voxel_size = 0.05;
+
+        /// @brief Number of consecutive points tested together against the same candidate primitives.
+        int chunk_size = 256;
+
+        /// @brief Number of threads to use, the default thread count if zero or less.
+        int n_threads = 0;
+    };
+
+    /**
+     * @brief A link collision primitive placed in the point cloud frame, as used by the self filter.
+     * @tparam Scalar type of the tinyrobotics model.
+     */
+    template <typename Scalar>
+    struct CollisionPrimitive {
+        /// @brief Geometry type, never MESH.
+        CollisionGeometry geometry = CollisionGeometry::BOX;
+
+        /// @brief Index of the link the primitive belongs to.
+        int link = -1;
+
+        /// @brief Rotation from the point cloud frame to the primitive frame.
+        Eigen::Matrix<Scalar, 3, 3> rotation = Eigen::Matrix<Scalar, 3, 3>::Identity();
+
+        /// @brief Centre of the primitive in the point cloud frame.
+        Eigen::Matrix<Scalar, 3, 1> centre = Eigen::Matrix<Scalar, 3, 1>::Zero();
+
+        /// @brief Padded half extents of a box, or radius and radius and half length of a cylinder, or the radius of a
+        /// sphere in every component.
+        Eigen::Matrix<Scalar, 3, 1> half_extents = Eigen::Matrix<Scalar, 3, 1>::Zero();
+
+        /// @brief Axis aligned bounding box of the primitive in the point cloud frame.
+        Eigen::Matrix<Scalar, 3, 1> lower = Eigen::Matrix<Scalar, 3, 1>::Zero();
+        Eigen::Matrix<Scalar, 3, 1> upper = Eigen::Matrix<Scalar, 3, 1>::Zero();
+
+        /**
+         * @brief Tests which of a block of points lie inside the primitive.
+         * @param points Points in the point cloud frame, one column per point.
+         * @return Whether each point lies inside.
+         */
+        template <typename Derived>
+        Eigen::Array<bool, 1, Eigen::Dynamic> contains(const Eigen::MatrixBase<Derived>& points) const {
+            // Transform the whole block into the primitive frame, then test with vectorised array operations
+            const Eigen::Array<Scalar, 3, Eigen::Dynamic> local = (rotation * (points.colwise() - centre)).array();
+            switch (geometry) {
+                case CollisionGeometry::BOX:
+                    return (local.abs() <= half_extents.array().replicate(1, local.cols())).colwise().all();
+                case CollisionGeometry::SPHERE:
+                    return local.square().colwise().sum() <= half_extents(0) * half_extents(0);
+                case CollisionGeometry::CYLINDER:
+                    return (local.template topRows<2>().square().colwise().sum() <= half_extents(0) * half_extents(0))
+                           && (local.row(2).abs() <= half_extents(2));
+                default: return Eigen::Array<bool, 1, Eigen::Dynamic>::Constant(points.cols(), false);
+            }
+        }
+    };
+
+    /**
+     * @brief Places the collision primitives of every link in the point cloud frame. Mesh collision elements are
+     * skipped, so links with only mesh collisions should be given primitives in Link::collisions.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param padding Distance each primitive is inflated by [m].
+     * @param cloud_pose Pose of the point cloud frame in the base link frame.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return The placed primitives.
+     */
+    template <typename Scalar, int nq>
+    std::vector<CollisionPrimitive<Scalar>> collision_primitives(
+        Model<Scalar, nq>& model,
+        const Eigen::Matrix<Scalar, nq, 1>& q,
+        const Scalar padding = 0,
+        const Eigen::Transform<Scalar, 3, Eigen::Isometry>& cloud_pose =
+            Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity()) {
+        forward_kinematics(model, q);
+        const Eigen::Transform<Scalar, 3, Eigen::Isometry> base_to_cloud = cloud_pose.inverse();
+        std::vector<CollisionPrimitive<Scalar>> primitives;
+        for (const auto& link : model.links) {
+            for (const auto& collision : link.collisions) {
+                CollisionPrimitive<Scalar> primitive;
+                primitive.geometry = collision.geometry;
+                primitive.link     = link.idx;
+                switch (collision.geometry) {
+                    case CollisionGeometry::BOX: primitive.half_extents = collision.size / 2; break;
+                    case CollisionGeometry::SPHERE: primitive.half_extents.setConstant(collision.radius); break;
+                    case CollisionGeometry::CYLINDER:
+                        primitive.half_extents << collision.radius, collision.radius, collision.length / 2;
+                        break;
+                    default: continue;
+                }
+                primitive.half_extents.array() += padding;
+                const Eigen::Transform<Scalar, 3, Eigen::Isometry> pose =
+                    base_to_cloud * model.forward_kinematics[link.idx] * collision.origin;
+                primitive.rotation = pose.linear().transpose();
+                primitive.centre   = pose.translation();
+
+                // Half extents of the bounding box are the rotated extents summed by magnitude
+                const Eigen::Matrix<Scalar, 3, 1> extent = pose.linear().cwiseAbs() * primitive.half_extents;
+                primitive.lower                          = primitive.centre - extent;
+                primitive.upper                          = primitive.centre + extent;
+                primitives.push_back(primitive);
+            }
+        }
+        return primitives;
+    }
+
+    /**
+     * @brief Classifies which points of a point cloud lie on the robot. A coarse voxel grid over the primitives
+     * records which primitives overlap each voxel, so each chunk of points is only tested against the primitives
+     * near it, with each test vectorised over the chunk. Chunks are processed in parallel, and point clouds in sensor
+     * order keep neighbouring points in the same chunk.
+     * @param model tinyrobotics model.
+     * @param q Joint configuration of the robot.
+     * @param points Points of the point cloud, one column per point.
+     * @param options Self filter options.
+     * @param cloud_pose Pose of the point cloud frame in the base link frame.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Whether each point lies on the robot.
+     */
+    template <typename Scalar, int nq>
+    Eigen::Array<bool, Eigen::Dynamic, 1> self_filter(
+        Model<Scalar, nq>& model,
+        const Eigen::Matrix<Scalar, nq, 1>& q,
+        const Eigen::Matrix<Scalar, 3, Eigen::Dynamic>& points,
+        const SelfFilterOptions<Scalar>& options = SelfFilterOptions<Scalar>(),
+        const Eigen::Transform<Scalar, 3, Eigen::Isometry>& cloud_pose =
+            Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity()) {
+        const int n_points                             = points.cols();
+        Eigen::Array<bool, Eigen::Dynamic, 1> on_robot = Eigen::Array<bool, Eigen::Dynamic, 1>::Zero(n_points);
+        const std::vector<CollisionPrimitive<Scalar>> primitives =
+            collision_primitives(model, q, options.padding, cloud_pose);
+        if (primitives.empty() || n_points == 0) {
+            return on_robot;
+        }
+
+        // Voxel grid over the bounding box of all primitives, growing the voxels if the grid would be too large
+        Eigen::Matrix<Scalar, 3, 1> lower = primitives[0].lower;
+        Eigen::Matrix<Scalar, 3, 1> upper = primitives[0].upper;
+        for (const auto& primitive : primitives) {
+            lower = lower.cwiseMin(primitive.lower);
+            upper = upper.cwiseMax(primitive.upper);
+        }
+        Scalar voxel_size = std::max(options.voxel_size, Scalar(1e-3));
+        while (((upper - lower) / voxel_size).prod() > Scalar(1 << 21)) {
+            voxel_size *= 2;
+        }
+        const auto voxel_of = [&](const Eigen::Matrix<Scalar, 3, 1>& p) -> Eigen::Array3i {
+            return ((p - lower) / voxel_size).array().floor().template cast<int>();
+        };
+        const Eigen::Array3i dims = voxel_of(upper) + 1;
+
+        // Bitset of the primitives overlapping each voxel
+        const int n_words = (primitives.size() + 63) / 64;
+        std::vector<uint64_t> voxels(size_t(dims.prod()) * n_words, 0);
+        for (size_t p = 0; p < primitives.size(); ++p) {
+            const Eigen::Array3i first = voxel_of(primitives[p].lower);
+            const Eigen::Array3i last  = voxel_of(primitives[p].upper);
+            for (int x = first(0); x <= last(0); ++x) {
+                for (int y = first(1); y <= last(1); ++y) {
+                    for (int z = first(2); z <= last(2); ++z) {
+                        const size_t voxel = size_t((x * dims(1) + y) * dims(2) + z);
+                        voxels[voxel * n_words + p / 64] |= uint64_t(1) << (p % 64);
+                    }
+                }
+            }
+        }
+
+        // Test each chunk against the union of the primitives overlapping the voxels of its points
+        const int chunk_size = std::max(1, options.chunk_size);
+        const int n_chunks   = (n_points + chunk_size - 1) / chunk_size;
+        parallel_for(
+            n_chunks,
+            [&](const int chunk_begin, const int chunk_end, int) {
+                std::vector<uint64_t> candidates(n_words);
+                for (int chunk = chunk_begin; chunk < chunk_end; ++chunk) {
+                    const int begin = chunk * chunk_size;
+                    const int n     = std::min(chunk_size, n_points - begin);
+                    std::fill(candidates.begin(), candidates.end(), 0);
+                    bool any = false;
+                    for (int i = begin; i < begin + n; ++i) {
+                        const Eigen::Matrix<Scalar, 3, 1> v = (points.col(i) - lower) / voxel_size;
+                        if ((v.array() < 0).any() || (v.array() >= dims.template cast<Scalar>()).any()) {
+                            continue;
+                        }
+                        const size_t voxel = (size_t(int(v(0)) * dims(1) + int(v(1))) * dims(2) + int(v(2))) * n_words;
+                        for (int w = 0; w < n_words; ++w) {
+                            candidates[w] |= voxels[voxel + w];
+                            any = any || candidates[w] != 0;
+                        }
+                    }
+                    if (!any) {
+                        continue;
+                    }
+                    for (int w = 0; w < n_words; ++w) {
+                        for (int bit = 0; bit < 64; ++bit) {
+                            if (((candidates[w] >> bit) & 1) == 0) {
+                                continue;
+                            }
+                            const auto inside = primitives[w * 64 + bit].contains(points.middleCols(begin, n));
+                            on_robot.segment(begin, n) = on_robot.segment(begin, n) || inside.transpose();
+                        }
+                    }
+                }
+            },
+            options.n_threads);
+        return on_robot;
+    }
+
+}  // namespace tinyrobotics
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef TR_SENSOR_HPP
+#define TR_SENSOR_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <string>
+
+/** \file sensor.hpp
+ * @brief Contains struct for representing a sensor mounted on a link of a tinyrobotics model.
+ */
+namespace tinyrobotics {
+
+    /// @brief The types of sensors.
+    enum class SensorType {
+        IMU,          ///< Inertial measurement unit, reads angular velocity and specific force
+        FORCE_TORQUE  ///< Force-torque sensor, reads the wrench transmitted through the link's joint
+    };
+
+    /**
+     * @brief Represents a sensor mounted on a link in a tinyrobotics model.
+     * @tparam Scalar Scalar type of the sensor.
+     */
+    template <typename Scalar>
+    struct Sensor {
+        /// @brief Name of the sensor.
+        std::string name = "";
+
+        /// @brief Type of the sensor.
+        SensorType type = SensorType::IMU;
+
+        /// @brief Index of the link the sensor is mounted on in the model's link vector.
+        int link = -1;
+
+        /// @brief Homogeneous transform from the sensor frame to the link frame.
+        Eigen::Transform<Scalar, 3, Eigen::Isometry> origin = Eigen::Transform<Scalar, 3, Eigen::Isometry>::Identity();
+
+        /**
+         * @brief Casts the sensor to a new scalar type.
+         * @tparam NewScalar Scalar type to cast the sensor to.
+         * @return Sensor with new scalar type.
+         */
+        template <typename NewScalar>
+        Sensor<NewScalar> cast() const {
+            Sensor<NewScalar> new_sensor = Sensor<NewScalar>();
+            new_sensor.name              = name;
+            new_sensor.type              = type;
+            new_sensor.link              = link;
+            new_sensor.origin            = origin.template cast<NewScalar>();
+            return new_sensor;
+        }
+    };
+}  // namespace tinyrobotics
+
+#endif
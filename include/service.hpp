@@ -0,0 +1,812 @@
+#ifndef TR_SERVICE_HPP
+#define TR_SERVICE_HPP
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dynamics.hpp"
+#include "inversekinematics.hpp"
+#include "model.hpp"
+#include "parallel.hpp"
+
+/// @brief Magic number at the start of every service message, "TRSV".
+#define TR_SERVICE_MAGIC 0x56535254u
+
+/** \file service.hpp
+ * @brief Contains a local service which loads a model once and serves inverse kinematics and dynamics requests from
+ * many processes over a UNIX domain socket, coalescing concurrent requests into batches.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Types of requests served by the service. Payloads are doubles, with poses as row-major 4x4 matrices.
+     */
+    enum class ServiceRequestType : uint32_t {
+        /// @brief Model information, () -> (n_q, n_links).
+        INFO = 0,
+
+        /// @brief Inverse kinematics of the target link in the source link frame, (pose, q0) -> q.
+        INVERSE_KINEMATICS = 1,
+
+        /// @brief Forward dynamics, (q, dq, tau) -> ddq.
+        FORWARD_DYNAMICS = 2,
+
+        /// @brief Inverse dynamics, (q, dq, ddq) -> tau.
+        INVERSE_DYNAMICS = 3,
+
+        /// @brief Mass matrix, q -> M (n_q x n_q).
+        MASS_MATRIX = 4,
+
+        /// @brief Gravity torque, q -> tau.
+        GRAVITY_TORQUE = 5,
+
+        /// @brief Service statistics, () -> statistics, see ServiceStatistics.
+        STATISTICS = 6
+    };
+
+    /// @brief Number of request types which are solved by the workers and have latency statistics.
+    constexpr int n_solved_request_types = 5;
+
+    /**
+     * @brief Header of every request and response, followed by n_values payload doubles. Error responses have a
+     * non-zero status and are followed by n_values characters of error message instead.
+     */
+    struct ServiceMessageHeader {
+        /// @brief Magic number identifying service messages.
+        uint32_t magic = TR_SERVICE_MAGIC;
+
+        /// @brief Type of the request.
+        ServiceRequestType type = ServiceRequestType::INFO;
+
+        /// @brief Zero for success, non-zero for an error response.
+        int32_t status = 0;
+
+        /// @brief Index of the target link, used by inverse kinematics.
+        int32_t target_link = -1;
+
+        /// @brief Index of the source link, used by inverse kinematics.
+        int32_t source_link = -1;
+
+        /// @brief Number of values in the payload.
+        uint32_t n_values = 0;
+    };
+
+    /**
+     * @brief Latency statistics for one type of request.
+     */
+    struct LatencyStatistics {
+        /// @brief Number of requests served.
+        double count = 0;
+
+        /// @brief Mean and maximum time spent waiting in the queue in microseconds.
+        double mean_queue_us = 0;
+        double max_queue_us  = 0;
+
+        /// @brief Mean and maximum time spent solving the batch containing the request in microseconds.
+        double mean_solve_us = 0;
+        double max_solve_us  = 0;
+
+        /**
+         * @brief Adds the latencies of a request.
+         * @param queue_us Time the request spent in the queue in microseconds.
+         * @param solve_us Time taken to solve the request in microseconds.
+         */
+        void add(const double queue_us, const double solve_us) {
+            count++;
+            mean_queue_us += (queue_us - mean_queue_us) / count;
+            mean_solve_us += (solve_us - mean_solve_us) / count;
+            max_queue_us = std::max(max_queue_us, queue_us);
+            max_solve_us = std::max(max_solve_us, solve_us);
+        }
+    };
+
+    /**
+     * @brief Statistics of a running service.
+     */
+    struct ServiceStatistics {
+        /// @brief Latencies indexed by request type, starting from INVERSE_KINEMATICS.
+        LatencyStatistics latency[n_solved_request_types];
+
+        /// @brief Number of batches dispatched to the workers.
+        double n_batches = 0;
+
+        /// @brief Mean number of requests per batch.
+        double mean_batch_size = 0;
+
+        /// @brief Number of values when serialized into a payload.
+        static constexpr int n_values = 5 * n_solved_request_types + 2;
+
+        /**
+         * @brief Get the latency statistics of a request type.
+         * @param type Type of the request.
+         * @return The latency statistics.
+         */
+        LatencyStatistics& operator[](const ServiceRequestType type) {
+            return latency[static_cast<int>(type) - static_cast<int>(ServiceRequestType::INVERSE_KINEMATICS)];
+        }
+
+        /**
+         * @brief Serializes the statistics into a payload.
+         * @return The statistics as doubles.
+         */
+        std::vector<double> serialize() const {
+            std::vector<double> values;
+            for (const auto& l : latency) {
+                values.insert(values.end(), {l.count, l.mean_queue_us, l.max_queue_us, l.mean_solve_us, l.max_solve_us});
+            }
+            values.insert(values.end(), {n_batches, mean_batch_size});
+            return values;
+        }
+
+        /**
+         * @brief Deserializes the statistics from a payload.
+         * @param values The statistics as doubles.
+         * @return The statistics.
+         */
+        static ServiceStatistics deserialize(const std::vector<double>& values) {
+            if (values.size() != n_values) {
+                throw std::runtime_error("Error! Malformed service statistics.");
+            }
+            ServiceStatistics statistics;
+            for (int i = 0; i < n_solved_request_types; ++i) {
+                statistics.latency[i] = {values[5 * i],
+                                         values[5 * i + 1],
+                                         values[5 * i + 2],
+                                         values[5 * i + 3],
+                                         values[5 * i + 4]};
+            }
+            statistics.n_batches       = values[5 * n_solved_request_types];
+            statistics.mean_batch_size = values[5 * n_solved_request_types + 1];
+            return statistics;
+        }
+    };
+
+    /**
+     * @brief Reads exactly size bytes from a socket.
+     * @param fd Socket file descriptor.
+     * @param data Buffer to read into.
+     * @param size Number of bytes to read.
+     * @return True if all bytes were read, false if the connection was closed.
+     */
+    inline bool read_exact(const int fd, void* data, size_t size) {
+        char* ptr = static_cast<char*>(data);
+        while (size > 0) {
+            const ssize_t n = ::recv(fd, ptr, size, 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            ptr += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Writes exactly size bytes to a socket.
+     * @param fd Socket file descriptor.
+     * @param data Buffer to write from.
+     * @param size Number of bytes to write.
+     * @return True if all bytes were written, false if the connection was closed.
+     */
+    inline bool write_exact(const int fd, const void* data, size_t size) {
+        const char* ptr = static_cast<const char*>(data);
+        while (size > 0) {
+            const ssize_t n = ::send(fd, ptr, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            ptr += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Creates the address of a UNIX domain socket.
+     * @param socket_path Path of the socket.
+     * @return The socket address.
+     * @throws std::invalid_argument if the path is too long.
+     */
+    inline sockaddr_un unix_socket_address(const std::string& socket_path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Error! Socket path [" + socket_path + "] is too long.");
+        }
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        return address;
+    }
+
+    /**
+     * @brief Options of the service.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    struct ServiceOptions {
+        /// @brief Number of worker threads solving batches.
+        int n_workers = default_thread_count();
+
+        /// @brief Maximum number of requests coalesced into a batch.
+        int max_batch_size = 64;
+
+        /// @brief Time a worker waits for more requests to fill a batch once one request is queued.
+        std::chrono::microseconds batch_window = std::chrono::microseconds(200);
+
+        /// @brief Options of the inverse kinematics solver, which always uses the Levenberg-Marquardt method.
+        InverseKinematicsOptions<Scalar, nq> ik_options;
+    };
+
+    /**
+     * @brief Service which loads a model once and serves requests from local clients over a UNIX domain socket.
+     * Requests arriving concurrently are queued and coalesced into batches solved by a pool of workers, each owning
+     * a copy of the model as its workspace. Inverse kinematics requests in a batch between the same links are solved
+     * together in lockstep with inverse_kinematics_levenberg_marquardt_batch.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    class Service {
+    public:
+        using Clock         = std::chrono::steady_clock;
+        using Configuration = Eigen::Matrix<Scalar, nq, 1>;
+
+        /**
+         * @brief Constructs a service for a model.
+         * @param model tinyrobotics model served.
+         * @param options Service options.
+         */
+        Service(const Model<Scalar, nq>& model, const ServiceOptions<Scalar, nq>& options = {})
+            : model(model), options(options) {
+            this->options.ik_options.method = InverseKinematicsMethod::LEVENBERG_MARQUARDT;
+            this->options.n_workers         = std::max(1, options.n_workers);
+            this->options.max_batch_size    = std::max(1, options.max_batch_size);
+        }
+
+        ~Service() {
+            stop();
+        }
+
+        Service(const Service&)            = delete;
+        Service& operator=(const Service&) = delete;
+
+        /**
+         * @brief Starts listening on a UNIX domain socket and starts the worker threads.
+         * @param socket_path Path of the socket, any existing file at the path is replaced.
+         * @throws std::runtime_error if the socket cannot be created.
+         */
+        void start(const std::string& socket_path) {
+            if (running) {
+                throw std::runtime_error("Error! Service is already running.");
+            }
+            const sockaddr_un address = unix_socket_address(socket_path);
+            listen_fd                 = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listen_fd < 0) {
+                throw std::runtime_error("Error! Could not create socket: " + std::string(std::strerror(errno)));
+            }
+            ::unlink(socket_path.c_str());
+            if (::bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+                || ::listen(listen_fd, SOMAXCONN) != 0) {
+                const std::string error = std::strerror(errno);
+                ::close(listen_fd);
+                throw std::runtime_error("Error! Could not listen on [" + socket_path + "]: " + error);
+            }
+            path     = socket_path;
+            running  = true;
+            stopping = false;
+            for (int i = 0; i < options.n_workers; ++i) {
+                workers.emplace_back(&Service::work, this);
+            }
+            acceptor = std::thread(&Service::accept_connections, this);
+        }
+
+        /**
+         * @brief Stops the service, closing all connections and joining all threads.
+         */
+        void stop() {
+            if (!running) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                stopping = true;
+            }
+            queue_condition.notify_all();
+            ::shutdown(listen_fd, SHUT_RDWR);
+            ::close(listen_fd);
+            acceptor.join();
+            {
+                std::lock_guard<std::mutex> lock(connections_mutex);
+                for (const int fd : connection_fds) {
+                    ::shutdown(fd, SHUT_RDWR);
+                }
+            }
+            for (auto& connection : connections) {
+                connection.join();
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            connections.clear();
+            workers.clear();
+            ::unlink(path.c_str());
+            running = false;
+        }
+
+        /**
+         * @brief Get the statistics of the service.
+         * @return The statistics.
+         */
+        ServiceStatistics statistics() const {
+            std::lock_guard<std::mutex> lock(statistics_mutex);
+            return stats;
+        }
+
+    private:
+        /// @brief A queued request and its response.
+        struct Job {
+            ServiceMessageHeader header;
+            std::vector<double> payload;
+            ServiceMessageHeader response_header;
+            std::vector<double> response;
+            std::string error;
+            Clock::time_point enqueued;
+            std::promise<void> done;
+        };
+
+        /// @brief Accepts connections until the service is stopped, serving each on its own thread.
+        void accept_connections() {
+            while (true) {
+                const int fd = ::accept(listen_fd, nullptr, nullptr);
+                if (fd < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(connections_mutex);
+                if (stopping) {
+                    ::close(fd);
+                    return;
+                }
+                connection_fds.push_back(fd);
+                connections.emplace_back(&Service::serve, this, fd);
+            }
+        }
+
+        /**
+         * @brief Serves requests on a connection until it is closed.
+         * @param fd Socket file descriptor of the connection.
+         */
+        void serve(const int fd) {
+            ServiceMessageHeader header;
+            while (read_exact(fd, &header, sizeof(header)) && header.magic == TR_SERVICE_MAGIC) {
+                auto job    = std::make_shared<Job>();
+                job->header = header;
+                job->payload.resize(header.n_values);
+                if (!read_exact(fd, job->payload.data(), header.n_values * sizeof(double))) {
+                    break;
+                }
+                job->response_header          = header;
+                job->response_header.n_values = 0;
+
+                // Requests which do not need the model are answered directly, the rest are batched
+                if (header.type == ServiceRequestType::INFO) {
+                    job->response = {double(nq), double(model.links.size())};
+                }
+                else if (header.type == ServiceRequestType::STATISTICS) {
+                    job->response = statistics().serialize();
+                }
+                else if (header.type < ServiceRequestType::INVERSE_KINEMATICS
+                         || header.type > ServiceRequestType::GRAVITY_TORQUE) {
+                    job->error = "Error! Unknown request type.";
+                }
+                else {
+                    std::future<void> done = job->done.get_future();
+                    job->enqueued          = Clock::now();
+                    {
+                        std::lock_guard<std::mutex> lock(queue_mutex);
+                        if (stopping) {
+                            break;
+                        }
+                        queue.push_back(job);
+                    }
+                    queue_condition.notify_one();
+                    done.wait();
+                }
+
+                // Send the response, or the error message
+                bool sent = false;
+                if (job->error.empty()) {
+                    job->response_header.n_values = job->response.size();
+                    sent = write_exact(fd, &job->response_header, sizeof(ServiceMessageHeader))
+                           && write_exact(fd, job->response.data(), job->response.size() * sizeof(double));
+                }
+                else {
+                    job->response_header.status   = -1;
+                    job->response_header.n_values = job->error.size();
+                    sent = write_exact(fd, &job->response_header, sizeof(ServiceMessageHeader))
+                           && write_exact(fd, job->error.data(), job->error.size());
+                }
+                if (!sent) {
+                    break;
+                }
+            }
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            connection_fds.erase(std::find(connection_fds.begin(), connection_fds.end(), fd));
+            ::close(fd);
+        }
+
+        /// @brief Takes batches of requests from the queue and solves them until the service is stopped.
+        void work() {
+            // Each worker owns a copy of the model as it holds the pre-allocated workspace
+            Model<Scalar, nq> workspace = model;
+            std::vector<std::shared_ptr<Job>> batch;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_condition.wait(lock, [&] { return stopping || !queue.empty(); });
+                    if (stopping && queue.empty()) {
+                        return;
+                    }
+                    // Wait a short time for concurrent requests to fill the batch
+                    const Clock::time_point deadline = queue.front()->enqueued + options.batch_window;
+                    queue_condition.wait_until(lock, deadline, [&] {
+                        return stopping || int(queue.size()) >= options.max_batch_size;
+                    });
+                    const int n = std::min<int>(queue.size(), options.max_batch_size);
+                    batch.assign(queue.begin(), queue.begin() + n);
+                    queue.erase(queue.begin(), queue.begin() + n);
+                }
+                solve(workspace, batch);
+            }
+        }
+
+        /**
+         * @brief Solves a batch of requests and records their latencies.
+         * @param workspace Model owned by the worker.
+         * @param batch Requests to solve.
+         */
+        void solve(Model<Scalar, nq>& workspace, std::vector<std::shared_ptr<Job>>& batch) {
+            const Clock::time_point start = Clock::now();
+
+            // Group inverse kinematics requests between the same links so they are solved in lockstep
+            std::map<std::pair<int, int>, std::vector<std::shared_ptr<Job>>> ik_groups;
+            for (auto& job : batch) {
+                try {
+                    check_payload(*job);
+                    if (job->header.type == ServiceRequestType::INVERSE_KINEMATICS) {
+                        ik_groups[{job->header.target_link, job->header.source_link}].push_back(job);
+                    }
+                    else {
+                        solve_dynamics(workspace, *job);
+                    }
+                }
+                catch (const std::exception& e) {
+                    job->error = e.what();
+                }
+            }
+            for (auto& group : ik_groups) {
+                solve_inverse_kinematics(group.second);
+            }
+
+            // Record the latencies before the responses are released
+            const Clock::time_point end = Clock::now();
+            const double solve_us       = std::chrono::duration<double, std::micro>(end - start).count();
+            {
+                std::lock_guard<std::mutex> lock(statistics_mutex);
+                for (auto& job : batch) {
+                    const double queue_us = std::chrono::duration<double, std::micro>(start - job->enqueued).count();
+                    stats[job->header.type].add(queue_us, solve_us);
+                }
+                stats.n_batches++;
+                stats.mean_batch_size += (batch.size() - stats.mean_batch_size) / stats.n_batches;
+            }
+            for (auto& job : batch) {
+                job->done.set_value();
+            }
+        }
+
+        /**
+         * @brief Checks the type, payload size and links of a request.
+         * @param job The request.
+         * @throws std::invalid_argument if the request is malformed.
+         */
+        void check_payload(const Job& job) const {
+            size_t expected = 0;
+            switch (job.header.type) {
+                case ServiceRequestType::INVERSE_KINEMATICS: {
+                    expected     = 16 + nq;
+                    const int nl = model.links.size();
+                    if (job.header.target_link < 0 || job.header.target_link >= nl || job.header.source_link < 0
+                        || job.header.source_link >= nl) {
+                        throw std::invalid_argument("Error! Link index out of range.");
+                    }
+                    break;
+                }
+                case ServiceRequestType::FORWARD_DYNAMICS:
+                case ServiceRequestType::INVERSE_DYNAMICS: expected = 3 * nq; break;
+                case ServiceRequestType::MASS_MATRIX:
+                case ServiceRequestType::GRAVITY_TORQUE: expected = nq; break;
+                default: throw std::invalid_argument("Error! Unknown request type.");
+            }
+            if (job.payload.size() != expected) {
+                throw std::invalid_argument("Error! Expected " + std::to_string(expected) + " values but received "
+                                            + std::to_string(job.payload.size()) + ".");
+            }
+        }
+
+        /**
+         * @brief Get a configuration vector from a payload.
+         * @param job The request.
+         * @param offset Index of the first value.
+         * @return The configuration vector.
+         */
+        static Configuration configuration(const Job& job, const int offset) {
+            return Eigen::Map<const Eigen::Matrix<double, nq, 1>>(job.payload.data() + offset).template cast<Scalar>();
+        }
+
+        /**
+         * @brief Solves a dynamics request.
+         * @param workspace Model owned by the worker.
+         * @param job The request.
+         */
+        void solve_dynamics(Model<Scalar, nq>& workspace, Job& job) const {
+            Eigen::Matrix<Scalar, Eigen::Dynamic, 1> result;
+            switch (job.header.type) {
+                case ServiceRequestType::FORWARD_DYNAMICS:
+                    result = forward_dynamics(workspace,
+                                              configuration(job, 0),
+                                              configuration(job, nq),
+                                              configuration(job, 2 * nq));
+                    break;
+                case ServiceRequestType::INVERSE_DYNAMICS:
+                    result = inverse_dynamics(workspace,
+                                              configuration(job, 0),
+                                              configuration(job, nq),
+                                              configuration(job, 2 * nq));
+                    break;
+                case ServiceRequestType::MASS_MATRIX: {
+                    const Eigen::Matrix<Scalar, nq, nq> M = mass_matrix(workspace, configuration(job, 0));
+                    result = Eigen::Map<const Eigen::Matrix<Scalar, nq * nq, 1>>(M.data());
+                    break;
+                }
+                case ServiceRequestType::GRAVITY_TORQUE: result = gravity_torque(workspace, configuration(job, 0)); break;
+                default: break;
+            }
+            job.response.resize(result.size());
+            Eigen::Map<Eigen::VectorXd>(job.response.data(), result.size()) = result.template cast<double>();
+        }
+
+        /**
+         * @brief Solves inverse kinematics requests between the same links in lockstep.
+         * @param jobs The requests.
+         */
+        void solve_inverse_kinematics(std::vector<std::shared_ptr<Job>>& jobs) const {
+            std::vector<Eigen::Transform<Scalar, 3, Eigen::Isometry>> poses;
+            std::vector<Configuration> q0;
+            for (const auto& job : jobs) {
+                Eigen::Transform<Scalar, 3, Eigen::Isometry> pose;
+                pose.matrix() =
+                    Eigen::Map<const Eigen::Matrix<double, 4, 4, Eigen::RowMajor>>(job->payload.data()).template cast<Scalar>();
+                poses.push_back(pose);
+                q0.push_back(configuration(*job, 16));
+            }
+            try {
+                const auto q = inverse_kinematics_levenberg_marquardt_batch<Scalar, nq>(
+                    model,
+                    model.links[jobs.front()->header.target_link].name,
+                    model.links[jobs.front()->header.source_link].name,
+                    poses,
+                    q0,
+                    options.ik_options);
+                for (size_t i = 0; i < jobs.size(); ++i) {
+                    jobs[i]->response.resize(nq);
+                    Eigen::Map<Eigen::Matrix<double, nq, 1>>(jobs[i]->response.data()) = q[i].template cast<double>();
+                }
+            }
+            catch (const std::exception& e) {
+                for (auto& job : jobs) {
+                    job->error = e.what();
+                }
+            }
+        }
+
+        /// @brief Model served, shared read-only by the inverse kinematics solver.
+        const Model<Scalar, nq> model;
+
+        /// @brief Service options.
+        ServiceOptions<Scalar, nq> options;
+
+        /// @brief Path of the socket.
+        std::string path;
+
+        /// @brief Listening socket file descriptor.
+        int listen_fd = -1;
+
+        /// @brief Whether the service has been started and not yet stopped.
+        bool running = false;
+
+        /// @brief Whether the service is stopping, guarded by queue_mutex.
+        bool stopping = false;
+
+        /// @brief Queue of requests waiting for a worker.
+        std::deque<std::shared_ptr<Job>> queue;
+        std::mutex queue_mutex;
+        std::condition_variable queue_condition;
+
+        /// @brief Threads accepting connections, serving connections and solving batches.
+        std::thread acceptor;
+        std::vector<std::thread> connections;
+        std::vector<int> connection_fds;
+        std::mutex connections_mutex;
+        std::vector<std::thread> workers;
+
+        /// @brief Statistics of the service.
+        ServiceStatistics stats;
+        mutable std::mutex statistics_mutex;
+    };
+
+    /**
+     * @brief Client of a local tinyrobotics service. Each client holds one connection and sends one request at a
+     * time, so concurrent callers should each use their own client.
+     */
+    class ServiceClient {
+    public:
+        /**
+         * @brief Connects to a service.
+         * @param socket_path Path of the socket of the service.
+         * @throws std::runtime_error if the connection fails.
+         */
+        explicit ServiceClient(const std::string& socket_path) {
+            const sockaddr_un address = unix_socket_address(socket_path);
+            fd                        = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                const std::string error = std::strerror(errno);
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+                throw std::runtime_error("Error! Could not connect to [" + socket_path + "]: " + error);
+            }
+            const std::vector<double> info = request(ServiceRequestType::INFO, {});
+            n_q                            = info[0];
+            n_links                        = info[1];
+        }
+
+        ~ServiceClient() {
+            ::close(fd);
+        }
+
+        ServiceClient(const ServiceClient&)            = delete;
+        ServiceClient& operator=(const ServiceClient&) = delete;
+
+        /// @brief Number of configuration coordinates of the served model.
+        int n_q = 0;
+
+        /// @brief Number of links of the served model.
+        int n_links = 0;
+
+        /**
+         * @brief Sends a request and waits for the response.
+         * @param type Type of the request.
+         * @param payload Values of the request.
+         * @param target_link Index of the target link, for inverse kinematics.
+         * @param source_link Index of the source link, for inverse kinematics.
+         * @return Values of the response.
+         * @throws std::runtime_error if the connection fails or the service reports an error.
+         */
+        std::vector<double> request(const ServiceRequestType type,
+                                    const std::vector<double>& payload,
+                                    const int target_link = -1,
+                                    const int source_link = -1) {
+            ServiceMessageHeader header;
+            header.type        = type;
+            header.target_link = target_link;
+            header.source_link = source_link;
+            header.n_values    = payload.size();
+            if (!write_exact(fd, &header, sizeof(header))
+                || !write_exact(fd, payload.data(), payload.size() * sizeof(double))
+                || !read_exact(fd, &header, sizeof(header)) || header.magic != TR_SERVICE_MAGIC) {
+                throw std::runtime_error("Error! Connection to the service failed.");
+            }
+            if (header.status != 0) {
+                std::string error(header.n_values, '\0');
+                read_exact(fd, &error[0], error.size());
+                throw std::runtime_error(error);
+            }
+            std::vector<double> response(header.n_values);
+            if (!read_exact(fd, response.data(), response.size() * sizeof(double))) {
+                throw std::runtime_error("Error! Connection to the service failed.");
+            }
+            return response;
+        }
+
+        /**
+         * @brief Solves inverse kinematics on the service with the Levenberg-Marquardt method.
+         * @param target_link Index of the target link.
+         * @param source_link Index of the source link, an ancestor of the target link.
+         * @param desired_pose Desired pose of the target link in the source link frame.
+         * @param q0 Initial guess for the configuration vector.
+         * @return The configuration vector which achieves the desired pose.
+         */
+        Eigen::VectorXd inverse_kinematics(const int target_link,
+                                           const int source_link,
+                                           const Eigen::Isometry3d& desired_pose,
+                                           const Eigen::VectorXd& q0) {
+            std::vector<double> payload(16 + q0.size());
+            Eigen::Map<Eigen::Matrix<double, 4, 4, Eigen::RowMajor>>(payload.data()) = desired_pose.matrix();
+            Eigen::Map<Eigen::VectorXd>(payload.data() + 16, q0.size())          = q0;
+            return to_vector(request(ServiceRequestType::INVERSE_KINEMATICS, payload, target_link, source_link));
+        }
+
+        /// @brief Computes the forward dynamics on the service, see forward_dynamics.
+        Eigen::VectorXd forward_dynamics(const Eigen::VectorXd& q, const Eigen::VectorXd& dq, const Eigen::VectorXd& tau) {
+            return to_vector(request(ServiceRequestType::FORWARD_DYNAMICS, concatenate({&q, &dq, &tau})));
+        }
+
+        /// @brief Computes the inverse dynamics on the service, see inverse_dynamics.
+        Eigen::VectorXd inverse_dynamics(const Eigen::VectorXd& q, const Eigen::VectorXd& dq, const Eigen::VectorXd& ddq) {
+            return to_vector(request(ServiceRequestType::INVERSE_DYNAMICS, concatenate({&q, &dq, &ddq})));
+        }
+
+        /// @brief Computes the mass matrix on the service, see mass_matrix.
+        Eigen::MatrixXd mass_matrix(const Eigen::VectorXd& q) {
+            const std::vector<double> M = request(ServiceRequestType::MASS_MATRIX, concatenate({&q}));
+            return Eigen::Map<const Eigen::MatrixXd>(M.data(), n_q, n_q);
+        }
+
+        /// @brief Computes the gravity torque on the service, see gravity_torque.
+        Eigen::VectorXd gravity_torque(const Eigen::VectorXd& q) {
+            return to_vector(request(ServiceRequestType::GRAVITY_TORQUE, concatenate({&q})));
+        }
+
+        /// @brief Get the queueing and solve latency statistics of the service.
+        ServiceStatistics statistics() {
+            return ServiceStatistics::deserialize(request(ServiceRequestType::STATISTICS, {}));
+        }
+
+    private:
+        /// @brief Converts response values to a vector.
+        static Eigen::VectorXd to_vector(const std::vector<double>& values) {
+            return Eigen::Map<const Eigen::VectorXd>(values.data(), values.size());
+        }
+
+        /// @brief Concatenates vectors into request values.
+        static std::vector<double> concatenate(std::initializer_list<const Eigen::VectorXd*> vectors) {
+            std::vector<double> values;
+            for (const Eigen::VectorXd* v : vectors) {
+                values.insert(values.end(), v->data(), v->data() + v->size());
+            }
+            return values;
+        }
+
+        /// @brief Socket file descriptor of the connection.
+        int fd = -1;
+    };
+
+}  // namespace tinyrobotics
+
+#endif
@@ -0,0 +1,307 @@
+#ifndef TR_SPLINE_HPP
+#define TR_SPLINE_HPP
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dynamics.hpp"
+#include "model.hpp"
+#include "parallel.hpp"
+
+/** \file spline.hpp
+ * @brief Contains a joint space B-spline trajectory and batched feedforward inverse dynamics along it.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Joint space B-spline trajectory stored as a knot vector and one column of control points per basis
+     * function. Quintic trajectories through waypoints are stored as B-splines too, one Bezier segment per pair of
+     * waypoints. Outside the knot range the trajectory holds its end points at rest.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    class JointSpline {
+    public:
+        /// @brief Largest supported degree.
+        static constexpr int max_degree = 7;
+
+        /// @brief Control point matrix type, one column per control point.
+        using ControlPoints = Eigen::Matrix<Scalar, nq, Eigen::Dynamic>;
+
+        /// @brief Sampled trajectory matrix type, one column per sample.
+        using Samples = Eigen::Matrix<Scalar, nq, Eigen::Dynamic>;
+
+        JointSpline() = default;
+
+        /**
+         * @brief Constructs a B-spline from its degree, knot vector and control points.
+         * @param degree Degree of the spline.
+         * @param knots Non-decreasing knot vector with n_control_points + degree + 1 knots [s].
+         * @param control_points Control points, one column per control point.
+         * @throws std::invalid_argument if the degree, knots and control points are inconsistent.
+         */
+        JointSpline(const int degree, const std::vector<Scalar>& knots, const ControlPoints& control_points)
+            : p(degree), knots(knots), control_points(control_points) {
+            if (p < 1 || p > max_degree) {
+                throw std::invalid_argument("Error! Spline degree must be within [1, "
+                                            + std::to_string(max_degree) + "].");
+            }
+            if (control_points.cols() < p + 1 || int(knots.size()) != control_points.cols() + p + 1) {
+                throw std::invalid_argument("Error! Spline needs degree + 1 control points and n_control_points + "
+                                            "degree + 1 knots.");
+            }
+            if (!std::is_sorted(knots.begin(), knots.end()) || knots[p] >= knots[control_points.cols()]) {
+                throw std::invalid_argument("Error! Spline knots must be non-decreasing with a non-empty range.");
+            }
+        }
+
+        /**
+         * @brief Constructs a piecewise quintic trajectory through waypoints with given velocities and accelerations.
+         * Each segment is a quintic Bezier curve, so the trajectory is twice continuously differentiable.
+         * @param times Time of each waypoint, strictly increasing [s].
+         * @param q Joint configuration at each waypoint, one column per waypoint.
+         * @param dq Joint velocity at each waypoint, one column per waypoint.
+         * @param ddq Joint acceleration at each waypoint, one column per waypoint.
+         * @throws std::invalid_argument if there are fewer than two waypoints or the sizes do not match.
+         */
+        static JointSpline quintic(const std::vector<Scalar>& times,
+                                   const Samples& q,
+                                   const Samples& dq,
+                                   const Samples& ddq) {
+            const int n = times.size();
+            if (n < 2 || q.cols() != n || dq.cols() != n || ddq.cols() != n) {
+                throw std::invalid_argument("Error! Quintic spline needs at least two waypoints with a configuration, "
+                                            "velocity and acceleration each.");
+            }
+            // Interior knots have multiplicity five, so each segment is an independent Bezier curve
+            std::vector<Scalar> knots(6, times.front());
+            ControlPoints points(nq, 5 * (n - 1) + 1);
+            for (int s = 0; s < n - 1; ++s) {
+                const Scalar T = times[s + 1] - times[s];
+                if (T <= 0) {
+                    throw std::invalid_argument("Error! Quintic spline waypoint times must be strictly increasing.");
+                }
+                points.col(5 * s)     = q.col(s);
+                points.col(5 * s + 1) = q.col(s) + T / 5 * dq.col(s);
+                points.col(5 * s + 2) = q.col(s) + 2 * T / 5 * dq.col(s) + T * T / 20 * ddq.col(s);
+                points.col(5 * s + 3) = q.col(s + 1) - 2 * T / 5 * dq.col(s + 1) + T * T / 20 * ddq.col(s + 1);
+                points.col(5 * s + 4) = q.col(s + 1) - T / 5 * dq.col(s + 1);
+                knots.insert(knots.end(), s + 1 < n - 1 ? 5 : 6, times[s + 1]);
+            }
+            points.col(5 * (n - 1)) = q.col(n - 1);
+            return JointSpline(5, knots, points);
+        }
+
+        /**
+         * @brief Evaluates the trajectory at a time.
+         * @param t Time [s].
+         * @param q Joint configuration.
+         * @param dq Joint velocity.
+         * @param ddq Joint acceleration.
+         */
+        void evaluate(const Scalar t,
+                      Eigen::Matrix<Scalar, nq, 1>& q,
+                      Eigen::Matrix<Scalar, nq, 1>& dq,
+                      Eigen::Matrix<Scalar, nq, 1>& ddq) const {
+            Eigen::Matrix<Scalar, 3, max_degree + 1> basis;
+            const int first = basis_functions(t, basis);
+            // Every joint is a combination of the same p + 1 control point columns
+            const auto points = control_points.middleCols(first, p + 1);
+            q                 = points * basis.row(0).head(p + 1).transpose();
+            dq                = points * basis.row(1).head(p + 1).transpose();
+            ddq               = points * basis.row(2).head(p + 1).transpose();
+        }
+
+        /**
+         * @brief Evaluates the trajectory at many times. The basis functions of all times are computed first, then
+         * each run of consecutive times within the same knot span is evaluated as one matrix product of the span's
+         * control points and basis functions, so sorted times are evaluated in vectorised blocks.
+         * @param times Times to evaluate at [s].
+         * @param q Joint configuration at each time, one column per time.
+         * @param dq Joint velocity at each time, one column per time.
+         * @param ddq Joint acceleration at each time, one column per time.
+         */
+        void evaluate(const std::vector<Scalar>& times, Samples& q, Samples& dq, Samples& ddq) const {
+            const int n_times = times.size();
+            q.resize(nq, n_times);
+            dq.resize(nq, n_times);
+            ddq.resize(nq, n_times);
+            Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> basis[3];
+            for (auto& b : basis) {
+                b.resize(p + 1, n_times);
+            }
+            std::vector<int> first(n_times);
+            Eigen::Matrix<Scalar, 3, max_degree + 1> ders;
+            for (int i = 0; i < n_times; ++i) {
+                first[i] = basis_functions(times[i], ders);
+                for (int k = 0; k < 3; ++k) {
+                    basis[k].col(i) = ders.row(k).head(p + 1).transpose();
+                }
+            }
+            for (int begin = 0, end = 0; begin < n_times; begin = end) {
+                while (end < n_times && first[end] == first[begin]) {
+                    ++end;
+                }
+                const auto points = control_points.middleCols(first[begin], p + 1);
+                q.middleCols(begin, end - begin).noalias()   = points * basis[0].middleCols(begin, end - begin);
+                dq.middleCols(begin, end - begin).noalias()  = points * basis[1].middleCols(begin, end - begin);
+                ddq.middleCols(begin, end - begin).noalias() = points * basis[2].middleCols(begin, end - begin);
+            }
+        }
+
+        /// @brief Get the degree of the spline.
+        int degree() const {
+            return p;
+        }
+
+        /// @brief Get the knot vector.
+        const std::vector<Scalar>& knot_vector() const {
+            return knots;
+        }
+
+        /// @brief Get the control points.
+        const ControlPoints& points() const {
+            return control_points;
+        }
+
+        /// @brief Get the start time of the trajectory [s].
+        Scalar start_time() const {
+            return knots[p];
+        }
+
+        /// @brief Get the end time of the trajectory [s].
+        Scalar end_time() const {
+            return knots[control_points.cols()];
+        }
+
+    private:
+        /**
+         * @brief Computes the nonzero basis functions and their first two derivatives at a time, with the algorithm
+         * of Piegl and Tiller (The NURBS Book, A2.3).
+         * @param t Time [s].
+         * @param ders Basis functions (row 0), first (row 1) and second (row 2) derivatives.
+         * @return Index of the control point of the first nonzero basis function.
+         */
+        int basis_functions(Scalar t, Eigen::Matrix<Scalar, 3, max_degree + 1>& ders) const {
+            const int n = control_points.cols();
+            ders.setZero();
+
+            // Hold the end points at rest outside the knot range
+            if (t < knots[p] || t > knots[n]) {
+                ders(0, t < knots[p] ? 0 : p) = 1;
+                return t < knots[p] ? 0 : n - p - 1;
+            }
+
+            // Knot span with knots[span] <= t < knots[span + 1], or the last span at the end time
+            const int span =
+                std::min<int>(std::upper_bound(knots.begin() + p, knots.begin() + n + 1, t) - knots.begin() - 1, n - 1);
+
+            Scalar ndu[max_degree + 1][max_degree + 1];
+            Scalar left[max_degree + 1], right[max_degree + 1];
+            ndu[0][0] = 1;
+            for (int j = 1; j <= p; ++j) {
+                left[j]      = t - knots[span + 1 - j];
+                right[j]     = knots[span + j] - t;
+                Scalar saved = 0;
+                for (int r = 0; r < j; ++r) {
+                    ndu[j][r]         = right[r + 1] + left[j - r];
+                    const Scalar temp = ndu[r][j - 1] / ndu[j][r];
+                    ndu[r][j]         = saved + right[r + 1] * temp;
+                    saved             = left[j - r] * temp;
+                }
+                ndu[j][j] = saved;
+            }
+            for (int j = 0; j <= p; ++j) {
+                ders(0, j) = ndu[j][p];
+            }
+
+            // Derivatives from the differences of the lower degree basis functions
+            const int n_ders = std::min(2, p);
+            Scalar a[2][max_degree + 1];
+            for (int r = 0; r <= p; ++r) {
+                int s1 = 0, s2 = 1;
+                a[0][0] = 1;
+                for (int k = 1; k <= n_ders; ++k) {
+                    Scalar d     = 0;
+                    const int rk = r - k, pk = p - k;
+                    if (r >= k) {
+                        a[s2][0] = a[s1][0] / ndu[pk + 1][rk];
+                        d        = a[s2][0] * ndu[rk][pk];
+                    }
+                    const int j1 = rk >= -1 ? 1 : -rk;
+                    const int j2 = r - 1 <= pk ? k - 1 : p - r;
+                    for (int j = j1; j <= j2; ++j) {
+                        a[s2][j] = (a[s1][j] - a[s1][j - 1]) / ndu[pk + 1][rk + j];
+                        d += a[s2][j] * ndu[rk + j][pk];
+                    }
+                    if (r <= pk) {
+                        a[s2][k] = -a[s1][k - 1] / ndu[pk + 1][r];
+                        d += a[s2][k] * ndu[r][pk];
+                    }
+                    ders(k, r) = d;
+                    std::swap(s1, s2);
+                }
+            }
+            Scalar factor = p;
+            for (int k = 1; k <= n_ders; ++k) {
+                ders.row(k) *= factor;
+                factor *= p - k;
+            }
+            return span - p;
+        }
+
+        /// @brief Degree of the spline.
+        int p = 1;
+
+        /// @brief Knot vector.
+        std::vector<Scalar> knots;
+
+        /// @brief Control points, one column per control point.
+        ControlPoints control_points;
+    };
+
+    /**
+     * @brief Computes the feedforward joint torques along a spline trajectory. The spline is evaluated at all sample
+     * times in one batch, then inverse dynamics runs at every sample with the samples split into chunks across threads.
+     * @param model tinyrobotics model.
+     * @param spline Joint space trajectory.
+     * @param times Sample times [s].
+     * @param n_threads Number of threads to use, the default thread count if zero or less.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @return Joint torques, one column per sample time.
+     */
+    template <typename Scalar, int nq>
+    Eigen::Matrix<Scalar, nq, Eigen::Dynamic> feedforward_torques(const Model<Scalar, nq>& model,
+                                                                  const JointSpline<Scalar, nq>& spline,
+                                                                  const std::vector<Scalar>& times,
+                                                                  const int n_threads = 0) {
+        const int n_samples = times.size();
+        Eigen::Matrix<Scalar, nq, Eigen::Dynamic> q, dq, ddq;
+        spline.evaluate(times, q, dq, ddq);
+        Eigen::Matrix<Scalar, nq, Eigen::Dynamic> tau(nq, n_samples);
+
+        // Each thread needs its own model as it holds the pre-allocated workspace
+        const int threads = std::max(1, std::min(n_threads > 0 ? n_threads : default_thread_count(), n_samples));
+        std::vector<Model<Scalar, nq>> workspaces(threads, model);
+        parallel_for(
+            n_samples,
+            [&](const int begin, const int end, const int thread_idx) {
+                for (int i = begin; i < end; ++i) {
+                    tau.col(i) = inverse_dynamics(workspaces[thread_idx],
+                                                  Eigen::Matrix<Scalar, nq, 1>(q.col(i)),
+                                                  Eigen::Matrix<Scalar, nq, 1>(dq.col(i)),
+                                                  Eigen::Matrix<Scalar, nq, 1>(ddq.col(i)));
+                }
+            },
+            threads);
+        return tau;
+    }
+
+}  // namespace tinyrobotics
+
+#endif
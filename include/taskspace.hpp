@@ -0,0 +1,205 @@
+#ifndef TR_TASKSPACE_HPP
+#define TR_TASKSPACE_HPP
+
+#include <Eigen/Core>
+#include <Eigen/Dense>
+#include <vector>
+
+#include "dynamics.hpp"
+#include "model.hpp"
+
+/** \file taskspace.hpp
+ * @brief Contains dynamically consistent pseudo-inverses and nullspace projectors of stacked tasks for task space
+ * control of a tinyrobotics model.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Options for the task projector.
+     * @tparam Scalar type of the tinyrobotics model.
+     */
+    template <typename Scalar>
+    struct TaskProjectorOptions {
+        /// @brief Eigenvalues of the inverse task space inertia below this fraction of the largest one are treated as
+        /// zero, so that tasks which are singular or fully constrained by higher priority tasks stay finite. Tasks
+        /// whose Cholesky pivots all exceed it are inverted directly, without an eigendecomposition.
+        Scalar singular_threshold = 1e-9;
+    };
+
+    /**
+     * @brief A task of a stack of prioritized tasks, with up to six rows. The jacobian is set by the caller, all other
+     * members are written by TaskProjector::project. Every member has a fixed maximum size, so projecting does not
+     * allocate.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    struct Task {
+        /// @brief Jacobian of the task J_k.
+        Eigen::Matrix<Scalar, Eigen::Dynamic, nq, 0, 6, nq> jacobian;
+
+        /// @brief Jacobian projected into the nullspace of the higher priority tasks, J_k|p = J_k N_p.
+        Eigen::Matrix<Scalar, Eigen::Dynamic, nq, 0, 6, nq> projected_jacobian;
+
+        /// @brief Dynamically consistent pseudo-inverse of the projected jacobian, M^-1 J_k|p^T Lambda_k.
+        Eigen::Matrix<Scalar, nq, Eigen::Dynamic, 0, nq, 6> inverse;
+
+        /// @brief Task space inertia of the projected jacobian, Lambda_k = (J_k|p M^-1 J_k|p^T)^-1.
+        Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6> inertia;
+
+        /// @brief Nullspace projector of this task and all higher priority tasks, N_k = N_p - inverse J_k|p.
+        Eigen::Matrix<Scalar, nq, nq> nullspace;
+
+        /// @brief Constructs an empty task.
+        Task() = default;
+
+        /**
+         * @brief Constructs a task from its jacobian.
+         * @param jacobian Jacobian of the task, with at most six rows.
+         */
+        template <typename Derived>
+        Task(const Eigen::MatrixBase<Derived>& jacobian) : jacobian(jacobian) {}
+    };
+
+    /**
+     * @brief Computes the dynamically consistent (inertia weighted) pseudo-inverses and nullspace projectors of a stack
+     * of prioritized tasks. The mass matrix is factored once per configuration and the factorization is shared by every
+     * task, so each task costs O(nq^2) for its M^-1 J^T solve and nullspace update instead of O(nq^3) for an inverse
+     * of M and a product of projectors.
+     *
+     * Tasks are processed in order of decreasing priority. Task k is projected into the nullspace of all higher
+     * priority tasks, J_k|p = J_k N_p, and its nullspace projector is updated in place as N_k = N_p - Jbar_k|p J_k|p,
+     * which equals N_p (I - Jbar_k|p J_k|p) since N_p Jbar_k|p = Jbar_k|p. The torque tau = sum_k J_k|p^T F_k then
+     * realizes each task force without disturbing higher priority tasks.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    class TaskProjector {
+    public:
+        /**
+         * @brief Constructs a task projector with its own copy of the model.
+         * @param model tinyrobotics model.
+         * @param options Task projector options.
+         */
+        TaskProjector(const Model<Scalar, nq>& model,
+                      const TaskProjectorOptions<Scalar>& options = TaskProjectorOptions<Scalar>())
+            : model(model), options(options) {}
+
+        /**
+         * @brief Computes and factors the mass matrix at a new configuration.
+         * @param q Joint configuration of the robot.
+         */
+        void update(const Eigen::Matrix<Scalar, nq, 1>& q) {
+            llt.compute(mass_matrix(model, q));
+        }
+
+        /**
+         * @brief Factors a mass matrix computed by the caller.
+         * @param M Mass matrix of the robot.
+         */
+        void update_mass_matrix(const Eigen::Matrix<Scalar, nq, nq>& M) {
+            llt.compute(M);
+        }
+
+        /**
+         * @brief Computes the projected jacobian, dynamically consistent pseudo-inverse, task space inertia and
+         * nullspace projector of each task, given the jacobians of the tasks and the mass matrix of the last update.
+         * @param tasks Tasks in order of decreasing priority.
+         */
+        void project(std::vector<Task<Scalar, nq>>& tasks) {
+            for (size_t k = 0; k < tasks.size(); k++) {
+                project(tasks[k], k == 0 ? nullptr : &tasks[k - 1].nullspace);
+            }
+        }
+
+        /**
+         * @brief Computes the dynamically consistent pseudo-inverse, task space inertia and nullspace projector of a
+         * single task, given its jacobian and the mass matrix of the last update.
+         * @param task The task.
+         */
+        void project(Task<Scalar, nq>& task) {
+            project(task, nullptr);
+        }
+
+        /// @brief Get the Cholesky factorization of the mass matrix of the last update.
+        const Eigen::LLT<Eigen::Matrix<Scalar, nq, nq>>& factorization() const {
+            return llt;
+        }
+
+    private:
+        /**
+         * @brief Projects a task into the nullspace of the higher priority tasks.
+         * @param task The task.
+         * @param N Nullspace projector of the higher priority tasks, or nullptr for the highest priority task.
+         */
+        void project(Task<Scalar, nq>& task, const Eigen::Matrix<Scalar, nq, nq>* N) {
+            if (N == nullptr) {
+                task.projected_jacobian = task.jacobian;
+            }
+            else {
+                task.projected_jacobian.noalias() = task.jacobian * (*N);
+            }
+
+            // Inverse task space inertia J M^-1 J^T from a single solve against the shared factorization
+            MinvJT = llt.solve(task.projected_jacobian.transpose());
+            inverse_inertia.noalias() = task.projected_jacobian * MinvJT;
+
+            // Invert the inverse inertia by Cholesky, unless a pivot shows the task has lost a direction it can move in
+            inertia_llt.compute(inverse_inertia);
+            const auto pivots = inertia_llt.matrixLLT().diagonal().cwiseAbs2();
+            if (inertia_llt.info() == Eigen::Success
+                && pivots.minCoeff() > options.singular_threshold * pivots.maxCoeff()) {
+                task.inertia.setIdentity(inverse_inertia.rows(), inverse_inertia.cols());
+                inertia_llt.solveInPlace(task.inertia);
+            }
+            else {
+                // Pseudo-inverse dropping the directions the task can no longer move in
+                eigensolver.compute(inverse_inertia);
+                const Scalar threshold = options.singular_threshold * eigensolver.eigenvalues().cwiseAbs().maxCoeff();
+                eigenvalues            = eigensolver.eigenvalues();
+                for (int i = 0; i < eigenvalues.size(); i++) {
+                    eigenvalues(i) = eigenvalues(i) > threshold ? Scalar(1) / eigenvalues(i) : Scalar(0);
+                }
+                task.inertia.noalias() =
+                    eigensolver.eigenvectors() * eigenvalues.asDiagonal() * eigensolver.eigenvectors().transpose();
+            }
+
+            task.inverse.noalias() = MinvJT * task.inertia;
+            if (N == nullptr) {
+                task.nullspace.setIdentity();
+            }
+            else {
+                task.nullspace = *N;
+            }
+            task.nullspace.noalias() -= task.inverse * task.projected_jacobian;
+        }
+
+        /// @brief Model used as the workspace of the mass matrix computation.
+        Model<Scalar, nq> model;
+
+        /// @brief Task projector options.
+        TaskProjectorOptions<Scalar> options;
+
+        /// @brief Cholesky factorization of the mass matrix.
+        Eigen::LLT<Eigen::Matrix<Scalar, nq, nq>> llt;
+
+        /// @brief Workspace for M^-1 J^T of the current task.
+        Eigen::Matrix<Scalar, nq, Eigen::Dynamic, 0, nq, 6> MinvJT;
+
+        /// @brief Workspace for the inverse task space inertia of the current task.
+        Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6> inverse_inertia;
+
+        /// @brief Cholesky factorization of the inverse task space inertia.
+        Eigen::LLT<Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6>> inertia_llt;
+
+        /// @brief Workspace for the inverted eigenvalues of the inverse task space inertia.
+        Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, 6, 1> eigenvalues;
+
+        /// @brief Eigensolver of the inverse task space inertia.
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6>> eigensolver;
+    };
+
+}  // namespace tinyrobotics
+
+#endif
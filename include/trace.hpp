@@ -0,0 +1,221 @@
+#ifndef TR_TRACE_HPP
+#define TR_TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "capture.hpp"
+
+/** \file trace.hpp
+ * @brief Contains optional trace spans around the major phases of the algorithms, exported in the Chrome trace JSON
+ * format which can be opened in chrome://tracing or Perfetto. Spans are only recorded when TR_ENABLE_TRACING is
+ * defined, otherwise TR_TRACE_SPAN compiles to nothing.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief A completed span.
+     */
+    struct TraceEvent {
+        /// @brief Name of the span, a string literal.
+        const char* name = nullptr;
+
+        /// @brief Start of the span in nanoseconds, from capture_clock_ns.
+        int64_t start_ns = 0;
+
+        /// @brief Duration of the span in nanoseconds.
+        int64_t duration_ns = 0;
+    };
+
+    /**
+     * @brief Fixed capacity buffer of the spans completed on one thread. Only the owning thread writes to the buffer
+     * and publishes each event with a release store of the size, so recording takes no lock and the buffer can be
+     * exported while the thread is running. Spans completed once the buffer is full are counted and dropped.
+     */
+    class TraceBuffer {
+    public:
+        /// @brief Maximum number of spans kept per thread.
+        static constexpr size_t capacity = 1 << 16;
+
+        /**
+         * @brief Constructs an empty trace buffer.
+         * @param thread_id Identifier of the owning thread in the exported trace.
+         */
+        explicit TraceBuffer(const uint32_t thread_id) : thread_id(thread_id), events(new TraceEvent[capacity]) {}
+
+        /// @brief Identifier of the owning thread in the exported trace.
+        const uint32_t thread_id;
+
+        /**
+         * @brief Records a completed span, must only be called from the owning thread.
+         * @param name Name of the span, a string literal.
+         * @param start_ns Start of the span in nanoseconds.
+         * @param end_ns End of the span in nanoseconds.
+         */
+        void record(const char* name, const int64_t start_ns, const int64_t end_ns) {
+            const size_t n = n_events.load(std::memory_order_relaxed);
+            if (n >= capacity) {
+                n_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            events[n] = TraceEvent{name, start_ns, end_ns - start_ns};
+            n_events.store(n + 1, std::memory_order_release);
+        }
+
+        /// @brief Get the spans recorded so far, oldest first.
+        std::vector<TraceEvent> snapshot() const {
+            const size_t n = n_events.load(std::memory_order_acquire);
+            return std::vector<TraceEvent>(events.get(), events.get() + n);
+        }
+
+        /// @brief Get the number of spans dropped because the buffer was full.
+        size_t dropped() const {
+            return n_dropped.load(std::memory_order_relaxed);
+        }
+
+        /// @brief Removes all spans, must not race with the owning thread recording.
+        void clear() {
+            n_events.store(0, std::memory_order_release);
+            n_dropped.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        /// @brief Storage for the spans.
+        std::unique_ptr<TraceEvent[]> events;
+
+        /// @brief Number of spans published.
+        std::atomic<size_t> n_events{0};
+
+        /// @brief Number of spans dropped.
+        std::atomic<size_t> n_dropped{0};
+    };
+
+    /**
+     * @brief Registry of the trace buffers of every thread which has recorded a span. Buffers are kept after their
+     * thread exits so its spans can still be exported.
+     */
+    class TraceRegistry {
+    public:
+        /// @brief Get the process wide registry.
+        static TraceRegistry& instance() {
+            static TraceRegistry registry;
+            return registry;
+        }
+
+        /// @brief Get the trace buffer of the calling thread, registering it on first use.
+        TraceBuffer& thread_buffer() {
+            thread_local std::shared_ptr<TraceBuffer> buffer = register_thread();
+            return *buffer;
+        }
+
+        /// @brief Get the trace buffers of all registered threads.
+        std::vector<std::shared_ptr<TraceBuffer>> buffers() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return registered;
+        }
+
+        /// @brief Removes all spans, must not race with spans being recorded.
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& buffer : registered) {
+                buffer->clear();
+            }
+        }
+
+    private:
+        TraceRegistry() = default;
+
+        /// @brief Creates and registers the buffer of a new thread.
+        std::shared_ptr<TraceBuffer> register_thread() {
+            std::lock_guard<std::mutex> lock(mutex);
+            registered.push_back(std::make_shared<TraceBuffer>(uint32_t(registered.size())));
+            return registered.back();
+        }
+
+        /// @brief Buffers of the registered threads, indexed by thread identifier.
+        std::vector<std::shared_ptr<TraceBuffer>> registered;
+
+        /// @brief Guards registration.
+        mutable std::mutex mutex;
+    };
+
+    /**
+     * @brief Records a span from its construction to its destruction into the trace buffer of the calling thread.
+     */
+    class TraceSpan {
+    public:
+        /**
+         * @brief Starts a span.
+         * @param name Name of the span, a string literal.
+         */
+        explicit TraceSpan(const char* name) : name(name), start_ns(capture_clock_ns()) {}
+
+        ~TraceSpan() {
+            TraceRegistry::instance().thread_buffer().record(name, start_ns, capture_clock_ns());
+        }
+
+        TraceSpan(const TraceSpan&)            = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+    private:
+        /// @brief Name of the span.
+        const char* name;
+
+        /// @brief Start of the span in nanoseconds.
+        int64_t start_ns;
+    };
+
+    /**
+     * @brief Get the recorded spans of all threads in the Chrome trace JSON format, as complete ("X") events with
+     * timestamps and durations in microseconds.
+     * @return The trace as a JSON string.
+     */
+    inline std::string chrome_trace_json() {
+        std::ostringstream json;
+        json.precision(3);
+        json << std::fixed << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& buffer : TraceRegistry::instance().buffers()) {
+            for (const TraceEvent& event : buffer->snapshot()) {
+                json << (first ? "" : ",") << "\n{\"name\":\"" << event.name
+                     << "\",\"cat\":\"tinyrobotics\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                     << ",\"ts\":" << event.start_ns / 1e3 << ",\"dur\":" << event.duration_ns / 1e3 << "}";
+                first = false;
+            }
+        }
+        json << "\n]}\n";
+        return json.str();
+    }
+
+    /**
+     * @brief Writes the recorded spans of all threads to a Chrome trace JSON file.
+     * @param path Path of the file.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    inline void write_chrome_trace(const std::string& path) {
+        std::ofstream file(path);
+        if (!file || !(file << chrome_trace_json())) {
+            throw std::runtime_error("Error! Could not write trace to [" + path + "].");
+        }
+    }
+
+}  // namespace tinyrobotics
+
+#define TR_TRACE_CONCAT_IMPL(a, b) a##b
+#define TR_TRACE_CONCAT(a, b) TR_TRACE_CONCAT_IMPL(a, b)
+
+/// @brief Records a span named by a string literal until the end of the enclosing scope.
+#ifdef TR_ENABLE_TRACING
+#define TR_TRACE_SPAN(name) const ::tinyrobotics::TraceSpan TR_TRACE_CONCAT(tr_trace_span_, __LINE__)(name)
+#else
+#define TR_TRACE_SPAN(name) static_cast<void>(0)
+#endif
+
+#endif
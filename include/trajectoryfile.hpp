@@ -0,0 +1,514 @@
+#ifndef TR_TRAJECTORYFILE_HPP
+#define TR_TRAJECTORYFILE_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <Eigen/Core>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dynamics.hpp"
+#include "kinematics.hpp"
+#include "model.hpp"
+#include "parallel.hpp"
+
+/** \file trajectoryfile.hpp
+ * @brief Contains a memory-mapped columnar binary format for trajectories and helpers for running algorithms over
+ * every sample of a file.
+ *
+ * The file starts with a 4096 byte header holding the model hash, number of configuration coordinates, sample rate,
+ * number of samples and a table of columns. Each column is a contiguous block of n_samples x width doubles, stored
+ * sample by sample and aligned to 64 bytes, so columns can be read and written in place without parsing.
+ */
+namespace tinyrobotics {
+
+    /**
+     * @brief Memory-mapped columnar trajectory file. Columns are exposed as row-major n_samples x width Eigen maps
+     * directly onto the file, so reads and writes go straight to the page cache.
+     */
+    class TrajectoryFile {
+    public:
+        /// @brief Row-major matrix type of a column, one row per sample.
+        using ColumnMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+        /// @brief Size of the header in bytes.
+        static constexpr size_t header_size = 4096;
+
+        /// @brief Alignment of column blocks in bytes.
+        static constexpr size_t alignment = 64;
+
+        /// @brief Description of a column in the header.
+        struct Column {
+            /// @brief Name of the column, null terminated.
+            char name[48] = {};
+
+            /// @brief Number of values per sample.
+            uint64_t width = 0;
+
+            /// @brief Offset of the column block from the start of the file in bytes.
+            uint64_t offset = 0;
+        };
+
+        /// @brief Fixed part of the header.
+        struct Header {
+            /// @brief Magic string identifying the format and its version.
+            char magic[8] = {'T', 'R', 'T', 'R', 'A', 'J', '0', '1'};
+
+            /// @brief Hash of the model the trajectory was recorded with, see model_hash.
+            uint64_t model_hash = 0;
+
+            /// @brief Number of configuration coordinates of the model.
+            uint64_t n_q = 0;
+
+            /// @brief Sample rate in Hz.
+            double rate = 0;
+
+            /// @brief Number of samples.
+            uint64_t n_samples = 0;
+
+            /// @brief Number of columns.
+            uint64_t n_columns = 0;
+
+            /// @brief Padding to the alignment of the column table.
+            uint64_t reserved[2] = {};
+        };
+
+        /// @brief Maximum number of columns in a file.
+        static constexpr size_t max_columns = (header_size - sizeof(Header)) / sizeof(Column);
+
+        /**
+         * @brief Creates a new trajectory file with no columns, replacing any existing file.
+         * @param path Path of the file.
+         * @param model_hash Hash of the model the trajectory is recorded with.
+         * @param n_q Number of configuration coordinates of the model.
+         * @param rate Sample rate in Hz.
+         * @param n_samples Number of samples.
+         * @return The open trajectory file.
+         * @throws std::runtime_error if the file cannot be created.
+         */
+        static TrajectoryFile create(const std::string& path,
+                                     const uint64_t model_hash,
+                                     const int n_q,
+                                     const double rate,
+                                     const size_t n_samples) {
+            TrajectoryFile file;
+            file.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (file.fd < 0) {
+                throw std::runtime_error("Error! Could not create [" + path + "]: " + std::strerror(errno));
+            }
+            file.writable = true;
+            file.map(header_size);
+            Header& header    = file.header();
+            header            = Header();
+            header.model_hash = model_hash;
+            header.n_q        = n_q;
+            header.rate       = rate;
+            header.n_samples  = n_samples;
+            return file;
+        }
+
+        /**
+         * @brief Opens an existing trajectory file.
+         * @param path Path of the file.
+         * @param writable Whether columns may be written and added.
+         * @return The open trajectory file.
+         * @throws std::runtime_error if the file cannot be opened or is not a trajectory file.
+         */
+        static TrajectoryFile open(const std::string& path, const bool writable = false) {
+            TrajectoryFile file;
+            file.fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+            if (file.fd < 0) {
+                throw std::runtime_error("Error! Could not open [" + path + "]: " + std::strerror(errno));
+            }
+            file.writable = writable;
+            struct stat st;
+            if (::fstat(file.fd, &st) != 0 || size_t(st.st_size) < header_size) {
+                throw std::runtime_error("Error! [" + path + "] is not a trajectory file.");
+            }
+            file.map(st.st_size);
+            if (std::memcmp(file.header().magic, Header().magic, sizeof(Header::magic)) != 0) {
+                throw std::runtime_error("Error! [" + path + "] is not a trajectory file.");
+            }
+            return file;
+        }
+
+        TrajectoryFile() = default;
+
+        TrajectoryFile(TrajectoryFile&& other) noexcept {
+            *this = std::move(other);
+        }
+
+        TrajectoryFile& operator=(TrajectoryFile&& other) noexcept {
+            std::swap(fd, other.fd);
+            std::swap(data, other.data);
+            std::swap(size, other.size);
+            std::swap(writable, other.writable);
+            return *this;
+        }
+
+        TrajectoryFile(const TrajectoryFile&)            = delete;
+        TrajectoryFile& operator=(const TrajectoryFile&) = delete;
+
+        ~TrajectoryFile() {
+            if (data != nullptr) {
+                ::munmap(data, size);
+            }
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+
+        /// @brief Hash of the model the trajectory was recorded with.
+        uint64_t model_hash() const {
+            return header().model_hash;
+        }
+
+        /// @brief Number of configuration coordinates of the model.
+        int n_q() const {
+            return header().n_q;
+        }
+
+        /// @brief Sample rate in Hz.
+        double rate() const {
+            return header().rate;
+        }
+
+        /// @brief Number of samples.
+        size_t n_samples() const {
+            return header().n_samples;
+        }
+
+        /// @brief Names of the columns.
+        std::vector<std::string> column_names() const {
+            std::vector<std::string> names;
+            for (size_t i = 0; i < header().n_columns; ++i) {
+                names.push_back(columns()[i].name);
+            }
+            return names;
+        }
+
+        /**
+         * @brief Checks whether the file has a column.
+         * @param name Name of the column.
+         * @return True if the column exists.
+         */
+        bool has_column(const std::string& name) const {
+            return find_column(name) != nullptr;
+        }
+
+        /**
+         * @brief Adds a column, growing the file. Existing column maps are invalidated.
+         * @param name Name of the column.
+         * @param width Number of values per sample.
+         * @throws std::runtime_error if the file is read only, the column exists or there are too many columns.
+         */
+        void add_column(const std::string& name, const size_t width) {
+            if (!writable) {
+                throw std::runtime_error("Error! Trajectory file is read only.");
+            }
+            if (has_column(name) || name.size() >= sizeof(Column::name)) {
+                throw std::runtime_error("Error! Invalid or duplicate column name [" + name + "].");
+            }
+            if (header().n_columns >= max_columns) {
+                throw std::runtime_error("Error! Trajectory file has too many columns.");
+            }
+            const size_t offset = (size + alignment - 1) / alignment * alignment;
+            map(offset + n_samples() * width * sizeof(double));
+            Column& column = columns()[header().n_columns++];
+            std::strncpy(column.name, name.c_str(), sizeof(column.name) - 1);
+            column.width  = width;
+            column.offset = offset;
+        }
+
+        /**
+         * @brief Get a column as a read only n_samples x width matrix mapped onto the file.
+         * @param name Name of the column.
+         * @return The column.
+         * @throws std::out_of_range if the column does not exist.
+         */
+        Eigen::Map<const ColumnMatrix> column(const std::string& name) const {
+            const Column& c = get_column(name);
+            return Eigen::Map<const ColumnMatrix>(reinterpret_cast<const double*>(data + c.offset),
+                                                  n_samples(),
+                                                  c.width);
+        }
+
+        /**
+         * @brief Get a column as a writable n_samples x width matrix mapped onto the file.
+         * @param name Name of the column.
+         * @return The column.
+         * @throws std::runtime_error if the file is read only.
+         * @throws std::out_of_range if the column does not exist.
+         */
+        Eigen::Map<ColumnMatrix> mutable_column(const std::string& name) {
+            if (!writable) {
+                throw std::runtime_error("Error! Trajectory file is read only.");
+            }
+            const Column& c = get_column(name);
+            return Eigen::Map<ColumnMatrix>(reinterpret_cast<double*>(data + c.offset), n_samples(), c.width);
+        }
+
+        /// @brief Flushes written columns to disk.
+        void sync() {
+            if (data != nullptr && ::msync(data, size, MS_SYNC) != 0) {
+                throw std::runtime_error("Error! Could not sync trajectory file: " + std::string(std::strerror(errno)));
+            }
+        }
+
+    private:
+        Header& header() {
+            return *reinterpret_cast<Header*>(data);
+        }
+
+        const Header& header() const {
+            return *reinterpret_cast<const Header*>(data);
+        }
+
+        Column* columns() {
+            return reinterpret_cast<Column*>(data + sizeof(Header));
+        }
+
+        const Column* columns() const {
+            return reinterpret_cast<const Column*>(data + sizeof(Header));
+        }
+
+        const Column* find_column(const std::string& name) const {
+            for (size_t i = 0; i < header().n_columns; ++i) {
+                if (name == columns()[i].name) {
+                    return &columns()[i];
+                }
+            }
+            return nullptr;
+        }
+
+        const Column& get_column(const std::string& name) const {
+            const Column* column = find_column(name);
+            if (column == nullptr) {
+                throw std::out_of_range("Error! Trajectory file has no column [" + name + "].");
+            }
+            return *column;
+        }
+
+        /**
+         * @brief Maps the file, growing it first if it is writable and smaller than new_size.
+         * @param new_size Size of the file in bytes.
+         */
+        void map(const size_t new_size) {
+            if (data != nullptr) {
+                ::munmap(data, size);
+                data = nullptr;
+            }
+            if (writable && ::ftruncate(fd, new_size) != 0) {
+                throw std::runtime_error("Error! Could not resize trajectory file: " + std::string(std::strerror(errno)));
+            }
+            void* ptr = ::mmap(nullptr, new_size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+            if (ptr == MAP_FAILED) {
+                throw std::runtime_error("Error! Could not map trajectory file: " + std::string(std::strerror(errno)));
+            }
+            data = static_cast<char*>(ptr);
+            size = new_size;
+        }
+
+        /// @brief File descriptor of the file.
+        int fd = -1;
+
+        /// @brief Start of the mapping.
+        char* data = nullptr;
+
+        /// @brief Size of the mapping in bytes.
+        size_t size = 0;
+
+        /// @brief Whether the file is mapped for writing.
+        bool writable = false;
+    };
+
+    /**
+     * @brief Runs a function over every sample of a trajectory file in chunks across threads, writing an output
+     * column in place. The output column is added if it does not exist.
+     * @param file Trajectory file, opened writable.
+     * @param model tinyrobotics model the trajectory was recorded with.
+     * @param inputs Names of the input columns.
+     * @param output Name of the output column.
+     * @param output_width Number of output values per sample.
+     * @param function Function called as function(model, inputs, output) for each sample, where inputs holds a
+     * pointer to the sample in each input column and output points to the sample in the output column.
+     * @param chunk_size Number of samples per chunk.
+     * @param n_threads Number of threads to use, the default thread count if zero or less.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @tparam Function Type of the function.
+     * @throws std::invalid_argument if the file was recorded with a different model.
+     */
+    template <typename Scalar, int nq, typename Function>
+    void apply_over_file(TrajectoryFile& file,
+                         const Model<Scalar, nq>& model,
+                         const std::vector<std::string>& inputs,
+                         const std::string& output,
+                         const int output_width,
+                         const Function& function,
+                         const int chunk_size = 4096,
+                         const int n_threads  = 0) {
+        if (file.n_q() != nq || file.model_hash() != model_hash(model)) {
+            throw std::invalid_argument("Error! Trajectory file was recorded with a different model.");
+        }
+        if (!file.has_column(output)) {
+            file.add_column(output, output_width);
+        }
+
+        // Column maps are taken after the output column is added as adding a column remaps the file
+        std::vector<const double*> input_data;
+        std::vector<int> input_widths;
+        for (const auto& name : inputs) {
+            const auto column = file.column(name);
+            input_data.push_back(column.data());
+            input_widths.push_back(column.cols());
+        }
+        auto output_column = file.mutable_column(output);
+        if (output_column.cols() != output_width) {
+            throw std::invalid_argument("Error! Column [" + output + "] has the wrong width.");
+        }
+
+        // Each thread needs its own model as it holds the pre-allocated workspace
+        const int threads = n_threads > 0 ? n_threads : default_thread_count();
+        std::vector<Model<Scalar, nq>> workspaces(threads, model);
+        const int n_samples = file.n_samples();
+        const int n_chunks  = (n_samples + chunk_size - 1) / chunk_size;
+        parallel_for(
+            n_chunks,
+            [&](const int begin, const int end, const int thread_idx) {
+                std::vector<const double*> sample_inputs(inputs.size());
+                for (int i = begin * chunk_size; i < std::min(n_samples, end * chunk_size); ++i) {
+                    for (size_t j = 0; j < inputs.size(); ++j) {
+                        sample_inputs[j] = input_data[j] + size_t(i) * input_widths[j];
+                    }
+                    function(workspaces[thread_idx], sample_inputs, output_column.data() + size_t(i) * output_width);
+                }
+            },
+            threads);
+    }
+
+    /**
+     * @brief Computes the inverse dynamics for every sample of a trajectory file.
+     * @param file Trajectory file, opened writable.
+     * @param model tinyrobotics model the trajectory was recorded with.
+     * @param q Name of the joint configuration column.
+     * @param dq Name of the joint velocity column.
+     * @param ddq Name of the joint acceleration column.
+     * @param output Name of the joint torque column written.
+     * @param n_threads Number of threads to use, the default thread count if zero or less.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    void apply_inverse_dynamics(TrajectoryFile& file,
+                                const Model<Scalar, nq>& model,
+                                const std::string& q      = "q",
+                                const std::string& dq     = "dq",
+                                const std::string& ddq    = "ddq",
+                                const std::string& output = "tau_id",
+                                const int n_threads       = 0) {
+        using Configuration = Eigen::Matrix<Scalar, nq, 1>;
+        using ConstMap      = Eigen::Map<const Eigen::Matrix<double, nq, 1>>;
+        apply_over_file(
+            file,
+            model,
+            {q, dq, ddq},
+            output,
+            nq,
+            [](Model<Scalar, nq>& m, const std::vector<const double*>& in, double* out) {
+                Eigen::Map<Eigen::Matrix<double, nq, 1>> tau(out);
+                tau = inverse_dynamics(m,
+                                       Configuration(ConstMap(in[0]).template cast<Scalar>()),
+                                       Configuration(ConstMap(in[1]).template cast<Scalar>()),
+                                       Configuration(ConstMap(in[2]).template cast<Scalar>()))
+                          .template cast<double>();
+            },
+            4096,
+            n_threads);
+    }
+
+    /**
+     * @brief Computes the transform between the target and source links for every sample of a trajectory file, stored
+     * as row-major 4x4 matrices.
+     * @param file Trajectory file, opened writable.
+     * @param model tinyrobotics model the trajectory was recorded with.
+     * @param target_link Target link, which can be an integer (index) or a string (name).
+     * @param source_link Source link, which can be an integer (index) or a string (name).
+     * @param q Name of the joint configuration column.
+     * @param output Name of the transform column written.
+     * @param n_threads Number of threads to use, the default thread count if zero or less.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     * @tparam TargetLink Type of target_link parameter, which can be int or std::string.
+     * @tparam SourceLink Type of source_link parameter, which can be int or std::string.
+     */
+    template <typename Scalar, int nq, typename TargetLink, typename SourceLink>
+    void apply_forward_kinematics(TrajectoryFile& file,
+                                  const Model<Scalar, nq>& model,
+                                  const TargetLink& target_link,
+                                  const SourceLink& source_link,
+                                  const std::string& q,
+                                  const std::string& output,
+                                  const int n_threads = 0) {
+        using Configuration = Eigen::Matrix<Scalar, nq, 1>;
+        using ConstMap      = Eigen::Map<const Eigen::Matrix<double, nq, 1>>;
+        const int target    = get_link_idx(model, target_link);
+        const int source    = get_link_idx(model, source_link);
+        apply_over_file(
+            file,
+            model,
+            {q},
+            output,
+            16,
+            [&](Model<Scalar, nq>& m, const std::vector<const double*>& in, double* out) {
+                Eigen::Map<Eigen::Matrix<double, 4, 4, Eigen::RowMajor>> H(out);
+                H = forward_kinematics(m, Configuration(ConstMap(in[0]).template cast<Scalar>()), target, source)
+                        .matrix()
+                        .template cast<double>();
+            },
+            4096,
+            n_threads);
+    }
+
+    /**
+     * @brief Computes the center of mass in the base link frame for every sample of a trajectory file.
+     * @param file Trajectory file, opened writable.
+     * @param model tinyrobotics model the trajectory was recorded with.
+     * @param q Name of the joint configuration column.
+     * @param output Name of the center of mass column written.
+     * @param n_threads Number of threads to use, the default thread count if zero or less.
+     * @tparam Scalar type of the tinyrobotics model.
+     * @tparam nq Number of configuration coordinates (degrees of freedom).
+     */
+    template <typename Scalar, int nq>
+    void apply_center_of_mass(TrajectoryFile& file,
+                              const Model<Scalar, nq>& model,
+                              const std::string& q      = "q",
+                              const std::string& output = "com",
+                              const int n_threads       = 0) {
+        using Configuration = Eigen::Matrix<Scalar, nq, 1>;
+        using ConstMap      = Eigen::Map<const Eigen::Matrix<double, nq, 1>>;
+        apply_over_file(
+            file,
+            model,
+            {q},
+            output,
+            3,
+            [](Model<Scalar, nq>& m, const std::vector<const double*>& in, double* out) {
+                Eigen::Map<Eigen::Vector3d> com(out);
+                com = center_of_mass(m, Configuration(ConstMap(in[0]).template cast<Scalar>())).template cast<double>();
+            },
+            4096,
+            n_threads);
+    }
+
+}  // namespace tinyrobotics
+
+#endif
@@ -0,0 +1,284 @@
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../include/dispatch.hpp"
+#include "../include/dynamics.hpp"
+#include "../include/kinematics.hpp"
+#include "../include/parallel.hpp"
+#include "../include/parser.hpp"
+
+namespace py = pybind11;
+using namespace tinyrobotics;
+
+/// @brief Input array which shares the memory of C contiguous float64 NumPy arrays without copying.
+using InputArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+/// @brief Output array allocated by the bindings and filled in place.
+using OutputArray = py::array_t<double, py::array::c_style>;
+
+/**
+ * @brief Checks an input array has shape (N, cols) and returns N.
+ * @param array The input array.
+ * @param cols Expected number of columns.
+ * @param name Name of the argument for error messages.
+ * @return Number of samples N.
+ */
+py::ssize_t batch_size(const InputArray& array, const py::ssize_t cols, const std::string& name) {
+    if (array.ndim() != 2 || array.shape(1) != cols) {
+        throw std::invalid_argument("Error! " + name + " must have shape (N, " + std::to_string(cols) + ").");
+    }
+    return array.shape(0);
+}
+
+/**
+ * @brief A tinyrobotics model whose number of configuration coordinates is only known at runtime.
+ */
+struct PyModel {
+    virtual ~PyModel() = default;
+
+    /// @brief Number of threads used by the batched functions, the default thread count if zero or less.
+    int n_threads = 0;
+
+    virtual std::string name() const                    = 0;
+    virtual int n_q() const                             = 0;
+    virtual std::vector<std::string> link_names() const = 0;
+    virtual OutputArray forward_kinematics(const InputArray& q)                                   = 0;
+    virtual OutputArray forward_kinematics_link(const InputArray& q, const std::string& target,
+                                                const std::string& source)                        = 0;
+    virtual OutputArray jacobian(const InputArray& q, const std::string& target, ReferenceFrame frame) = 0;
+    virtual OutputArray center_of_mass(const InputArray& q)                                       = 0;
+    virtual OutputArray mass_matrix(const InputArray& q)                                          = 0;
+    virtual OutputArray forward_dynamics(const InputArray& q, const InputArray& dq, const InputArray& tau) = 0;
+    virtual OutputArray inverse_dynamics(const InputArray& q, const InputArray& dq, const InputArray& ddq) = 0;
+};
+
+/**
+ * @brief Implementation of PyModel for a fixed number of configuration coordinates.
+ * @tparam nq Number of configuration coordinates (degrees of freedom).
+ */
+template <int nq>
+struct PyModelImpl : PyModel {
+    using Configuration = Eigen::Matrix<double, nq, 1>;
+    using ConstMap      = Eigen::Map<const Configuration>;
+    // Jacobians are stored row major, Eigen requires single column matrices to be column major
+    using JacobianMap   = Eigen::Map<Eigen::Matrix<double, 6, nq, nq == 1 ? Eigen::ColMajor : Eigen::RowMajor>>;
+
+    /// @brief Model the bindings were loaded with.
+    Model<double, nq> model;
+
+    /// @brief Copies of the model used as per-thread workspaces, as each model holds its own pre-allocated buffers.
+    std::vector<Model<double, nq>> workspaces;
+
+    explicit PyModelImpl(const Model<double, nq>& model_) : model(model_) {}
+
+    std::string name() const override {
+        return model.name;
+    }
+
+    int n_q() const override {
+        return nq;
+    }
+
+    std::vector<std::string> link_names() const override {
+        std::vector<std::string> names;
+        for (const auto& link : model.links) {
+            names.push_back(link.name);
+        }
+        return names;
+    }
+
+    /**
+     * @brief Runs a function over N samples with the GIL released, each thread using its own model workspace.
+     * @param n Number of samples.
+     * @param function Function called as function(model, i) for each sample.
+     */
+    template <typename Function>
+    void run(const py::ssize_t n, const Function& function) {
+        const int threads = std::max(1, std::min<int>(n_threads > 0 ? n_threads : default_thread_count(), n));
+        if (int(workspaces.size()) < threads) {
+            workspaces.resize(threads, model);
+        }
+        py::gil_scoped_release release;
+        parallel_for(
+            n,
+            [&](const int begin, const int end, const int thread_idx) {
+                for (int i = begin; i < end; ++i) {
+                    function(workspaces[thread_idx], i);
+                }
+            },
+            threads);
+    }
+
+    OutputArray forward_kinematics(const InputArray& q) override {
+        const py::ssize_t n       = batch_size(q, nq, "q");
+        const py::ssize_t n_links = model.links.size();
+        OutputArray H({n, n_links, py::ssize_t(4), py::ssize_t(4)});
+        const double* q_ptr = q.data();
+        double* H_ptr       = H.mutable_data();
+        run(n, [&](Model<double, nq>& m, const int i) {
+            tinyrobotics::forward_kinematics(m, Configuration(ConstMap(q_ptr + i * nq)));
+            for (py::ssize_t l = 0; l < n_links; ++l) {
+                // Row major 4x4 output
+                Eigen::Map<Eigen::Matrix<double, 4, 4, Eigen::RowMajor>>(H_ptr + (i * n_links + l) * 16) =
+                    m.forward_kinematics[l].matrix();
+            }
+        });
+        return H;
+    }
+
+    OutputArray forward_kinematics_link(const InputArray& q,
+                                        const std::string& target,
+                                        const std::string& source) override {
+        const py::ssize_t n = batch_size(q, nq, "q");
+        OutputArray H({n, py::ssize_t(4), py::ssize_t(4)});
+        const double* q_ptr = q.data();
+        double* H_ptr       = H.mutable_data();
+        run(n, [&](Model<double, nq>& m, const int i) {
+            Eigen::Map<Eigen::Matrix<double, 4, 4, Eigen::RowMajor>>(H_ptr + i * 16) =
+                tinyrobotics::forward_kinematics(m, Configuration(ConstMap(q_ptr + i * nq)), target, source).matrix();
+        });
+        return H;
+    }
+
+    OutputArray jacobian(const InputArray& q, const std::string& target, const ReferenceFrame frame) override {
+        const py::ssize_t n = batch_size(q, nq, "q");
+        OutputArray J({n, py::ssize_t(6), py::ssize_t(nq)});
+        const double* q_ptr = q.data();
+        double* J_ptr       = J.mutable_data();
+        run(n, [&](Model<double, nq>& m, const int i) {
+            JacobianMap(J_ptr + i * 6 * nq) =
+                tinyrobotics::jacobian(m, Configuration(ConstMap(q_ptr + i * nq)), target, frame);
+        });
+        return J;
+    }
+
+    OutputArray center_of_mass(const InputArray& q) override {
+        const py::ssize_t n = batch_size(q, nq, "q");
+        OutputArray com({n, py::ssize_t(3)});
+        const double* q_ptr = q.data();
+        double* com_ptr     = com.mutable_data();
+        run(n, [&](Model<double, nq>& m, const int i) {
+            Eigen::Map<Eigen::Vector3d>(com_ptr + i * 3) =
+                tinyrobotics::center_of_mass(m, Configuration(ConstMap(q_ptr + i * nq)));
+        });
+        return com;
+    }
+
+    OutputArray mass_matrix(const InputArray& q) override {
+        const py::ssize_t n = batch_size(q, nq, "q");
+        OutputArray M({n, py::ssize_t(nq), py::ssize_t(nq)});
+        const double* q_ptr = q.data();
+        double* M_ptr       = M.mutable_data();
+        run(n, [&](Model<double, nq>& m, const int i) {
+            // The mass matrix is symmetric so the storage order does not matter
+            Eigen::Map<Eigen::Matrix<double, nq, nq>>(M_ptr + i * nq * nq) =
+                tinyrobotics::mass_matrix(m, Configuration(ConstMap(q_ptr + i * nq)));
+        });
+        return M;
+    }
+
+    OutputArray forward_dynamics(const InputArray& q, const InputArray& dq, const InputArray& tau) override {
+        const py::ssize_t n = batch_size(q, nq, "q");
+        if (batch_size(dq, nq, "dq") != n || batch_size(tau, nq, "tau") != n) {
+            throw std::invalid_argument("Error! q, dq and tau must have the same number of samples.");
+        }
+        OutputArray ddq({n, py::ssize_t(nq)});
+        const double* q_ptr   = q.data();
+        const double* dq_ptr  = dq.data();
+        const double* tau_ptr = tau.data();
+        double* ddq_ptr       = ddq.mutable_data();
+        run(n, [&](Model<double, nq>& m, const int i) {
+            Eigen::Map<Configuration>(ddq_ptr + i * nq) =
+                tinyrobotics::forward_dynamics(m,
+                                               Configuration(ConstMap(q_ptr + i * nq)),
+                                               Configuration(ConstMap(dq_ptr + i * nq)),
+                                               Configuration(ConstMap(tau_ptr + i * nq)));
+        });
+        return ddq;
+    }
+
+    OutputArray inverse_dynamics(const InputArray& q, const InputArray& dq, const InputArray& ddq) override {
+        const py::ssize_t n = batch_size(q, nq, "q");
+        if (batch_size(dq, nq, "dq") != n || batch_size(ddq, nq, "ddq") != n) {
+            throw std::invalid_argument("Error! q, dq and ddq must have the same number of samples.");
+        }
+        OutputArray tau({n, py::ssize_t(nq)});
+        const double* q_ptr   = q.data();
+        const double* dq_ptr  = dq.data();
+        const double* ddq_ptr = ddq.data();
+        double* tau_ptr       = tau.mutable_data();
+        run(n, [&](Model<double, nq>& m, const int i) {
+            Eigen::Map<Configuration>(tau_ptr + i * nq) =
+                tinyrobotics::inverse_dynamics(m,
+                                               Configuration(ConstMap(q_ptr + i * nq)),
+                                               Configuration(ConstMap(dq_ptr + i * nq)),
+                                               Configuration(ConstMap(ddq_ptr + i * nq)));
+        });
+        return tau;
+    }
+};
+
+/**
+ * @brief Load a model from a URDF file, selecting the implementation matching its number of joints.
+ * @param path_to_urdf Path to the URDF file.
+ * @return The loaded model.
+ */
+std::unique_ptr<PyModel> load_urdf(const std::string& path_to_urdf) {
+    return dispatch_nq(urdf_n_q(path_to_urdf), [&](auto n) -> std::unique_ptr<PyModel> {
+        constexpr int nq = decltype(n)::value;
+        return std::make_unique<PyModelImpl<nq>>(import_urdf<double, nq>(path_to_urdf));
+    });
+}
+
+PYBIND11_MODULE(tinyrobotics, m) {
+    m.doc() = "Batched Python bindings for the tinyrobotics kinematics and dynamics library. Functions take (N, nq) "
+              "arrays of samples and return (N, ...) arrays, running in parallel with the GIL released.";
+
+    py::enum_<ReferenceFrame>(m, "ReferenceFrame")
+        .value("LOCAL", ReferenceFrame::LOCAL)
+        .value("WORLD", ReferenceFrame::WORLD)
+        .value("LOCAL_WORLD_ALIGNED", ReferenceFrame::LOCAL_WORLD_ALIGNED);
+
+    py::class_<PyModel>(m, "Model")
+        .def_property_readonly("name", &PyModel::name)
+        .def_property_readonly("n_q", &PyModel::n_q)
+        .def_property_readonly("link_names", &PyModel::link_names)
+        .def_readwrite("n_threads", &PyModel::n_threads, "Number of threads, the hardware thread count if <= 0.")
+        .def("forward_kinematics",
+             &PyModel::forward_kinematics,
+             py::arg("q"),
+             "Transforms of all links from the base link, (N, nq) -> (N, n_links, 4, 4).")
+        .def("forward_kinematics",
+             &PyModel::forward_kinematics_link,
+             py::arg("q"),
+             py::arg("target_link"),
+             py::arg("source_link"),
+             "Transform of the target link in the source link frame, (N, nq) -> (N, 4, 4).")
+        .def("jacobian",
+             &PyModel::jacobian,
+             py::arg("q"),
+             py::arg("target_link"),
+             py::arg("frame") = ReferenceFrame::LOCAL_WORLD_ALIGNED,
+             "Geometric jacobian of the target link, (N, nq) -> (N, 6, nq).")
+        .def("center_of_mass", &PyModel::center_of_mass, py::arg("q"), "Center of mass, (N, nq) -> (N, 3).")
+        .def("mass_matrix", &PyModel::mass_matrix, py::arg("q"), "Mass matrix, (N, nq) -> (N, nq, nq).")
+        .def("forward_dynamics",
+             &PyModel::forward_dynamics,
+             py::arg("q"),
+             py::arg("dq"),
+             py::arg("tau"),
+             "Joint accelerations via the articulated-body algorithm, 3 x (N, nq) -> (N, nq).")
+        .def("inverse_dynamics",
+             &PyModel::inverse_dynamics,
+             py::arg("q"),
+             py::arg("dq"),
+             py::arg("ddq"),
+             "Joint torques via the recursive Newton-Euler algorithm, 3 x (N, nq) -> (N, nq).");
+
+    m.def("import_urdf", &load_urdf, py::arg("path_to_urdf"), "Load a model from a URDF file.");
+}
@@ -0,0 +1,79 @@
+#include <csignal>
+#include <iostream>
+
+#include "../include/dispatch.hpp"
+#include "../include/service.hpp"
+
+using namespace tinyrobotics;
+
+/**
+ * @brief Serves a model until SIGINT or SIGTERM is received, then prints the service statistics.
+ * @param model tinyrobotics model to serve.
+ * @param socket_path Path of the UNIX domain socket.
+ * @param options Service options.
+ */
+template <int nq>
+void run(const Model<double, nq>& model, const std::string& socket_path, const ServiceOptions<double, nq>& options) {
+    // Block the termination signals in every thread so they can be waited on
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    Service<double, nq> service(model, options);
+    service.start(socket_path);
+    std::cout << "Serving " << model.name << " (" << nq << " joints) on " << socket_path << " with "
+              << options.n_workers << " workers" << std::endl;
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    service.stop();
+
+    const char* names[n_solved_request_types] = {"inverse_kinematics",
+                                                 "forward_dynamics",
+                                                 "inverse_dynamics",
+                                                 "mass_matrix",
+                                                 "gravity_torque"};
+    const ServiceStatistics statistics        = service.statistics();
+    std::cout << statistics.n_batches << " batches, mean batch size " << statistics.mean_batch_size << std::endl;
+    for (int i = 0; i < n_solved_request_types; ++i) {
+        const LatencyStatistics& l = statistics.latency[i];
+        std::cout << names[i] << ": " << l.count << " requests, queue mean " << l.mean_queue_us << " us max "
+                  << l.max_queue_us << " us, solve mean " << l.mean_solve_us << " us max " << l.max_solve_us << " us"
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <urdf> <socket> [n_workers] [max_batch_size] [batch_window_us]"
+                  << std::endl;
+        return 1;
+    }
+    const std::string path_to_urdf = argv[1];
+    const std::string socket_path  = argv[2];
+
+    try {
+        dispatch_nq(urdf_n_q(path_to_urdf), [&](auto n) {
+            constexpr int nq = decltype(n)::value;
+            ServiceOptions<double, nq> options;
+            if (argc > 3) {
+                options.n_workers = std::stoi(argv[3]);
+            }
+            if (argc > 4) {
+                options.max_batch_size = std::stoi(argv[4]);
+            }
+            if (argc > 5) {
+                options.batch_window = std::chrono::microseconds(std::stoi(argv[5]));
+            }
+            options.ik_options.max_iterations = 1000;
+            run<nq>(import_urdf<double, nq>(path_to_urdf), socket_path, options);
+        });
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <vector>
+
+#include "../capi/tinyrobotics_c.h"
+#include "../include/dynamics.hpp"
+#include "../include/kinematics.hpp"
+#include "../include/parser.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test batched C interface against templated functions for panda model", "[CAPI]") {
+    const int n_joints = 7;
+    const size_t n     = 5;
+    auto robot_model   = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+
+    tr_model* model = tr_import_urdf("data/urdfs/panda_arm.urdf");
+    REQUIRE(model != nullptr);
+    REQUIRE(tr_model_n_q(model) == n_joints);
+    REQUIRE(tr_model_n_links(model) == int(robot_model.links.size()));
+    const int target = tr_model_link_index(model, "panda_link8");
+    const int source = tr_model_base_link_index(model);
+    REQUIRE(target == robot_model.get_link("panda_link8").idx);
+    CHECK(tr_model_link_index(model, "not_a_link") == -1);
+
+    tr_workspace* workspace = tr_workspace_create(model);
+    REQUIRE(workspace != nullptr);
+
+    // Workspaces remain valid after the model is freed
+    tr_model_free(model);
+
+    std::vector<double> q(n * n_joints), dq(n * n_joints), u(n * n_joints);
+    for (size_t i = 0; i < n; ++i) {
+        Eigen::Map<Eigen::Matrix<double, n_joints, 1>>(q.data() + i * n_joints)  = robot_model.random_configuration();
+        Eigen::Map<Eigen::Matrix<double, n_joints, 1>>(dq.data() + i * n_joints) = robot_model.random_configuration();
+        Eigen::Map<Eigen::Matrix<double, n_joints, 1>>(u.data() + i * n_joints)  = robot_model.random_configuration();
+    }
+
+    std::vector<double> H(n * 16), J(n * 6 * n_joints), ddq(n * n_joints), tau(n * n_joints),
+        M(n * n_joints * n_joints);
+    REQUIRE(tr_forward_kinematics(workspace, n, q.data(), target, source, H.data()) == TR_SUCCESS);
+    REQUIRE(tr_jacobian(workspace, n, q.data(), target, source, TR_FRAME_LOCAL, J.data()) == TR_SUCCESS);
+    REQUIRE(tr_forward_dynamics(workspace, n, q.data(), dq.data(), u.data(), ddq.data()) == TR_SUCCESS);
+    REQUIRE(tr_inverse_dynamics(workspace, n, q.data(), dq.data(), u.data(), tau.data()) == TR_SUCCESS);
+    REQUIRE(tr_mass_matrix(workspace, n, q.data(), M.data()) == TR_SUCCESS);
+
+    for (size_t i = 0; i < n; ++i) {
+        Eigen::Matrix<double, n_joints, 1> qi  = Eigen::Map<Eigen::Matrix<double, n_joints, 1>>(q.data() + i * n_joints);
+        Eigen::Matrix<double, n_joints, 1> dqi = Eigen::Map<Eigen::Matrix<double, n_joints, 1>>(dq.data() + i * n_joints);
+        Eigen::Matrix<double, n_joints, 1> ui  = Eigen::Map<Eigen::Matrix<double, n_joints, 1>>(u.data() + i * n_joints);
+
+        Eigen::Matrix<double, 4, 4, Eigen::RowMajor> Hi(H.data() + i * 16);
+        CHECK(Hi.isApprox(forward_kinematics(robot_model, qi, target, source).matrix()));
+        Eigen::Matrix<double, 6, n_joints, Eigen::RowMajor> Ji(J.data() + i * 6 * n_joints);
+        CHECK(Ji.isApprox(jacobian(robot_model, qi, target, ReferenceFrame::LOCAL)));
+        Eigen::Matrix<double, n_joints, 1> ddqi(ddq.data() + i * n_joints);
+        CHECK(ddqi.isApprox(forward_dynamics(robot_model, qi, dqi, ui)));
+        Eigen::Matrix<double, n_joints, 1> taui(tau.data() + i * n_joints);
+        CHECK(taui.isApprox(inverse_dynamics(robot_model, qi, dqi, ui)));
+        Eigen::Matrix<double, n_joints, n_joints> Mi(M.data() + i * n_joints * n_joints);
+        CHECK(Mi.isApprox(mass_matrix(robot_model, qi)));
+    }
+
+    // Errors are reported through return codes rather than exceptions
+    CHECK(tr_forward_kinematics(workspace, n, q.data(), 1000, source, H.data()) == TR_ERROR);
+    CHECK(std::string(tr_last_error()).size() > 0);
+    CHECK(tr_jacobian(workspace, n, q.data(), target, source, 7, J.data()) == TR_ERROR);
+    CHECK(tr_import_urdf("data/urdfs/does_not_exist.urdf") == nullptr);
+
+    tr_workspace_free(workspace);
+}
@@ -0,0 +1,81 @@
+#include <unistd.h>
+
+#include <cstdio>
+
+#include "../include/parser.hpp"
+#include "../include/replay.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test capture and replay of solver calls for panda model", "[Capture]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    auto capture        = enable_capture(robot_model, 4);
+
+    InverseKinematicsOptions<double, n_joints> options;
+    options.method         = InverseKinematicsMethod::LEVENBERG_MARQUARDT;
+    options.max_iterations = 200;
+
+    // Capture more calls than the buffer holds, keeping the results of the calls which remain
+    std::vector<Configuration> results;
+    for (int i = 0; i < 3; ++i) {
+        Configuration q = robot_model.random_configuration();
+        auto H          = forward_kinematics(robot_model, q, std::string("panda_link8"), std::string("panda_link0"));
+        results.push_back(inverse_kinematics(robot_model,
+                                             "panda_link8",
+                                             "panda_link0",
+                                             H,
+                                             robot_model.home_configuration(),
+                                             options));
+        results.push_back(forward_dynamics(robot_model, q, q, q));
+    }
+    results.erase(results.begin(), results.begin() + 2);
+
+    // Round trip through a file
+    const std::string path = "/tmp/tinyrobotics_capture_test_" + std::to_string(::getpid()) + ".cap";
+    capture->dump(path);
+    const CaptureBuffer loaded = CaptureBuffer::load(path);
+    std::remove(path.c_str());
+    const std::vector<CaptureRecord> records = loaded.records();
+    REQUIRE(records.size() == 4);
+    CHECK(loaded.model_hash == model_hash(robot_model));
+    for (size_t i = 0; i < records.size(); ++i) {
+        CHECK(records[i].type
+              == (i % 2 == 0 ? CaptureCallType::INVERSE_KINEMATICS : CaptureCallType::FORWARD_DYNAMICS));
+        CHECK(records[i].duration_ns > 0);
+    }
+
+    // Replaying the calls reproduces their results without capturing them again
+    robot_model.capture = nullptr;
+    for (size_t i = 0; i < records.size(); ++i) {
+        CHECK(replay_call(robot_model, records[i]).isApprox(results[i]));
+    }
+    const std::vector<ReplayResult> replayed = replay(robot_model, loaded, 2);
+    CHECK(replayed.size() == 4);
+    CHECK(replayed[0].benchmark.n_repeats == 2);
+    CHECK(capture->records().size() == 4);
+
+    // Calls captured from another model are rejected
+    auto other_model = import_urdf<double, n_joints>("data/urdfs/kuka.urdf");
+    CHECK_THROWS(replay(other_model, loaded));
+}
+
+TEST_CASE("Test benchmark harness counters", "[Capture]") {
+    int n_calls                  = 0;
+    const BenchmarkResult result = benchmark("count", [&] { ++n_calls; }, 5, 2);
+    CHECK(n_calls == 2 + 5 + 5);
+    CHECK(result.n_repeats == 5);
+    CHECK(result.min_ns <= result.median_ns);
+    CHECK(result.median_ns <= result.max_ns);
+
+    // Counters are either unavailable or counted per call
+    PerfCounters counters;
+    if (counters.available(PerfEvent::INSTRUCTIONS)) {
+        CHECK(result.count(PerfEvent::INSTRUCTIONS) > 0);
+    }
+    else {
+        CHECK(std::isnan(result.count(PerfEvent::INSTRUCTIONS)));
+    }
+}
@@ -213,4 +213,194 @@ TEST_CASE("Test gravity torque vector", "[Dynamics]") {
     Eigen::Matrix<double, n_joints, 1> G = gravity_torque(robot_model, q);
     CHECK(G(0) == Approx(-3.0946));
     CHECK(G(1) == Approx(4.8559));
-}
\ No newline at end of file
+}
+TEST_CASE("Test moving base dynamics and per call gravity for panda_arm", "[Dynamics]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    Configuration q     = robot_model.random_configuration();
+    Configuration dq    = Configuration::Random();
+    Configuration ddq   = Configuration::Random();
+
+    // A base at rest under the model gravity matches the fixed base dynamics
+    Configuration tau = inverse_dynamics(robot_model, q, dq, ddq);
+    CHECK(inverse_dynamics(robot_model, q, dq, ddq, fixed_base(robot_model)).isApprox(tau));
+
+    // Changing the model gravity after loading changes the dynamics
+    robot_model.gravity = Eigen::Vector3d(0, 0, -1.62);
+    CHECK(!inverse_dynamics(robot_model, q, dq, ddq).isApprox(tau));
+    robot_model.gravity = Eigen::Vector3d(0, 0, -9.81);
+
+    // A base accelerating upwards is equivalent to stronger gravity
+    BaseState<double> lift;
+    lift.acceleration(5) = 2.0;
+    BaseState<double> heavy;
+    heavy.gravity = Eigen::Vector3d(0, 0, -11.81);
+    CHECK(inverse_dynamics(robot_model, q, dq, ddq, lift).isApprox(inverse_dynamics(robot_model, q, dq, ddq, heavy)));
+
+    // The first joint rotates about the base z axis, so base yaw motion adds to its velocity and acceleration
+    BaseState<double> yaw;
+    yaw.velocity(2)     = 0.7;
+    yaw.acceleration(2) = -0.3;
+    Configuration dq_yaw = dq, ddq_yaw = ddq;
+    dq_yaw(0) += 0.7;
+    ddq_yaw(0) -= 0.3;
+    CHECK(inverse_dynamics(robot_model, q, dq, ddq, yaw).isApprox(inverse_dynamics(robot_model, q, dq_yaw, ddq_yaw)));
+
+    // Forward dynamics inverts inverse dynamics on a moving base
+    BaseState<double> ship;
+    ship.velocity     = Eigen::Matrix<double, 6, 1>::Random();
+    ship.acceleration = Eigen::Matrix<double, 6, 1>::Random();
+    ship.gravity      = Eigen::Vector3d(0.5, -0.3, -9.7);
+    tau               = inverse_dynamics(robot_model, q, dq, ddq, ship);
+    CHECK(forward_dynamics(robot_model, q, dq, tau, ship).isApprox(ddq, 1e-6));
+    CHECK(forward_dynamics_crb(robot_model, q, dq, tau, ship).isApprox(ddq, 1e-6));
+}
+
+TEST_CASE("Test IMU and force-torque sensor readings for panda_arm", "[Dynamics]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    Configuration q     = robot_model.random_configuration();
+    Configuration dq    = Configuration::Random();
+    Configuration ddq   = Configuration::Random();
+
+    // An IMU on a link with a fixed joint, and force-torque sensors at the base and at a joint
+    Eigen::Isometry3d imu_origin = Eigen::Isometry3d::Identity();
+    imu_origin.translation()     = Eigen::Vector3d(0.05, -0.02, 0.1);
+    imu_origin.linear()          = Eigen::AngleAxisd(0.8, Eigen::Vector3d(1, 2, 3).normalized()).toRotationMatrix();
+    const int imu  = robot_model.add_sensor("imu", SensorType::IMU, "panda_link8", imu_origin);
+    const int base = robot_model.add_sensor("base_ft", SensorType::FORCE_TORQUE, "panda_link0");
+    const int ft   = robot_model.add_sensor("joint4_ft", SensorType::FORCE_TORQUE, "panda_link4");
+    CHECK_THROWS(robot_model.add_sensor("missing", SensorType::IMU, "not_a_link"));
+
+    // At rest the base sensor carries the weight of the robot and the IMU reads the reaction to gravity
+    const Configuration zero = Configuration::Zero();
+    auto readings            = sensor_readings(robot_model, q, zero, zero);
+    REQUIRE(readings.size() == 3);
+    CHECK(readings[base].tail<3>().isApprox(Eigen::Vector3d(0, 0, robot_model.mass * 9.81)));
+    const Eigen::Isometry3d imu_pose = forward_kinematics(robot_model, q, std::string("panda_link8")) * imu_origin;
+    CHECK(readings[imu].head<3>().isZero());
+    CHECK(readings[imu].tail<3>().isApprox(imu_pose.linear().transpose() * Eigen::Vector3d(0, 0, 9.81)));
+
+    // In motion the IMU matches the finite difference of its pose along q + dq t + ddq t^2 / 2
+    readings     = sensor_readings(robot_model, q, dq, ddq);
+    auto pose_at = [&](const double t) {
+        const Configuration q_t = q + dq * t + ddq * t * t / 2;
+        return Eigen::Isometry3d(forward_kinematics(robot_model, q_t, std::string("panda_link8")) * imu_origin);
+    };
+    const double h                         = 1e-4;
+    const Eigen::Vector3d acceleration     = (pose_at(h).translation() - 2 * imu_pose.translation()
+                                          + pose_at(-h).translation())
+                                         / (h * h);
+    const Eigen::Matrix3d dR               = (pose_at(h).linear() - pose_at(-h).linear()) / (2 * h);
+    const Eigen::Matrix3d omega_skew       = imu_pose.linear().transpose() * dR;
+    const Eigen::Vector3d angular_velocity = Eigen::Vector3d(omega_skew(2, 1), omega_skew(0, 2), omega_skew(1, 0));
+    CHECK(readings[imu].head<3>().isApprox(angular_velocity, 1e-5));
+    CHECK(readings[imu].tail<3>().isApprox(
+        imu_pose.linear().transpose() * (acceleration - Eigen::Vector3d(0, 0, -9.81)), 1e-4));
+
+    // The joint sensor wrench projected onto the joint axis is the joint torque
+    const Configuration tau = inverse_dynamics(robot_model, q, dq, ddq);
+    const auto& link4       = robot_model.get_link("panda_link4");
+    CHECK(double(link4.joint.S.transpose() * readings[ft]) == Approx(tau(link4.joint.idx)));
+
+    // External forces, added to the link wrenches as in apply_external_forces, are carried through to the sensors
+    std::vector<Eigen::Matrix<double, 6, 1>> f_ext(n_joints, Eigen::Matrix<double, 6, 1>::Zero());
+    f_ext[n_joints - 1](5) = 10.0;
+    readings               = sensor_readings(robot_model, q, zero, zero, f_ext);
+    CHECK(readings[base].tail<3>().isApprox(Eigen::Vector3d(0, 0, robot_model.mass * 9.81 + 10.0)));
+    CHECK(forward_dynamics(robot_model, q, dq, inverse_dynamics(robot_model, q, dq, ddq, f_ext), f_ext)
+              .isApprox(ddq, 1e-6));
+}
+
+TEST_CASE("Test joint reaction wrenches including fixed joints", "[Dynamics]") {
+    const int n_joints  = 2;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/2_link_with_fixed.urdf");
+    Configuration q     = robot_model.random_configuration();
+    Configuration dq    = Configuration::Random();
+    Configuration ddq   = Configuration::Random();
+
+    const Configuration tau = inverse_dynamics(robot_model, q, dq, ddq);
+    const auto& wrenches    = joint_wrenches(robot_model, q, dq, ddq);
+    REQUIRE(wrenches.size() == robot_model.links.size());
+    const auto& link_1     = robot_model.get_link("link_1");
+    const auto& fixed_link = robot_model.get_link("fixed_link");
+    const auto& link_2     = robot_model.get_link("link_2");
+
+    // The wrenches through the revolute joints project onto their axes as the joint torques
+    CHECK(double(link_1.joint.S.transpose() * wrenches[link_1.idx]) == Approx(tau(0)));
+    CHECK(double(link_2.joint.S.transpose() * wrenches[link_2.idx]) == Approx(tau(1)));
+
+    // The fixed joint carries the fixed link and link_2, so link_1 only adds its own inertial wrench
+    const Eigen::Matrix<double, 6, 6> I_1 =
+        inertia_to_spatial(link_1.mass, Eigen::Vector3d(link_1.center_of_mass.translation()), link_1.inertia);
+    const Eigen::Matrix<double, 6, 1> own_1 =
+        I_1 * robot_model.a[0] + cross_motion(robot_model.v[0]) * I_1 * robot_model.v[0];
+    CHECK((wrenches[link_1.idx] - own_1).isApprox(wrenches[fixed_link.idx]));
+
+    // The base link carries the whole robot, which is not moving at rest
+    const Configuration zero = Configuration::Zero();
+    const Eigen::Matrix<double, 6, 1> at_rest = joint_wrenches(robot_model, q, zero, zero)[robot_model.base_link_idx];
+    CHECK(at_rest.tail<3>().isApprox(Eigen::Vector3d(0, 0, robot_model.mass * 9.81)));
+
+    // World frame wrenches are taken about the base origin, and aligned wrenches about the link origin
+    std::vector<Eigen::Matrix<double, 6, 1>> local = joint_wrenches(robot_model, q, dq, ddq);
+    std::vector<Eigen::Matrix<double, 6, 1>> world = joint_wrenches(robot_model, q, dq, ddq, ReferenceFrame::WORLD);
+    std::vector<Eigen::Matrix<double, 6, 1>> aligned =
+        joint_wrenches(robot_model, q, dq, ddq, ReferenceFrame::LOCAL_WORLD_ALIGNED);
+    for (const auto& link : robot_model.links) {
+        const Eigen::Isometry3d H = forward_kinematics(robot_model, q, link.idx);
+        CHECK(aligned[link.idx].head<3>().isApprox(H.linear() * local[link.idx].head<3>()));
+        CHECK(aligned[link.idx].tail<3>().isApprox(H.linear() * local[link.idx].tail<3>()));
+        CHECK(world[link.idx].tail<3>().isApprox(aligned[link.idx].tail<3>()));
+        CHECK(world[link.idx].head<3>().isApprox(
+            aligned[link.idx].head<3>() + H.translation().cross(Eigen::Vector3d(aligned[link.idx].tail<3>()))));
+    }
+}
+
+TEST_CASE("Test Coriolis matrix for panda_arm", "[Dynamics]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    using Matrix        = Eigen::Matrix<double, n_joints, n_joints>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    Configuration q     = robot_model.random_configuration();
+    Configuration dq    = Configuration::Random();
+
+    // C dq is the velocity product term of the inverse dynamics
+    const Matrix C           = coriolis_matrix(robot_model, q, dq);
+    const Configuration zero = Configuration::Zero();
+    CHECK((C * dq).isApprox(inverse_dynamics(robot_model, q, dq, zero) - gravity_torque(robot_model, q)));
+
+    // dM/dt - 2 C is skew symmetric, with dM/dt from a central difference along dq
+    const double h  = 1e-6;
+    const Matrix dM = (mass_matrix(robot_model, Configuration(q + dq * h))
+                       - mass_matrix(robot_model, Configuration(q - dq * h)))
+                      / (2 * h);
+    const Matrix N  = dM - 2 * C;
+    CHECK((N + N.transpose()).norm() < 1e-6);
+    CHECK((C + C.transpose()).isApprox(dM, 1e-6));
+}
+
+TEST_CASE("Test mass matrix time derivative for NUgus model", "[Dynamics]") {
+    const int n_joints  = 20;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    using Matrix        = Eigen::Matrix<double, n_joints, n_joints>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/nugus.urdf");
+    Configuration q     = robot_model.random_configuration();
+    Configuration dq    = Configuration::Random();
+
+    // Matches the mass matrix and a central difference of it along dq
+    const auto [M, dM]         = mass_matrix_and_derivative(robot_model, q, dq);
+    const double h             = 1e-6;
+    const Matrix dM_difference = (mass_matrix(robot_model, Configuration(q + dq * h))
+                                  - mass_matrix(robot_model, Configuration(q - dq * h)))
+                                 / (2 * h);
+    CHECK(M.isApprox(mass_matrix(robot_model, q)));
+    CHECK(dM.isApprox(dM_difference, 1e-6));
+
+    // dM/dt = C + C^T
+    const Matrix C = coriolis_matrix(robot_model, q, dq);
+    CHECK(dM.isApprox(C + C.transpose()));
+}
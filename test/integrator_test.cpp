@@ -0,0 +1,116 @@
+#include "../include/integrator.hpp"
+
+#include "../include/parser.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test variational integrator conserves energy of a passive arm", "[Integrator]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    Configuration q0;
+    q0 << 0, -0.5, 0, -2, 0, 1.5, 0.7;
+    const Configuration dq0  = Configuration::Zero();
+    const Configuration zero = Configuration::Zero();
+    const double energy      = total_energy(robot_model, q0, dq0);
+    const double h           = 1e-3;
+
+    // Swing freely under gravity for 2 s
+    VariationalIntegrator<double, n_joints> integrator(robot_model);
+    integrator.reset(q0, dq0);
+    Configuration q  = q0;
+    Configuration dq = dq0;
+    for (int k = 0; k < 2000; k++) {
+        integrator.step(zero, h);
+        CHECK(integrator.residual_norm() < 1e-8);
+
+        // Semi-implicit Euler on forward dynamics with the same step
+        dq += h * forward_dynamics(robot_model, q, dq, zero);
+        q += h * dq;
+    }
+    Configuration q_vi  = integrator.q();
+    Configuration dq_vi = integrator.dq();
+    CHECK(integrator.momentum().isApprox(mass_matrix(robot_model, q_vi) * dq_vi));
+    CHECK(!q_vi.isApprox(q0));
+
+    const double drift_vi    = std::abs(total_energy(robot_model, q_vi, dq_vi) - energy);
+    const double drift_euler = std::abs(total_energy(robot_model, q, dq) - energy);
+    CHECK(drift_vi < 1e-3 * std::abs(energy));
+    CHECK(drift_vi < 1e-2 * drift_euler);
+}
+
+TEST_CASE("Test variational integrator holds a gravity compensated arm", "[Integrator]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    const Configuration q0  = robot_model.random_configuration();
+    const Configuration tau = gravity_torque(robot_model, q0);
+
+    VariationalIntegrator<double, n_joints> integrator(robot_model);
+    integrator.reset(q0, Configuration::Zero());
+    for (int k = 0; k < 10; k++) {
+        integrator.step(tau, 1e-2);
+    }
+    CHECK(integrator.q().isApprox(q0, 1e-8));
+    CHECK(integrator.momentum().norm() < 1e-8);
+}
+
+TEST_CASE("Test Dormand-Prince integrator reuses the last stage and samples dense output", "[Integrator]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    Configuration q0;
+    q0 << 0, -0.5, 0, -2, 0, 1.5, 0.7;
+    const Configuration zero = Configuration::Zero();
+    const double energy      = total_energy(robot_model, q0, zero);
+
+    DormandPrinceOptions<double> options;
+    options.relative_tolerance = 1e-8;
+    options.absolute_tolerance = 1e-8;
+    DormandPrinceIntegrator<double, n_joints> sampled(robot_model, options);
+    sampled.reset(q0, zero);
+    std::vector<double> times;
+    std::vector<Configuration> samples;
+    sampled.integrate(zero, 0.5, 0.01, [&](const double t, const Configuration& q, const Configuration& dq) {
+        times.push_back(t);
+        samples.push_back(q);
+    });
+    REQUIRE(samples.size() == 51);
+    CHECK(sampled.t() == Approx(0.5));
+    CHECK(std::abs(total_energy(robot_model, sampled.q(), sampled.dq()) - energy) < 1e-5);
+
+    // One forward dynamics call per stage, except the first stage of every step after the first
+    CHECK(sampled.evaluations() == 6 * (sampled.accepted_steps() + sampled.rejected_steps()) + 1);
+
+    // Dense output matches stepping to each sample time
+    DormandPrinceIntegrator<double, n_joints> stepped(robot_model, options);
+    stepped.reset(q0, zero);
+    for (size_t k = 1; k < samples.size(); k++) {
+        stepped.integrate(zero, times[k]);
+        CHECK(stepped.q().isApprox(samples[k], 1e-6));
+    }
+    CHECK(stepped.evaluations() > sampled.evaluations());
+}
+
+TEST_CASE("Test Dormand-Prince batch integration matches single integration", "[Integrator]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    const Configuration zero = Configuration::Zero();
+    std::vector<Configuration> q(20), dq(20);
+    for (size_t i = 0; i < q.size(); i++) {
+        q[i]  = robot_model.random_configuration();
+        dq[i] = Configuration::Random();
+    }
+    const std::vector<Configuration> q0 = q, dq0 = dq;
+    integrate_batch(robot_model, q, dq, zero, 0.2, DormandPrinceOptions<double>(), 4);
+
+    DormandPrinceIntegrator<double, n_joints> integrator(robot_model);
+    for (size_t i = 0; i < q.size(); i++) {
+        integrator.reset(q0[i], dq0[i]);
+        integrator.integrate(zero, 0.2);
+        CHECK(q[i] == integrator.q());
+        CHECK(dq[i] == integrator.dq());
+    }
+}
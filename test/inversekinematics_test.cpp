@@ -307,3 +307,47 @@ TEST_CASE("Test inverse kinematics for nugus robot with all IK methods", "[inver
         REQUIRE(homogeneous_error(Hst_desired, Hst_solution).squaredNorm() < 1e-3);
     }
 }
+
+TEST_CASE("Test batched levenberg-marquardt inverse kinematics for nugus robot", "[inversekinematics]") {
+    // Load model
+    const int n_joints           = 20;
+    auto nugus                   = import_urdf<double, n_joints>("data/urdfs/nugus.urdf");
+    std::string target_link_name = "left_foot_base";
+    std::string source_link_name = "torso";
+
+    // Make a batch of problems which does not fill the last set of lanes
+    const int n_problems = 10;
+    std::vector<Eigen::Transform<double, 3, Eigen::Isometry>> Hst_desired;
+    std::vector<Eigen::Matrix<double, n_joints, 1>> q0;
+    for (int i = 0; i < n_problems; ++i) {
+        Eigen::Matrix<double, n_joints, 1> q_random = nugus.random_configuration();
+        Hst_desired.push_back(forward_kinematics(nugus, q_random, target_link_name, source_link_name));
+        q0.push_back(nugus.home_configuration());
+    }
+
+    // Solve the batch in lockstep
+    InverseKinematicsOptions<double, n_joints> options;
+    options.method         = InverseKinematicsMethod::LEVENBERG_MARQUARDT;
+    options.max_iterations = 1000;
+    options.tolerance      = 1e-6;
+    auto q_batch           = inverse_kinematics_levenberg_marquardt_batch<double, n_joints, 4>(nugus,
+                                                                                     target_link_name,
+                                                                                     source_link_name,
+                                                                                     Hst_desired,
+                                                                                     q0,
+                                                                                     options);
+    REQUIRE(q_batch.size() == n_problems);
+
+    // Check that each solution matches the scalar solver
+    for (int i = 0; i < n_problems; ++i) {
+        auto q_scalar = inverse_kinematics<double, n_joints>(nugus,
+                                                             target_link_name,
+                                                             source_link_name,
+                                                             Hst_desired[i],
+                                                             q0[i],
+                                                             options);
+        auto Hst_batch  = forward_kinematics(nugus, q_batch[i], target_link_name, source_link_name);
+        auto Hst_scalar = forward_kinematics(nugus, q_scalar, target_link_name, source_link_name);
+        REQUIRE(homogeneous_error(Hst_batch, Hst_scalar).squaredNorm() < 1e-6);
+    }
+}
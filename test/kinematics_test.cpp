@@ -125,6 +125,61 @@ TEST_CASE("Test jacobian calculations for kuka model", "[ForwardKinematics]") {
     REQUIRE(J.isApprox(J_expected, 1e-4));
 }
 
+TEST_CASE("Test jacobian calculations in each reference frame for kuka model", "[ForwardKinematics]") {
+    auto kuka_model = import_urdf<double, 7>("data/urdfs/kuka.urdf");
+    // Create a configuration for the robot
+    auto q = kuka_model.home_configuration();
+    q << 1, 2, 3, 4, 5, 6, 7;
+    std::string target_link_name = "kuka_arm_7_link";
+    auto J_aligned               = jacobian(kuka_model, q, target_link_name);
+    auto Hbt                     = forward_kinematics(kuka_model, q, target_link_name);
+    // Local jacobian is the aligned jacobian rotated into the target link frame
+    Eigen::Matrix<double, 6, 7> J_local_expected;
+    J_local_expected << Hbt.linear().transpose() * J_aligned.topRows(3),
+        Hbt.linear().transpose() * J_aligned.bottomRows(3);
+    auto J_local = jacobian(kuka_model, q, target_link_name, ReferenceFrame::LOCAL);
+    REQUIRE(J_local.isApprox(J_local_expected, 1e-8));
+    // World jacobian takes the linear velocity about the base link origin
+    Eigen::Matrix<double, 6, 7> J_world_expected;
+    J_world_expected << J_aligned.topRows(3) + skew(Eigen::Vector3d(Hbt.translation())) * J_aligned.bottomRows(3),
+        J_aligned.bottomRows(3);
+    auto J_world = jacobian(kuka_model, q, target_link_name, ReferenceFrame::WORLD);
+    REQUIRE(J_world.isApprox(J_world_expected, 1e-8));
+    // Spatial velocities match the jacobian in the same frame
+    Eigen::Matrix<double, 7, 1> dq;
+    dq << 1, -1, 2, -2, 3, -3, 4;
+    auto v_local = spatial_velocity(kuka_model, q, dq, target_link_name, ReferenceFrame::LOCAL);
+    REQUIRE(v_local.isApprox(J_local_expected * dq, 1e-8));
+    // Linear velocity in the aligned frame matches the finite difference of the target position
+    const double h                       = 1e-6;
+    Eigen::Matrix<double, 7, 1> q_plus   = q + h * dq;
+    Eigen::Matrix<double, 3, 1> dp_numer = (forward_kinematics(kuka_model, q_plus, target_link_name).translation()
+                                            - Hbt.translation())
+                                           / h;
+    auto v_aligned = spatial_velocity(kuka_model, q, dq, target_link_name);
+    REQUIRE(v_aligned.head(3).isApprox(dp_numer, 1e-4));
+}
+
+TEST_CASE("Test jacobian calculations in each reference frame with source for simple model", "[ForwardKinematics]") {
+    // Create a configuration for the robot
+    auto q = robot_model.home_configuration();
+    q << 1, 2, 3, 4;
+    std::string target_link_name = "left_foot";
+    std::string source_link_name = "body";
+    auto Hst                     = forward_kinematics(robot_model, q, target_link_name, source_link_name);
+    auto J_aligned               = jacobian(robot_model, q, target_link_name, source_link_name);
+    // Local jacobian is the aligned jacobian rotated into the target link frame
+    auto J_local = jacobian(robot_model, q, target_link_name, source_link_name, ReferenceFrame::LOCAL);
+    REQUIRE(J_local.topRows(3).isApprox(Hst.linear().transpose() * J_aligned.topRows(3), 1e-8));
+    REQUIRE(J_local.bottomRows(3).isApprox(Hst.linear().transpose() * J_aligned.bottomRows(3), 1e-8));
+    // World jacobian takes the linear velocity about the source link origin
+    auto J_world = jacobian(robot_model, q, target_link_name, source_link_name, ReferenceFrame::WORLD);
+    Eigen::Matrix<double, 6, 4> J_world_expected;
+    J_world_expected << J_aligned.topRows(3) + skew(Eigen::Vector3d(Hst.translation())) * J_aligned.bottomRows(3),
+        J_aligned.bottomRows(3);
+    REQUIRE((J_world - J_world_expected).norm() < 1e-8);
+}
+
 TEST_CASE("Test center of mass", "[ForwardKinematics]") {
     // Compute FK for a given configuration
     auto q = robot_model.home_configuration();
@@ -137,4 +192,140 @@ TEST_CASE("Test center of mass", "[ForwardKinematics]") {
     Eigen::Matrix<double, 3, 1> rCBb_expected;
     rCBb_expected << 923.0397e-003, 0.0000e+000, 2.2055e+000;
     REQUIRE(rCBb.isApprox(rCBb_expected, 1e-4));
-};
\ No newline at end of file
+};
+TEST_CASE("Test batched contact point jacobians and torques for panda_arm", "[Kinematics]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    Configuration q     = robot_model.random_configuration();
+
+    // Points scattered over every link including the base
+    std::vector<ContactPoint<double>> contacts;
+    for (int i = 0; i < 200; ++i) {
+        contacts.push_back({i % int(robot_model.links.size()), Eigen::Vector3d::Random() * 0.1});
+    }
+    const ContactJacobians<double, n_joints> J = contact_jacobians(robot_model, q, contacts);
+    REQUIRE(J.x.rows() == 200);
+
+    // Each point jacobian matches the link jacobian shifted to the point
+    for (size_t k = 0; k < contacts.size(); ++k) {
+        const int link                                    = contacts[k].link;
+        const Eigen::Matrix<double, 6, n_joints> Jl       = jacobian(robot_model, q, link);
+        const Eigen::Isometry3d H                         = forward_kinematics(robot_model, q, link);
+        const Eigen::Vector3d r                           = H.linear() * contacts[k].point;
+        const Eigen::Matrix<double, 3, n_joints> expected = Jl.topRows<3>() - skew(r) * Jl.bottomRows<3>();
+        CHECK(J.jacobian(k).isApprox(expected, 1e-9));
+        CHECK(J.positions.col(k).isApprox(H * contacts[k].point));
+    }
+
+    // The torques of the contact forces match the sum of J^T f
+    const Eigen::Matrix<double, 3, Eigen::Dynamic> forces = Eigen::Matrix<double, 3, Eigen::Dynamic>::Random(3, 200);
+    Configuration expected                                = Configuration::Zero();
+    for (size_t k = 0; k < contacts.size(); ++k) {
+        expected += J.jacobian(k).transpose() * forces.col(k);
+    }
+    CHECK(contact_torques(robot_model, q, contacts, forces).isApprox(expected, 1e-9));
+
+    // Invalid inputs are reported
+    contacts.push_back({100, Eigen::Vector3d::Zero()});
+    CHECK_THROWS_AS(contact_jacobians(robot_model, q, contacts), std::invalid_argument);
+    CHECK_THROWS_AS(contact_torques(robot_model, q, contacts, forces), std::invalid_argument);
+}
+
+TEST_CASE("Test pruned forward kinematics of a link set for nugus", "[Kinematics]") {
+    const int n_joints  = 20;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/nugus.urdf");
+    Configuration q     = robot_model.random_configuration();
+
+    const std::vector<std::string> names = {"left_foot_base", "right_foot_base", "head", "left_foot"};
+    LinkSet<double> set                  = link_set(robot_model, names);
+    REQUIRE(set.links.size() == names.size());
+    CHECK(set.order.size() < robot_model.links.size());
+
+    // Every parent is evaluated before its children
+    for (size_t k = 0; k < set.order.size(); ++k) {
+        CHECK(set.parent[k] < int(k));
+    }
+
+    // The transforms match full forward kinematics
+    const auto& transforms = forward_kinematics(robot_model, q, set);
+    const auto full        = forward_kinematics(robot_model, q);
+    for (size_t k = 0; k < names.size(); ++k) {
+        CHECK(transforms[k].isApprox(full[robot_model.get_link(names[k]).idx]));
+    }
+
+    CHECK_THROWS_AS(link_set(robot_model, std::vector<int>{100}), std::invalid_argument);
+}
+
+TEST_CASE("Test relative transforms and jacobians through the lowest common ancestor for nugus", "[Kinematics]") {
+    const int n_joints  = 20;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/nugus.urdf");
+    Configuration q     = robot_model.random_configuration();
+
+    const int left_foot  = robot_model.get_link("left_foot_base").idx;
+    const int right_foot = robot_model.get_link("right_foot_base").idx;
+    const int head       = robot_model.get_link("head").idx;
+    CHECK(robot_model.lowest_common_ancestor(left_foot, right_foot) == robot_model.base_link_idx);
+    CHECK(robot_model.lowest_common_ancestor(head, robot_model.get_link("neck").idx)
+          == robot_model.get_link("neck").idx);
+    CHECK(robot_model.lowest_common_ancestor(left_foot, robot_model.get_link("left_ankle").idx)
+          == robot_model.get_link("left_ankle").idx);
+
+    // Relative transforms match full forward kinematics
+    const auto full = forward_kinematics(robot_model, q);
+    CHECK(forward_kinematics(robot_model, q, left_foot, right_foot)
+              .isApprox(full[right_foot].inverse() * full[left_foot]));
+    CHECK(forward_kinematics(robot_model, q, head, left_foot).isApprox(full[left_foot].inverse() * full[head]));
+    CHECK(forward_kinematics(robot_model, q, head).isApprox(full[head]));
+
+    // The jacobian of the left foot relative to the right foot matches central differences of the relative pose
+    const Eigen::Matrix<double, 6, n_joints> J = jacobian(robot_model, q, left_foot, right_foot);
+    const double h                             = 1e-6;
+    for (int i = 0; i < n_joints; ++i) {
+        Configuration q_plus = q, q_minus = q;
+        q_plus(i) += h;
+        q_minus(i) -= h;
+        const Eigen::Isometry3d H_plus  = forward_kinematics(robot_model, q_plus, left_foot, right_foot);
+        const Eigen::Isometry3d H_minus = forward_kinematics(robot_model, q_minus, left_foot, right_foot);
+        const Eigen::Isometry3d H       = forward_kinematics(robot_model, q, left_foot, right_foot);
+        const Eigen::Vector3d v         = (H_plus.translation() - H_minus.translation()) / (2 * h);
+        const Eigen::Matrix3d W         = (H_plus.linear() - H_minus.linear()) / (2 * h) * H.linear().transpose();
+        const Eigen::Vector3d w(W(2, 1), W(0, 2), W(1, 0));
+        CHECK((J.block<3, 1>(0, i) - v).norm() < 1e-6);
+        CHECK((J.block<3, 1>(3, i) - w).norm() < 1e-6);
+    }
+
+    // Expressed in the target frame the jacobian is rotated into the target axes
+    const Eigen::Matrix3d R = forward_kinematics(robot_model, q, left_foot, right_foot).linear();
+    const Eigen::Matrix<double, 6, n_joints> J_local =
+        jacobian(robot_model, q, left_foot, right_foot, ReferenceFrame::LOCAL);
+    CHECK(J_local.topRows<3>().isApprox(R.transpose() * J.topRows<3>()));
+    CHECK(J_local.bottomRows<3>().isApprox(R.transpose() * J.bottomRows<3>()));
+}
+
+TEST_CASE("Test compact pose kernels against homogeneous transforms for nugus", "[Kinematics]") {
+    auto robot_model = import_urdf<double, 20>("data/urdfs/nugus.urdf");
+    auto q           = robot_model.random_configuration();
+    forward_kinematics(robot_model, q);
+
+    for (const auto& link : robot_model.links) {
+        // Local pose kernel matches the parent transform times the joint transform
+        if (link.joint.idx != -1) {
+            const Eigen::Isometry3d H = link.joint.parent_transform * link.joint.get_joint_transform(q(link.joint.idx));
+            CHECK(link.joint.get_local_pose(q(link.joint.idx)).isometry().isApprox(H));
+        }
+        CHECK(robot_model.link_poses[link.idx].isometry().isApprox(robot_model.forward_kinematics[link.idx]));
+    }
+
+    const Eigen::Isometry3d A = robot_model.forward_kinematics[robot_model.get_link("left_foot_base").idx];
+    const Eigen::Isometry3d B = robot_model.forward_kinematics[robot_model.get_link("head").idx];
+    const Pose<double> a(A);
+    const Pose<double> b(B);
+    const Eigen::Vector3d p(0.1, -0.2, 0.3);
+    CHECK((a * b).isometry().isApprox(A * B));
+    CHECK(a.inverse().isometry().isApprox(A.inverse()));
+    CHECK(a.inverse_compose(b).isometry().isApprox(A.inverse() * B));
+    CHECK((a * p).isApprox(A * p));
+}
@@ -1,6 +1,8 @@
 #define CATCH_CONFIG_MAIN
 #include <string>
 
+#include "../include/dispatch.hpp"
+#include "../include/parallel.hpp"
 #include "../include/parser.hpp"
 #include "catch2/catch.hpp"
 
@@ -122,4 +124,27 @@ TEST_CASE("Cast a Model from double to float", "[Model]") {
           == Eigen::Transform<float, 3, Eigen::Isometry>::Identity().matrix());
     CHECK(robot_model_float.get_joint("floating_base_x").child_transform.matrix()
           == Eigen::Transform<float, 3, Eigen::Isometry>::Identity().matrix());
-};
\ No newline at end of file
+};
+TEST_CASE("Load a model whose number of joints is only known at runtime", "[Model]") {
+    const std::string path = "data/urdfs/kuka.urdf";
+    const int n            = urdf_n_q(path);
+    CHECK(n == 7);
+    auto n_q = dispatch_nq(n, [&](auto nq) {
+        auto robot_model = import_urdf<double, decltype(nq)::value>(path);
+        return robot_model.n_q;
+    });
+    CHECK(n_q == 7);
+    CHECK_THROWS(dispatch_nq(TR_MAX_DISPATCH_NQ + 1, [](auto nq) { return decltype(nq)::value; }));
+
+    // Each sample should be processed exactly once
+    std::vector<int> counts(1001, 0);
+    parallel_for(
+        counts.size(),
+        [&](const int begin, const int end, const int) {
+            for (int i = begin; i < end; ++i) {
+                counts[i]++;
+            }
+        },
+        4);
+    CHECK(std::all_of(counts.begin(), counts.end(), [](int c) { return c == 1; }));
+}
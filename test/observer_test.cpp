@@ -0,0 +1,57 @@
+#include "../include/observer.hpp"
+
+#include "../include/parser.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test momentum terms against the mass matrix and gravity torque", "[Observer]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/kuka.urdf");
+    Configuration q     = robot_model.random_configuration();
+    Configuration dq    = Configuration::Random();
+
+    const MomentumTerms<double, n_joints> terms = momentum_terms(robot_model, q, dq);
+    CHECK(terms.momentum.isApprox(mass_matrix(robot_model, q) * dq));
+    CHECK(terms.gravity.isApprox(gravity_torque(robot_model, q)));
+
+    // C^T dq = dM/dt dq - C dq, with dM/dt from a central difference along dq
+    const double h = 1e-6;
+    const Eigen::Matrix<double, n_joints, n_joints> dM =
+        (mass_matrix(robot_model, Configuration(q + dq * h)) - mass_matrix(robot_model, Configuration(q - dq * h)))
+        / (2 * h);
+    const Configuration zero     = Configuration::Zero();
+    const Configuration coriolis = inverse_dynamics(robot_model, q, dq, zero) - terms.gravity;
+    CHECK(terms.coriolis_transpose.isApprox(dM * dq - coriolis, 1e-6));
+}
+
+TEST_CASE("Test momentum observer estimates a constant external torque", "[Observer]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    Configuration q     = robot_model.random_configuration(1.0);
+    Configuration dq    = Configuration::Zero();
+
+    MomentumObserver<double, n_joints> observer(robot_model, Configuration::Constant(100.0));
+    observer.reset(q, dq);
+    CHECK(observer.residual().isZero());
+
+    // Simulate a damped, gravity compensated arm at 1 kHz with a push on the second joint after 0.1 s
+    const double dt       = 1e-3;
+    Configuration tau_ext = Configuration::Zero();
+    for (int k = 0; k < 600; ++k) {
+        if (k == 100) {
+            tau_ext(1) = 5.0;
+        }
+        const Configuration tau = gravity_torque(robot_model, q) - 2.0 * dq;
+        const Configuration ddq = forward_dynamics(robot_model, q, dq, Configuration(tau + tau_ext));
+        q += dq * dt + ddq * dt * dt / 2;
+        dq += ddq * dt;
+        observer.update(q, dq, tau, dt);
+        if (k == 99) {
+            CHECK(observer.residual().norm() < 1e-2);
+        }
+    }
+    CHECK((observer.residual() - tau_ext).norm() < 0.1);
+}
@@ -0,0 +1,91 @@
+#include <atomic>
+#include <stdexcept>
+
+#include "../include/parser.hpp"
+#include "../include/scene.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test work stealing scheduler runs every task once", "[Scene]") {
+    WorkStealingScheduler scheduler(4);
+    CHECK(scheduler.n_threads() == 4);
+    for (int batch = 0; batch < 20; ++batch) {
+        std::vector<std::atomic<int>> counts(257);
+        std::atomic<int> max_thread(0);
+        scheduler.run(counts.size(), [&](const int task, const int thread) {
+            counts[task]++;
+            max_thread = std::max(max_thread.load(), thread);
+        });
+        CHECK(max_thread < 4);
+        for (const auto& count : counts) {
+            CHECK(count == 1);
+        }
+    }
+    CHECK_THROWS_AS(scheduler.run(8, [](const int task, int) {
+                        if (task == 5) {
+                            throw std::runtime_error("Error! Task failed.");
+                        }
+                    }),
+                    std::runtime_error);
+}
+
+TEST_CASE("Test scene of robots with different numbers of joints", "[Scene]") {
+    auto panda                     = import_urdf<double, 7>("data/urdfs/panda_arm.urdf");
+    auto five                      = import_urdf<double, 5>("data/urdfs/5_link.urdf");
+    using Vector7                  = Eigen::Matrix<double, 7, 1>;
+    const std::string end_effector = "panda_link8";
+
+    Scene<double> scene(3);
+    Eigen::Isometry3d left = Eigen::Isometry3d::Identity();
+    left.translation()     = Eigen::Vector3d(1, 0, 0);
+    Eigen::Isometry3d hung = Eigen::Isometry3d::Identity();
+    hung.linear()          = Eigen::AngleAxisd(M_PI, Eigen::Vector3d::UnitX()).toRotationMatrix();
+    hung.translation()     = Eigen::Vector3d(0, 0, 2);
+    auto& arm              = scene.add_robot(panda, left, "left");
+    auto& ceiling          = scene.add_robot(panda, hung, "ceiling");
+    scene.add_robot(five, Eigen::Isometry3d::Identity(), "five");
+    CHECK(scene.n_robots() == 3);
+    CHECK(scene.robot("five").n_q() == 5);
+    CHECK_THROWS(scene.robot("missing"));
+
+    const Vector7 q      = panda.random_configuration();
+    const Vector7 q_goal = q + Vector7::Constant(0.1);
+    arm.q                = q;
+    ceiling.q            = q;
+
+    arm.ik_options.method         = InverseKinematicsMethod::LEVENBERG_MARQUARDT;
+    arm.ik_options.max_iterations = 200;
+    arm.ik_target_link            = end_effector;
+    arm.ik_target_pose            = left * forward_kinematics(panda, q_goal, end_effector);
+
+    SceneTasks tasks;
+    tasks.inverse_dynamics   = true;
+    tasks.forward_dynamics   = true;
+    tasks.inverse_kinematics = true;
+    scene.update(tasks);
+
+    // World frame placement of the links
+    CHECK(scene.link_pose("left", end_effector).isApprox(left * forward_kinematics(panda, q, end_effector)));
+    CHECK(scene.link_pose("ceiling", end_effector).isApprox(hung * forward_kinematics(panda, q, end_effector)));
+    CHECK(scene.placements().size() == 2 * panda.links.size() + five.links.size());
+    CHECK_THROWS(scene.link_pose("left", "missing"));
+
+    // Gravity is rotated into the frame of each base
+    const Vector7 zero = Vector7::Zero();
+    CHECK(Vector7(arm.torque).isApprox(inverse_dynamics(panda, q, zero, zero)));
+    BaseState<double> flipped;
+    flipped.gravity = Eigen::Vector3d(0, 0, 9.81);
+    CHECK(Vector7(ceiling.torque).isApprox(inverse_dynamics(panda, q, zero, zero, flipped)));
+    CHECK(Vector7(arm.acceleration).isApprox(forward_dynamics(panda, q, zero, zero)));
+
+    // Inverse kinematics solves for the world frame target
+    REQUIRE(arm.ik_solution.size() == 7);
+    CHECK((left * forward_kinematics(panda, Vector7(arm.ik_solution), end_effector))
+              .isApprox(arm.ik_target_pose, 1e-3));
+    CHECK(ceiling.ik_solution.size() == 0);
+
+    // Inputs of the wrong size are reported
+    scene.robot("five").q = Eigen::VectorXd::Zero(3);
+    CHECK_THROWS_AS(scene.update(), std::invalid_argument);
+}
@@ -0,0 +1,87 @@
+#include "../include/selffilter.hpp"
+
+#include "../include/parser.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test parsing of link collision elements", "[SelfFilter]") {
+    auto nugus          = import_urdf<double, 20>("data/urdfs/nugus.urdf");
+    size_t n_collisions = 0;
+    for (const auto& link : nugus.links) {
+        for (const auto& collision : link.collisions) {
+            CHECK(collision.geometry == CollisionGeometry::BOX);
+            CHECK((collision.size.array() > 0).all());
+            ++n_collisions;
+        }
+    }
+    CHECK(n_collisions == 25);
+
+    auto panda = import_urdf<double, 7>("data/urdfs/panda_arm.urdf");
+    REQUIRE(panda.get_link("panda_link1").collisions.size() == 1);
+    CHECK(panda.get_link("panda_link1").collisions[0].geometry == CollisionGeometry::MESH);
+    CHECK(panda.get_link("panda_link1").collisions[0].filename == "meshes/collision/link1.stl");
+}
+
+TEST_CASE("Test self filter of a point cloud against collision primitives", "[SelfFilter]") {
+    const int n_joints = 20;
+    auto robot_model   = import_urdf<double, n_joints>("data/urdfs/nugus.urdf");
+    auto q             = robot_model.random_configuration();
+
+    // Add a sphere and a cylinder so every primitive type is tested
+    Collision<double> sphere;
+    sphere.geometry = CollisionGeometry::SPHERE;
+    sphere.radius   = 0.05;
+    robot_model.links[robot_model.base_link_idx].collisions.push_back(sphere);
+    Collision<double> cylinder;
+    cylinder.geometry             = CollisionGeometry::CYLINDER;
+    cylinder.radius               = 0.03;
+    cylinder.length               = 0.2;
+    cylinder.origin.translation() = Eigen::Vector3d(0.1, 0, 0);
+    robot_model.links[robot_model.base_link_idx].collisions.push_back(cylinder);
+
+    SelfFilterOptions<double> options;
+    options.padding    = 0.01;
+    options.voxel_size = 0.04;
+    options.chunk_size = 64;
+    Eigen::Isometry3d cloud_pose = Eigen::Isometry3d::Identity();
+    cloud_pose.translation()     = Eigen::Vector3d(0.3, -0.2, 0.1);
+    cloud_pose.linear()          = Eigen::AngleAxisd(0.4, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+
+    // Random points around the robot, plus the centre of every primitive
+    const auto primitives = collision_primitives(robot_model, q, options.padding, cloud_pose);
+    REQUIRE(primitives.size() == 27);
+    Eigen::Matrix<double, 3, Eigen::Dynamic> points = Eigen::Matrix<double, 3, Eigen::Dynamic>::Random(3, 20000);
+    for (auto& primitive : primitives) {
+        points.col(&primitive - primitives.data()) = primitive.centre;
+    }
+    points.rightCols(10000) *= 0.5;
+
+    const Eigen::Array<bool, Eigen::Dynamic, 1> on_robot = self_filter(robot_model, q, points, options, cloud_pose);
+    REQUIRE(on_robot.size() == points.cols());
+
+    // Compare against testing every point against every primitive
+    int n_on_robot = 0;
+    for (int i = 0; i < points.cols(); ++i) {
+        bool expected = false;
+        for (const auto& primitive : primitives) {
+            expected = expected || primitive.contains(points.col(i))(0);
+        }
+        CHECK(on_robot(i) == expected);
+        n_on_robot += expected;
+    }
+    CHECK(on_robot.head(primitives.size()).all());
+    CHECK(n_on_robot > int(primitives.size()));
+
+    // The sphere contains points within its padded radius only
+    const auto sphere_it = std::find_if(primitives.begin(), primitives.end(), [](const auto& primitive) {
+        return primitive.geometry == CollisionGeometry::SPHERE;
+    });
+    REQUIRE(sphere_it != primitives.end());
+    const CollisionPrimitive<double>& sphere_primitive = *sphere_it;
+    Eigen::Matrix<double, 3, 2> near_far;
+    near_far.col(0) = sphere_primitive.centre + Eigen::Vector3d(0.059, 0, 0);
+    near_far.col(1) = sphere_primitive.centre + Eigen::Vector3d(0.061, 0, 0);
+    CHECK(sphere_primitive.contains(near_far)(0));
+    CHECK(!sphere_primitive.contains(near_far)(1));
+}
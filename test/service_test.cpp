@@ -0,0 +1,78 @@
+#include <unistd.h>
+
+#include <thread>
+
+#include "../include/dynamics.hpp"
+#include "../include/inversekinematics.hpp"
+#include "../include/kinematics.hpp"
+#include "../include/parser.hpp"
+#include "../include/service.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test batched service requests over a loopback socket for panda model", "[Service]") {
+    const int n_joints = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model   = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    const int target   = robot_model.get_link("panda_link8").idx;
+    const int source   = robot_model.base_link_idx;
+
+    ServiceOptions<double, n_joints> options;
+    options.n_workers                 = 2;
+    options.batch_window              = std::chrono::milliseconds(2);
+    options.ik_options.max_iterations = 1000;
+    options.ik_options.tolerance      = 1e-8;
+    const std::string socket_path     = "/tmp/tinyrobotics_service_test_" + std::to_string(::getpid()) + ".sock";
+    Service<double, n_joints> service(robot_model, options);
+    service.start(socket_path);
+
+    // Concurrent clients, each with its own connection
+    const int n_clients  = 8;
+    const int n_requests = 5;
+    std::vector<std::thread> clients;
+    std::vector<int> failures(n_clients, 0);
+    for (int c = 0; c < n_clients; ++c) {
+        clients.emplace_back([&, c]() {
+            auto model = robot_model;
+            ServiceClient client(socket_path);
+            failures[c] += client.n_q != n_joints;
+            for (int i = 0; i < n_requests; ++i) {
+                Configuration q   = model.random_configuration();
+                Configuration dq  = model.random_configuration();
+                Configuration tau = model.random_configuration();
+                failures[c] += !client.inverse_dynamics(q, dq, tau).isApprox(inverse_dynamics(model, q, dq, tau));
+                failures[c] += !client.forward_dynamics(q, dq, tau).isApprox(forward_dynamics(model, q, dq, tau));
+                failures[c] += !client.mass_matrix(q).isApprox(mass_matrix(model, q));
+                failures[c] += !client.gravity_torque(q).isApprox(gravity_torque(model, q));
+
+                // Inverse kinematics from a nearby initial guess should reach the pose
+                auto H                   = forward_kinematics(model, q, target, source);
+                Eigen::VectorXd q_result = client.inverse_kinematics(target, source, H, q + 0.05 * dq);
+                auto H_result            = forward_kinematics(model, Configuration(q_result), target, source);
+                failures[c] += !H_result.matrix().isApprox(H.matrix(), 1e-4);
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    for (int c = 0; c < n_clients; ++c) {
+        CHECK(failures[c] == 0);
+    }
+
+    ServiceClient client(socket_path);
+    ServiceStatistics statistics = client.statistics();
+    CHECK(statistics[ServiceRequestType::INVERSE_KINEMATICS].count == n_clients * n_requests);
+    CHECK(statistics[ServiceRequestType::INVERSE_DYNAMICS].count == n_clients * n_requests);
+    CHECK(statistics.n_batches > 0);
+    CHECK(statistics.mean_batch_size >= 1);
+
+    // Malformed requests are reported to the client without stopping the service
+    CHECK_THROWS(client.inverse_kinematics(1000, source, Eigen::Isometry3d::Identity(), Eigen::VectorXd::Zero(7)));
+    CHECK_THROWS(client.gravity_torque(Eigen::VectorXd::Zero(3)));
+    CHECK(client.gravity_torque(Eigen::VectorXd::Zero(7)).isApprox(gravity_torque(robot_model, Configuration(Configuration::Zero()))));
+
+    service.stop();
+    CHECK_THROWS(ServiceClient(socket_path));
+}
@@ -0,0 +1,94 @@
+#include "../include/spline.hpp"
+
+#include "../include/parser.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test quintic spline meets the waypoint conditions", "[Spline]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    using Samples       = Eigen::Matrix<double, n_joints, Eigen::Dynamic>;
+    const std::vector<double> times = {0.0, 0.5, 1.5, 2.0};
+    const Samples q                 = Samples::Random(n_joints, 4);
+    const Samples dq                = Samples::Random(n_joints, 4);
+    const Samples ddq               = Samples::Random(n_joints, 4);
+    const auto spline               = JointSpline<double, n_joints>::quintic(times, q, dq, ddq);
+    CHECK(spline.degree() == 5);
+    CHECK(spline.start_time() == 0.0);
+    CHECK(spline.end_time() == 2.0);
+
+    Configuration q_t, dq_t, ddq_t;
+    for (size_t i = 0; i < times.size(); i++) {
+        spline.evaluate(times[i], q_t, dq_t, ddq_t);
+        CHECK(q_t.isApprox(q.col(i)));
+        CHECK(dq_t.isApprox(dq.col(i)));
+        CHECK(ddq_t.isApprox(ddq.col(i)));
+    }
+
+    // The end points are held at rest outside the trajectory
+    spline.evaluate(3.0, q_t, dq_t, ddq_t);
+    CHECK(q_t.isApprox(q.col(3)));
+    CHECK(dq_t.isZero());
+    CHECK(ddq_t.isZero());
+}
+
+TEST_CASE("Test B-spline derivatives and batched evaluation", "[Spline]") {
+    const int n_joints  = 3;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    using Samples       = Eigen::Matrix<double, n_joints, Eigen::Dynamic>;
+    const std::vector<double> knots = {0, 0, 0, 0, 0.3, 0.5, 0.5, 1.2, 2, 2, 2, 2};
+    const JointSpline<double, n_joints> spline(3, knots, Samples::Random(n_joints, 8));
+    CHECK_THROWS(JointSpline<double, n_joints>(3, knots, Samples::Random(n_joints, 7)));
+
+    // Derivatives match central differences
+    const double h = 1e-6;
+    Configuration q_t, dq_t, ddq_t, q_plus, q_minus, dq_plus, dq_minus, unused;
+    for (const double t : {0.1, 0.4, 0.9, 1.7}) {
+        spline.evaluate(t, q_t, dq_t, ddq_t);
+        spline.evaluate(t + h, q_plus, dq_plus, unused);
+        spline.evaluate(t - h, q_minus, dq_minus, unused);
+        CHECK(dq_t.isApprox((q_plus - q_minus) / (2 * h), 1e-6));
+        CHECK(ddq_t.isApprox((dq_plus - dq_minus) / (2 * h), 1e-6));
+    }
+
+    // Batched evaluation matches evaluation at each time, including times outside the knot range
+    std::vector<double> times;
+    for (int i = 0; i <= 240; i++) {
+        times.push_back(-0.2 + 0.01 * i);
+    }
+    Samples q, dq, ddq;
+    spline.evaluate(times, q, dq, ddq);
+    REQUIRE(q.cols() == int(times.size()));
+    for (size_t i = 0; i < times.size(); i++) {
+        spline.evaluate(times[i], q_t, dq_t, ddq_t);
+        CHECK(q.col(i).isApprox(q_t));
+        CHECK(dq.col(i).isApprox(dq_t));
+        CHECK(ddq.col(i).isApprox(ddq_t));
+    }
+}
+
+TEST_CASE("Test feedforward torques along a spline", "[Spline]") {
+    const int n_joints  = 7;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    using Samples       = Eigen::Matrix<double, n_joints, Eigen::Dynamic>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    Samples q(n_joints, 3);
+    q << robot_model.home_configuration(), robot_model.random_configuration(), robot_model.home_configuration();
+    const auto spline = JointSpline<double, n_joints>::quintic({0.0, 1.0, 2.0},
+                                                               q,
+                                                               Samples::Zero(n_joints, 3),
+                                                               Samples::Zero(n_joints, 3));
+    std::vector<double> times;
+    for (int i = 0; i <= 2000; i++) {
+        times.push_back(0.001 * i);
+    }
+    const Samples tau = feedforward_torques(robot_model, spline, times, 4);
+    REQUIRE(tau.cols() == int(times.size()));
+
+    Configuration q_t, dq_t, ddq_t;
+    for (const int i : {0, 250, 1000, 1731, 2000}) {
+        spline.evaluate(times[i], q_t, dq_t, ddq_t);
+        CHECK(tau.col(i).isApprox(inverse_dynamics(robot_model, q_t, dq_t, ddq_t)));
+    }
+}
@@ -0,0 +1,65 @@
+#include "../include/taskspace.hpp"
+
+#include "../include/kinematics.hpp"
+#include "../include/parser.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test stacked task projectors against the naive construction for nugus", "[TaskSpace]") {
+    const int n_joints  = 20;
+    using Matrix        = Eigen::Matrix<double, n_joints, n_joints>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/nugus.urdf");
+    const Matrix I      = Matrix::Identity();
+    TaskProjector<double, n_joints> projector(robot_model);
+    std::vector<Task<double, n_joints>> tasks(4);
+
+    for (int trial = 0; trial < 10; trial++) {
+        auto q = robot_model.random_configuration();
+        tasks[0].jacobian = jacobian(robot_model, q, std::string("left_foot_base"));
+        tasks[1].jacobian = jacobian(robot_model, q, std::string("right_foot_base"));
+        tasks[2].jacobian = jacobian(robot_model, q, std::string("left_lower_arm")).bottomRows(3);
+        tasks[3].jacobian = jacobian(robot_model, q, std::string("right_lower_arm")).bottomRows(3);
+        projector.update(q);
+        projector.project(tasks);
+
+        // Naive construction with an explicit inverse of the mass matrix and products of projectors
+        const Matrix Minv = mass_matrix(robot_model, q).inverse();
+        Matrix N          = I;
+        for (size_t k = 0; k < tasks.size(); k++) {
+            const Eigen::MatrixXd Jp     = tasks[k].jacobian * N;
+            const Eigen::MatrixXd Lambda = (Jp * Minv * Jp.transpose()).inverse();
+            const Eigen::MatrixXd Jbar   = Minv * Jp.transpose() * Lambda;
+            N                            = N * (I - Jbar * Jp);
+            CHECK(tasks[k].projected_jacobian.isApprox(Jp, 1e-8));
+            CHECK(tasks[k].inertia.isApprox(Lambda, 1e-6));
+            CHECK(tasks[k].inverse.isApprox(Jbar, 1e-6));
+            CHECK((tasks[k].nullspace - N).norm() < 1e-8);
+
+            // Each projector is idempotent, dynamically consistent and annihilates every higher priority task
+            const Matrix& Nk = tasks[k].nullspace;
+            CHECK((Nk * Nk - Nk).norm() < 1e-8);
+            CHECK((Nk * Minv - Minv * Nk.transpose()).norm() < 1e-8 * Minv.norm());
+            for (size_t j = 0; j <= k; j++) {
+                CHECK((tasks[j].jacobian * Nk).norm() < 1e-8);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test task projector with a rank deficient task", "[TaskSpace]") {
+    const int n_joints = 20;
+    auto robot_model   = import_urdf<double, n_joints>("data/urdfs/nugus.urdf");
+    auto q             = robot_model.random_configuration();
+    TaskProjector<double, n_joints> projector(robot_model);
+    projector.update(q);
+
+    // The head orientation has three rows but only the neck yaw and head pitch joints
+    Task<double, n_joints> head(jacobian(robot_model, q, std::string("head")).bottomRows(3));
+    projector.project(head);
+    CHECK(head.inverse.allFinite());
+    const Eigen::Matrix3d P = head.jacobian * head.inverse;
+    CHECK((P * P - P).norm() < 1e-8);
+    CHECK(std::abs(P.trace() - 2) < 1e-8);
+    CHECK((head.jacobian * head.nullspace).norm() < 1e-8);
+}
@@ -0,0 +1,54 @@
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "../include/dynamics.hpp"
+#include "../include/parser.hpp"
+#include "../include/trace.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test trace spans are recorded per thread and exported", "[Trace]") {
+    TraceRegistry::instance().clear();
+    {
+        TraceSpan span("outer");
+        TraceSpan inner("inner");
+    }
+    std::thread([] { TraceSpan span("worker"); }).join();
+
+    // Spans are kept per thread, including threads which have exited
+    size_t n_events = 0;
+    for (const auto& buffer : TraceRegistry::instance().buffers()) {
+        for (const TraceEvent& event : buffer->snapshot()) {
+            CHECK(event.duration_ns >= 0);
+            ++n_events;
+        }
+    }
+    CHECK(n_events == 3);
+
+    const std::string path = "/tmp/tinyrobotics_trace_" + std::to_string(getpid()) + ".json";
+    write_chrome_trace(path);
+    std::ifstream file(path);
+    const std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    CHECK(json.find("\"traceEvents\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"inner\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"worker\"") != std::string::npos);
+    CHECK(json.find("\"ph\":\"X\"") != std::string::npos);
+
+    // Algorithm phases only record spans when tracing is compiled in
+    TraceRegistry::instance().clear();
+    auto robot_model = import_urdf<double, 7>("data/urdfs/panda_arm.urdf");
+    auto q           = robot_model.random_configuration();
+    forward_dynamics(robot_model, q, q, q);
+    const std::string aba_json = chrome_trace_json();
+#ifdef TR_ENABLE_TRACING
+    CHECK(aba_json.find("forward_dynamics backward pass") != std::string::npos);
+#else
+    CHECK(aba_json.find("forward_dynamics") == std::string::npos);
+#endif
+}
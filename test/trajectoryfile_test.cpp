@@ -0,0 +1,71 @@
+#include <unistd.h>
+
+#include <cstdio>
+
+#include "../include/dynamics.hpp"
+#include "../include/kinematics.hpp"
+#include "../include/parser.hpp"
+#include "../include/trajectoryfile.hpp"
+#include "catch2/catch.hpp"
+
+using namespace tinyrobotics;
+
+TEST_CASE("Test applying algorithms over a memory-mapped trajectory file for panda model", "[TrajectoryFile]") {
+    const int n_joints  = 7;
+    const int n_samples = 1000;
+    using Configuration = Eigen::Matrix<double, n_joints, 1>;
+    auto robot_model    = import_urdf<double, n_joints>("data/urdfs/panda_arm.urdf");
+    const std::string path = "/tmp/tinyrobotics_trajectory_test_" + std::to_string(::getpid()) + ".trj";
+
+    // Record a trajectory
+    {
+        auto file = TrajectoryFile::create(path, model_hash(robot_model), n_joints, 1000.0, n_samples);
+        file.add_column("q", n_joints);
+        file.add_column("dq", n_joints);
+        file.add_column("ddq", n_joints);
+        for (const auto& name : {"q", "dq", "ddq"}) {
+            auto column = file.mutable_column(name);
+            for (int i = 0; i < n_samples; ++i) {
+                column.row(i) = robot_model.random_configuration().transpose();
+            }
+        }
+        file.sync();
+    }
+
+    // Derive columns in place
+    {
+        auto file = TrajectoryFile::open(path, true);
+        apply_inverse_dynamics(file, robot_model, "q", "dq", "ddq", "tau", 3);
+        apply_center_of_mass(file, robot_model, "q", "com", 3);
+        apply_forward_kinematics(file, robot_model, std::string("panda_link8"), robot_model.base_link_idx, "q", "H", 3);
+    }
+
+    // Check the derived columns against the algorithms
+    const auto file = TrajectoryFile::open(path);
+    CHECK(file.n_samples() == n_samples);
+    CHECK(file.n_q() == n_joints);
+    CHECK(file.rate() == 1000.0);
+    CHECK(file.column_names() == std::vector<std::string>{"q", "dq", "ddq", "tau", "com", "H"});
+    const auto q   = file.column("q");
+    const auto dq  = file.column("dq");
+    const auto ddq = file.column("ddq");
+    const auto tau = file.column("tau");
+    const auto com = file.column("com");
+    const auto H   = file.column("H");
+    for (int i = 0; i < n_samples; i += 37) {
+        Configuration qi   = q.row(i).transpose();
+        Configuration dqi  = dq.row(i).transpose();
+        Configuration ddqi = ddq.row(i).transpose();
+        CHECK(tau.row(i).transpose().isApprox(inverse_dynamics(robot_model, qi, dqi, ddqi)));
+        CHECK(com.row(i).transpose().isApprox(center_of_mass(robot_model, qi)));
+        Eigen::Matrix<double, 4, 4, Eigen::RowMajor> Hi(H.row(i).data());
+        CHECK(Hi.isApprox(forward_kinematics(robot_model, qi, std::string("panda_link8")).matrix()));
+    }
+
+    // Files recorded with another model are rejected
+    auto other_model = robot_model;
+    other_model.links.back().mass += 1.0;
+    auto writable_file = TrajectoryFile::open(path, true);
+    CHECK_THROWS(apply_center_of_mass(writable_file, other_model));
+    std::remove(path.c_str());
+}